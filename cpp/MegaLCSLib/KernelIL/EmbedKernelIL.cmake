@@ -0,0 +1,27 @@
+# 把每个step的SPIR-V文件转换成C++字节数组，生成Mega::GetEmbeddedKernelIL
+# 参数：-DSTEPS=16,32,... -DINPUT_DIR=<spv目录> -DOUTPUT=<生成的cpp>
+
+string(REPLACE "," ";" STEPS "${STEPS}")
+
+set(content "// 由EmbedKernelIL.cmake生成，请勿手工修改\n\n#include \"Mega.h\"\n\n")
+set(cases "")
+
+foreach (step ${STEPS})
+    file(READ "${INPUT_DIR}/KernelLCS_Shared_${step}.spv" hex HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+    # CMake正则不支持{n}，每行16个字节
+    string(REPEAT "0x[0-9a-f][0-9a-f]," 16 lineBytes)
+    string(REGEX REPLACE "(${lineBytes})" "\\1\n        " bytes "${bytes}")
+    string(APPEND content "static const unsigned char KernelLCS_Shared_IL_${step}[] = {\n        ${bytes}\n};\n\n")
+    string(APPEND cases "        case ${step}:\n")
+    string(APPEND cases "            *data = KernelLCS_Shared_IL_${step};\n")
+    string(APPEND cases "            *size = sizeof(KernelLCS_Shared_IL_${step});\n")
+    string(APPEND cases "            return true;\n")
+endforeach ()
+
+string(APPEND content "bool Mega::GetEmbeddedKernelIL(\n        int _step,\n        const unsigned char **data,\n        size_t *size) {\n")
+string(APPEND content "    switch (_step) {\n${cases}        default:\n            *data = nullptr;\n            *size = 0;\n            return false;\n    }\n}\n")
+
+file(WRITE "${OUTPUT}.tmp" "${content}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// 构建期工具：把KernelLCS_Shared按指定step展开成.cl文件，供clang/llvm-spirv离线编译
+// 用法：MegaLCSKernelDump <step> <output.cl>
+
+#include "Mega.h"
+#include <fstream>
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        cerr << "usage: MegaLCSKernelDump <step> <output.cl>" << endl;
+        return 1;
+    }
+
+    int step = atoi(argv[1]);
+    if (!(1 <= step && step <= 256)) {
+        cerr << "step is invalid." << endl;
+        return 1;
+    }
+
+    // 和Mega::CreateProgram完全一样的替换规则
+    string code = Mega::KernelLCS_Shared;
+    string stepStr = to_string(step);
+    size_t pos = 0;
+    while ((pos = code.find("__STEP__", pos)) != string::npos) {
+        code.replace(pos, 8, stepStr);
+        pos += stepStr.length();
+    }
+
+    // 内嵌的SPIR-V只用于int元素
+    pos = 0;
+    while ((pos = code.find("__ELEMENT__", pos)) != string::npos) {
+        code.replace(pos, 11, "int");
+        pos += 3;
+    }
+
+    ofstream out(argv[2], ios::binary | ios::trunc);
+    if (!out) {
+        cerr << "Failed to open " << argv[2] << endl;
+        return 1;
+    }
+
+    out << code;
+    return out ? 0 : 1;
+}
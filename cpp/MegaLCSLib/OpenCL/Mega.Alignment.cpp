@@ -0,0 +1,209 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <future>
+#include <thread>
+
+/*
+Hirschberg分治求LCS的对齐
+base的区间在mid处一分为二：
+上半部分正向算一次，horWeights[j]就是上半部分和latest前j+1个元素的LCS长度
+下半部分把两个序列都倒过来再算一次，horWeights[j]就是下半部分和latest后j+1个元素的LCS长度
+两者之和最大的位置k就是最优路径穿过mid行的位置，两个子问题互相独立，可以并行递归
+子问题小到一定程度后用完整的DP矩阵回溯
+每层的计算量是上一层的一半，总时间约为只求长度的2倍，内存只有边界权重O(m+n)和叶子的DP矩阵
+
+分割的两次计算必须是精确DP：MinMax在小字母表上会多算，分割点选错后叶子的回溯拼起来不是最长的
+step是32的倍数时在设备上用位并行内核（只对这一次计算，不改变默认引擎的设置），否则用CpuLCS_BitParallel
+ */
+
+// 叶子的DP矩阵不超过这么多个单元（64K个int，256KB）
+static const long long AlignmentLeafCells = 1 << 16;
+
+// 递归的前几层并行展开，之后串行
+static int AlignmentParallelDepth() {
+    int threads = max(1, (int) thread::hardware_concurrency());
+    int depth = 0;
+    while ((1 << depth) < threads) {
+        depth++;
+    }
+    return depth;
+}
+
+// 经典DP矩阵的回溯，结果追加到pairs，下标加上区间的起点
+static void AlignLeaf(const int *bases, int baseLength, int baseOffset,
+                      const int *latests, int latestLength, int latestOffset,
+                      vector<pair<int, int>> &pairs) {
+    // 只有一行或一列时直接找第一个相同的元素
+    if (baseLength == 1 || latestLength == 1) {
+        for (int b = 0; b < baseLength; b++) {
+            for (int l = 0; l < latestLength; l++) {
+                if (bases[b] == latests[l]) {
+                    pairs.emplace_back(baseOffset + b, latestOffset + l);
+                    return;
+                }
+            }
+        }
+        return;
+    }
+
+    int width = latestLength + 1;
+    vector<int> dp((size_t) (baseLength + 1) * width, 0);
+    for (int i = 1; i <= baseLength; i++) {
+        for (int j = 1; j <= latestLength; j++) {
+            dp[(size_t) i * width + j] = bases[i - 1] == latests[j - 1]
+                                         ? dp[(size_t) (i - 1) * width + j - 1] + 1
+                                         : max(dp[(size_t) (i - 1) * width + j], dp[(size_t) i * width + j - 1]);
+        }
+    }
+
+    size_t begin = pairs.size();
+    int i = baseLength;
+    int j = latestLength;
+    while (i > 0 && j > 0) {
+        if (bases[i - 1] == latests[j - 1]) {
+            pairs.emplace_back(baseOffset + i - 1, latestOffset + j - 1);
+            i--;
+            j--;
+        } else if (dp[(size_t) (i - 1) * width + j] >= dp[(size_t) i * width + j - 1]) {
+            i--;
+        } else {
+            j--;
+        }
+    }
+    reverse(pairs.begin() + begin, pairs.end());
+}
+
+// 分割用的精确horWeights，边界全为0
+static vector<int> ExactHors(cl_platform_id platformId, cl_device_id deviceId,
+                             vector<int> &bases, vector<int> &latests, int step) {
+    vector<int> verWeights(bases.size(), 0);
+    vector<int> horWeights(latests.size(), 0);
+
+    if (platformId != nullptr && deviceId != nullptr && step % 32 == 0 &&
+        bases.size() > (size_t) step && latests.size() > (size_t) step) {
+        auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+        if (engine->IsReady() &&
+            engine->TryHostLCS_WaveFront(bases, latests, verWeights, horWeights, step,
+                                         MegaLCSKernelVariant::BitParallel)) {
+            return horWeights;
+        }
+    }
+
+    Mega::CpuLCS_BitParallel(bases.data(), bases.size(),
+                             latests.data(), latests.size(),
+                             verWeights.data(), verWeights.size(),
+                             horWeights.data(), horWeights.size());
+    return horWeights;
+}
+
+static void AlignRange(cl_platform_id platformId, cl_device_id deviceId,
+                       const vector<int> &baseVals, int baseBegin, int baseEnd,
+                       const vector<int> &latestVals, int latestBegin, int latestEnd,
+                       int step, int parallelDepth,
+                       vector<pair<int, int>> &pairs) {
+    int baseLength = baseEnd - baseBegin;
+    int latestLength = latestEnd - latestBegin;
+    if (baseLength == 0 || latestLength == 0) {
+        return;
+    }
+
+    if (baseLength == 1 || latestLength == 1 || (long long) baseLength * latestLength <= AlignmentLeafCells) {
+        AlignLeaf(baseVals.data() + baseBegin, baseLength, baseBegin,
+                  latestVals.data() + latestBegin, latestLength, latestBegin,
+                  pairs);
+        return;
+    }
+
+    int baseMid = baseBegin + baseLength / 2;
+
+    vector<int> latestRange(latestVals.begin() + latestBegin, latestVals.begin() + latestEnd);
+    vector<int> baseTop(baseVals.begin() + baseBegin, baseVals.begin() + baseMid);
+    vector<int> forwardHors = ExactHors(platformId, deviceId, baseTop, latestRange, step);
+
+    vector<int> baseBottom(baseVals.rbegin() + (baseVals.size() - baseEnd),
+                           baseVals.rbegin() + (baseVals.size() - baseMid));
+    reverse(latestRange.begin(), latestRange.end());
+    vector<int> backwardHors = ExactHors(platformId, deviceId, baseBottom, latestRange, step);
+
+    // latest的前k个元素分给上半部分，后latestLength-k个分给下半部分
+    int bestSplit = 0;
+    int bestWeight = -1;
+    for (int k = 0; k <= latestLength; k++) {
+        int forwardWeight = k == 0 ? 0 : forwardHors[k - 1];
+        int backwardWeight = k == latestLength ? 0 : backwardHors[latestLength - k - 1];
+        if (forwardWeight + backwardWeight > bestWeight) {
+            bestWeight = forwardWeight + backwardWeight;
+            bestSplit = k;
+        }
+    }
+    int latestMid = latestBegin + bestSplit;
+
+    // 释放边界权重后再递归，保证每层只占O(m+n)
+    vector<int>().swap(forwardHors);
+    vector<int>().swap(backwardHors);
+    vector<int>().swap(latestRange);
+
+    if (parallelDepth > 0) {
+        vector<pair<int, int>> topPairs;
+        auto topTask = async(launch::async, [&] {
+            AlignRange(platformId, deviceId, baseVals, baseBegin, baseMid, latestVals, latestBegin, latestMid,
+                       step, parallelDepth - 1, topPairs);
+        });
+
+        vector<pair<int, int>> bottomPairs;
+        AlignRange(platformId, deviceId, baseVals, baseMid, baseEnd, latestVals, latestMid, latestEnd,
+                   step, parallelDepth - 1, bottomPairs);
+        topTask.get();
+
+        pairs.insert(pairs.end(), topPairs.begin(), topPairs.end());
+        pairs.insert(pairs.end(), bottomPairs.begin(), bottomPairs.end());
+        return;
+    }
+
+    AlignRange(platformId, deviceId, baseVals, baseBegin, baseMid, latestVals, latestBegin, latestMid,
+               step, 0, pairs);
+    AlignRange(platformId, deviceId, baseVals, baseMid, baseEnd, latestVals, latestMid, latestEnd,
+               step, 0, pairs);
+}
+
+vector<pair<int, int>> Mega::MegaLCS_Alignment(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        const vector<int> &baseVals,
+        const vector<int> &latestVals,
+        int step) {
+
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+
+    vector<pair<int, int>> pairs;
+    AlignRange(platformId, deviceId,
+               baseVals, 0, baseVals.size(),
+               latestVals, 0, latestVals.size(),
+               step, AlignmentParallelDepth(), pairs);
+    return pairs;
+}
+
+vector<pair<int, int>> Mega::MegaLCSAlign(const vector<int> &baseVals, const vector<int> &latestVals) {
+    // 和MegaLCSLen相同的step
+    auto gpuDevice = GetDefaultGpuDevice();
+    int step = GetDefaultStep(gpuDevice.first, gpuDevice.second);
+    return MegaLCS_Alignment(gpuDevice.first, gpuDevice.second, baseVals, latestVals, step);
+}
@@ -0,0 +1,232 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+/*
+锚点拆分的预处理
+实际的文件diff大部分内容相同，直接跑完整的m*n wavefront很浪费：
+1. 裁掉公共前缀和后缀（SIMD比较），对LCS是精确的：公共前缀/后缀总可以放进某个最长公共子序列
+2. 两边都只出现一次的元素作为候选锚点，按base位置排序后对latest位置求最长递增子序列（patience diff）
+3. 锚点把剩下的问题切成互不相关的空隙，空隙再各自裁剪前后缀，并行交给MegaLCS_Fusion（设备或CPU）
+长度=前缀+后缀+锚点数+各空隙的长度
+第2步是启发式的：强制匹配锚点可能错过更长的公共子序列，所以用到锚点时结果标记为近似
+空隙的计算也要精确：MinMax（设备上的共享内存类内核、CPU的MinMax/MinMaxSimd）在小字母表上会多算，
+只有位并行（CPU的BitParallel引擎，或设备上step是32倍数的位并行内核）是精确DP
+没有找到锚点（或关闭锚点）并且每个空隙都是裁剪或精确引擎算出来的，结果才标记为精确
+ */
+
+// 下标区间[begin, end)
+struct AnchoredGap {
+    int baseBegin;
+    int baseEnd;
+    int latestBegin;
+    int latestEnd;
+};
+
+// 两边都只出现一次的元素的位置对，按base位置递增，再取latest位置的最长递增子序列
+static vector<pair<int, int>> FindUniqueAnchors(const vector<int> &baseVals, int baseBegin, int baseEnd,
+                                                const vector<int> &latestVals, int latestBegin, int latestEnd) {
+    // value -> (base出现次数, base位置, latest出现次数, latest位置)
+    unordered_map<int, array<int, 4>> occurrences;
+    for (int b = baseBegin; b < baseEnd; b++) {
+        auto &entry = occurrences.try_emplace(baseVals[b], array<int, 4>{0, 0, 0, 0}).first->second;
+        entry[0]++;
+        entry[1] = b;
+    }
+    for (int l = latestBegin; l < latestEnd; l++) {
+        auto it = occurrences.find(latestVals[l]);
+        if (it != occurrences.end()) {
+            it->second[2]++;
+            it->second[3] = l;
+        }
+    }
+
+    vector<pair<int, int>> candidates;
+    for (const auto &entry: occurrences) {
+        if (entry.second[0] == 1 && entry.second[2] == 1) {
+            candidates.emplace_back(entry.second[1], entry.second[3]);
+        }
+    }
+    sort(candidates.begin(), candidates.end());
+
+    // patience sorting：tails[k]是长度为k+1的递增子序列的最小结尾（candidates下标）
+    vector<int> tails;
+    vector<int> previous(candidates.size(), -1);
+    for (int c = 0; c < (int) candidates.size(); c++) {
+        auto it = lower_bound(tails.begin(), tails.end(), candidates[c].second,
+                              [&](int t, int latest) { return candidates[t].second < latest; });
+        if (it != tails.begin()) {
+            previous[c] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.push_back(c);
+        } else {
+            *it = c;
+        }
+    }
+
+    vector<pair<int, int>> anchors;
+    for (int c = tails.empty() ? -1 : tails.back(); c >= 0; c = previous[c]) {
+        anchors.push_back(candidates[c]);
+    }
+    reverse(anchors.begin(), anchors.end());
+    return anchors;
+}
+
+// 空隙先裁剪自己的前后缀，剩下的部分交给Fusion，返回(长度, 是否精确)
+// cpuThreads是这个空隙可以使用的CPU线程数，外层已经有多个线程在并行计算空隙
+static pair<int, bool> GapLength(cl_platform_id platformId, cl_device_id deviceId,
+                                 const vector<int> &baseVals, const vector<int> &latestVals,
+                                 AnchoredGap gap, int step, MegaLCSCpuEngine cpuEngine, int cpuThreads) {
+    int baseLength = gap.baseEnd - gap.baseBegin;
+    int latestLength = gap.latestEnd - gap.latestBegin;
+    if (baseLength == 0 || latestLength == 0) {
+        return make_pair(0, true);
+    }
+
+    int prefix = Mega::CommonPrefixLength(baseVals.data() + gap.baseBegin, latestVals.data() + gap.latestBegin,
+                                          min(baseLength, latestLength));
+    int suffix = Mega::CommonSuffixLength(baseVals.data() + gap.baseEnd, latestVals.data() + gap.latestEnd,
+                                          min(baseLength, latestLength) - prefix);
+    if (prefix + suffix == baseLength || prefix + suffix == latestLength) {
+        return make_pair(prefix + suffix, true);
+    }
+
+    vector<int> gapBase(baseVals.begin() + gap.baseBegin + prefix, baseVals.begin() + gap.baseEnd - suffix);
+    vector<int> gapLatest(latestVals.begin() + gap.latestBegin + prefix, latestVals.begin() + gap.latestEnd - suffix);
+
+    // 没有设备时Fusion用占满所有核心的CpuLCS_WaveFront计算MinMax类引擎，和外层的线程相乘会严重超额
+    // 这里直接按分到的线程数调用，结果和Fusion相同
+    if ((platformId == nullptr || deviceId == nullptr) && cpuEngine != MegaLCSCpuEngine::BitParallel &&
+        gapBase.size() > (size_t) step && gapLatest.size() > (size_t) step) {
+        vector<int> verWeights(gapBase.size(), 0);
+        vector<int> horWeights(gapLatest.size(), 0);
+        Mega::CpuLCS_WaveFront(gapBase.data(), gapBase.size(),
+                               gapLatest.data(), gapLatest.size(),
+                               verWeights.data(), verWeights.size(),
+                               horWeights.data(), horWeights.size(),
+                               step, cpuThreads);
+        return make_pair(prefix + suffix + horWeights.back(), false);
+    }
+
+    auto result = Mega::MegaLCS_Fusion(platformId, deviceId, gapBase, gapLatest, step, false, cpuEngine);
+
+    // CPU上只有位并行引擎是精确的；设备上位并行内核要求step是32的倍数，否则内核回退到共享内存版本
+    bool isExact = get<0>(result)
+                   ? cpuEngine == MegaLCSCpuEngine::BitParallel
+                   : step % 32 == 0 &&
+                     MegaLCSEngine::GetDefault(platformId, deviceId)->GetKernelVariant() ==
+                     MegaLCSKernelVariant::BitParallel;
+    return make_pair(prefix + suffix + get<2>(result).back(), isExact);
+}
+
+pair<int, bool> Mega::MegaLCS_Anchored(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        const vector<int> &baseVals,
+        const vector<int> &latestVals,
+        int step,
+        bool useAnchors,
+        MegaLCSCpuEngine cpuEngine) {
+
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+
+    int baseLength = baseVals.size();
+    int latestLength = latestVals.size();
+
+    // 公共前缀和后缀
+    int prefix = CommonPrefixLength(baseVals.data(), latestVals.data(), min(baseLength, latestLength));
+    int suffix = CommonSuffixLength(baseVals.data() + baseLength, latestVals.data() + latestLength,
+                                    min(baseLength, latestLength) - prefix);
+
+    AnchoredGap middle{prefix, baseLength - suffix, prefix, latestLength - suffix};
+    if (middle.baseBegin == middle.baseEnd || middle.latestBegin == middle.latestEnd) {
+        return make_pair(prefix + suffix, true);
+    }
+
+    vector<pair<int, int>> anchors;
+    if (useAnchors) {
+        anchors = FindUniqueAnchors(baseVals, middle.baseBegin, middle.baseEnd,
+                                    latestVals, middle.latestBegin, middle.latestEnd);
+    }
+
+    // 锚点之间（以及两端）的空隙
+    vector<AnchoredGap> gaps;
+    int baseBegin = middle.baseBegin;
+    int latestBegin = middle.latestBegin;
+    for (const auto &anchor: anchors) {
+        gaps.push_back(AnchoredGap{baseBegin, anchor.first, latestBegin, anchor.second});
+        baseBegin = anchor.first + 1;
+        latestBegin = anchor.second + 1;
+    }
+    gaps.push_back(AnchoredGap{baseBegin, middle.baseEnd, latestBegin, middle.latestEnd});
+
+    // 空隙互不相关，多个线程按顺序领取
+    // 每个线程各自保存异常，出错后不再领取新的空隙，全部结束后在调用线程重新抛出
+    // 每个空隙内部的CPU wavefront平分剩下的核心，总线程数不超过核心数
+    int coreCount = max(1, (int) thread::hardware_concurrency());
+    int threadCount = min((int) gaps.size(), coreCount);
+    int gapThreads = max(1, coreCount / threadCount);
+    vector<pair<int, bool>> gapLengths(gaps.size(), make_pair(0, true));
+    vector<exception_ptr> errors(threadCount);
+    atomic<int> nextGap(0);
+    auto worker = [&](int t) {
+        try {
+            for (int g = nextGap.fetch_add(1); g < (int) gaps.size(); g = nextGap.fetch_add(1)) {
+                gapLengths[g] = GapLength(platformId, deviceId, baseVals, latestVals, gaps[g], step, cpuEngine,
+                                          gapThreads);
+            }
+        } catch (...) {
+            errors[t] = current_exception();
+            nextGap = (int) gaps.size();
+        }
+    };
+
+    vector<thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &th: threads) {
+        th.join();
+    }
+
+    for (auto &error: errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    int length = prefix + suffix + (int) anchors.size();
+    bool isExact = anchors.empty();
+    for (const auto &gapLength: gapLengths) {
+        length += gapLength.first;
+        isExact = isExact && gapLength.second;
+    }
+
+    return make_pair(length, isExact);
+}
@@ -0,0 +1,413 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "Mega.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+
+/*
+批量计算很多对互不相关的小序列（每一对的LCS长度）
+逐对调用MegaLCS_Fusion时每一对都要单独上传、启动内核、同步，一对只有几个tile时设备几乎是空闲的
+这里把所有对打包成一块连续的内存只上传一次，启动一次KernelLCS_Batch，
+常驻的block循环领取下一对，一对由一个block独占，结果按对写回gLengths
+ */
+
+// 每个计算单元常驻的block个数，和常驻内核一样只是为了隐藏延迟，一对多接口也使用
+static const int BatchBlocksPerComputeUnit = 8;
+
+// 一对的tile数不超过这个值时，一个block独占它总是划算的
+static const long long BatchMaxTilesPerPair = 1024;
+
+// offsets必须从0开始、单调不减、最后一个等于values的长度，两边的对数相同
+static void ValidBatch(const MegaLCSBatch &batch, int step) {
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+
+    auto validOffsets = [](const vector<int> &offsets, size_t valuesLength) {
+        if (offsets.empty() || offsets.front() != 0 || (size_t) offsets.back() != valuesLength) {
+            return false;
+        }
+        return is_sorted(offsets.begin(), offsets.end());
+    };
+
+    if (!validOffsets(batch.baseOffsets, batch.baseVals.size()) ||
+        !validOffsets(batch.latestOffsets, batch.latestVals.size()) ||
+        batch.baseOffsets.size() != batch.latestOffsets.size()) {
+        throw invalid_argument("batch offsets are invalid.");
+    }
+}
+
+MegaLCSBatch Mega::PackBatch(const vector<pair<vector<int>, vector<int>>> &pairs) {
+    MegaLCSBatch batch;
+
+    size_t baseTotal = 0;
+    size_t latestTotal = 0;
+    for (const auto &p: pairs) {
+        baseTotal += p.first.size();
+        latestTotal += p.second.size();
+    }
+    if (baseTotal > (size_t) INT_MAX || latestTotal > (size_t) INT_MAX) {
+        throw invalid_argument("batch is too large.");
+    }
+
+    batch.baseVals.reserve(baseTotal);
+    batch.latestVals.reserve(latestTotal);
+    batch.baseOffsets.reserve(pairs.size() + 1);
+    batch.latestOffsets.reserve(pairs.size() + 1);
+    for (const auto &p: pairs) {
+        batch.baseVals.insert(batch.baseVals.end(), p.first.begin(), p.first.end());
+        batch.latestVals.insert(batch.latestVals.end(), p.second.begin(), p.second.end());
+        batch.baseOffsets.push_back((int) batch.baseVals.size());
+        batch.latestOffsets.push_back((int) batch.latestVals.size());
+    }
+
+    return batch;
+}
+
+bool MegaLCSEngine::HostLCS_Batch(
+        const MegaLCSBatch &batch,
+        int step,
+        bool withWeights,
+        MegaLCSBatchResult &result) {
+
+    ValidBatch(batch, step);
+
+    int pairCount = (int) batch.baseOffsets.size() - 1;
+    result.processByCpu = false;
+    result.lengths.assign(pairCount, 0);
+    result.verWeights.clear();
+    result.horWeights.clear();
+    if (withWeights) {
+        result.verWeights.assign(batch.baseVals.size(), 0);
+        result.horWeights.assign(batch.latestVals.size(), 0);
+    }
+    if (pairCount == 0) {
+        return true;
+    }
+
+    // 按单元数从大到小领取，最后剩下的都是小的对，各个block差不多同时结束
+    vector<int> order(pairCount);
+    iota(order.begin(), order.end(), 0);
+    auto cells = [&](int p) {
+        return (long long) (batch.baseOffsets[p + 1] - batch.baseOffsets[p]) *
+               (batch.latestOffsets[p + 1] - batch.latestOffsets[p]);
+    };
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return cells(a) > cells(b); });
+
+    lock_guard<mutex> lock(engineMutex);
+
+    cl_kernel kernel = GetKernel(MegaLCSKernelVariant::Shared, true, 0, step, step, false, MegaLCSElementType::Int32, false,
+                                 Mega::PairLayout::Batch);
+    if (kernel == nullptr) {
+        cerr << "Failed to create batch kernel." << endl;
+        return false;
+    }
+
+    // 0 bases, 1 latests, 2 vers, 3 hors, 4 baseOffsets, 5 latestOffsets, 6 order, 7 nextPair, 8 lengths
+    cl_mem memObjects[9] = {};
+    auto releaseMemObjects = [&] {
+        for (auto &memObject: memObjects) {
+            if (memObject != nullptr) {
+                clReleaseMemObject(memObject);
+                memObject = nullptr;
+            }
+        }
+    };
+
+    // 全部是空序列时values为空，OpenCL不允许0字节的缓冲区，至少分配一个int
+    vector<int> zeros(max({batch.baseVals.size(), batch.latestVals.size(), (size_t) pairCount, (size_t) 1}), 0);
+    auto createBuffer = [&](cl_mem_flags flags, const vector<int> &values, cl_int &err) {
+        const int *data = values.empty() ? zeros.data() : values.data();
+        size_t length = max(values.size(), (size_t) 1);
+        return clCreateBuffer(context, flags | CL_MEM_COPY_HOST_PTR, length * sizeof(int), (void *) data, &err);
+    };
+    auto createZeros = [&](size_t length, cl_int &err) {
+        return clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                              max(length, (size_t) 1) * sizeof(int), zeros.data(), &err);
+    };
+
+    cl_int errs[9];
+    memObjects[0] = createBuffer(CL_MEM_READ_ONLY, batch.baseVals, errs[0]);
+    memObjects[1] = createBuffer(CL_MEM_READ_ONLY, batch.latestVals, errs[1]);
+    memObjects[2] = createZeros(batch.baseVals.size(), errs[2]);
+    memObjects[3] = createZeros(batch.latestVals.size(), errs[3]);
+    memObjects[4] = createBuffer(CL_MEM_READ_ONLY, batch.baseOffsets, errs[4]);
+    memObjects[5] = createBuffer(CL_MEM_READ_ONLY, batch.latestOffsets, errs[5]);
+    memObjects[6] = createBuffer(CL_MEM_READ_ONLY, order, errs[6]);
+    memObjects[7] = createZeros(1, errs[7]);
+    memObjects[8] = createZeros(pairCount, errs[8]);
+
+    for (cl_int err: errs) {
+        if (err != CL_SUCCESS) {
+            cerr << "Error creating batch memory objects." << endl;
+            releaseMemObjects();
+            return false;
+        }
+    }
+
+    cl_int err = CL_SUCCESS;
+    for (int i = 0; i < 7; i++) {
+        err |= clSetKernelArg(kernel, i, sizeof(cl_mem), &memObjects[i]);
+    }
+    err |= clSetKernelArg(kernel, 7, sizeof(int), &pairCount);
+    err |= clSetKernelArg(kernel, 8, sizeof(cl_mem), &memObjects[7]);
+    err |= clSetKernelArg(kernel, 9, sizeof(cl_mem), &memObjects[8]);
+    if (err != CL_SUCCESS) {
+        cerr << "Error setting kernel arguments." << endl;
+        releaseMemObjects();
+        return false;
+    }
+
+    // 常驻的block个数不超过对数
+    size_t totalBlock = min((size_t) pairCount, Mega::ResidentPairBlocks(deviceId));
+
+    size_t localWorkSize_ThreadPerBlock[] = {(size_t) step};
+    size_t globalWorkSize_AllThreadInOneGrid[] = {totalBlock * step};
+
+    err = clEnqueueNDRangeKernel(
+            commandQueue,
+            kernel,
+            1,
+            nullptr,
+            globalWorkSize_AllThreadInOneGrid,
+            localWorkSize_ThreadPerBlock,
+            0,
+            nullptr,
+            nullptr);
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error queuing batch kernel for execution." << endl;
+        releaseMemObjects();
+        return false;
+    }
+
+    // in-order队列，最后一次读是阻塞的，前面的读不需要单独同步
+    err = clEnqueueReadBuffer(commandQueue, memObjects[8], CL_FALSE, 0, pairCount * sizeof(int),
+                              result.lengths.data(), 0, nullptr, nullptr);
+    if (withWeights && !result.verWeights.empty()) {
+        err |= clEnqueueReadBuffer(commandQueue, memObjects[2], CL_FALSE, 0, result.verWeights.size() * sizeof(int),
+                                   result.verWeights.data(), 0, nullptr, nullptr);
+    }
+    if (withWeights && !result.horWeights.empty()) {
+        err |= clEnqueueReadBuffer(commandQueue, memObjects[3], CL_FALSE, 0, result.horWeights.size() * sizeof(int),
+                                   result.horWeights.data(), 0, nullptr, nullptr);
+    }
+    if (err == CL_SUCCESS) {
+        err = clFinish(commandQueue);
+    }
+
+    releaseMemObjects();
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error reading batch results from device." << endl;
+        return false;
+    }
+
+    return true;
+}
+
+size_t Mega::ResidentPairBlocks(cl_device_id deviceId) {
+    cl_uint computeUnits = 1;
+    if (clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, nullptr) !=
+        CL_SUCCESS || computeUnits == 0) {
+        computeUnits = 1;
+    }
+    return (size_t) computeUnits * BatchBlocksPerComputeUnit;
+}
+
+pair<vector<int>, vector<int>> Mega::SplitLargePairs(
+        cl_device_id deviceId,
+        const vector<long long> &pairTiles) {
+
+    // 按单元数从大到小领取时，大对最先开始；它比一个block平均分到的工作还多时，其他block做完了还要等它
+    // 对数少到占不满设备时平均值很小，超过上限的对都单独计算；对数足够多时大对留在同一次启动里
+    long long totalTiles = accumulate(pairTiles.begin(), pairTiles.end(), 0LL);
+    long long blocks = (long long) ResidentPairBlocks(deviceId);
+
+    vector<int> largePairs;
+    vector<int> smallPairs;
+    for (int p = 0; p < (int) pairTiles.size(); p++) {
+        bool isLarge = pairTiles[p] > BatchMaxTilesPerPair && pairTiles[p] * blocks > totalTiles;
+        (isLarge ? largePairs : smallPairs).push_back(p);
+    }
+    return make_pair(largePairs, smallPairs);
+}
+
+void Mega::CpuLCS_Pairs(
+        const vector<int> &pairIds,
+        const function<tuple<const int *, size_t, const int *, size_t>(int)> &pairAt,
+        vector<int> &lengths,
+        const function<void(int, const vector<int> &, const vector<int> &)> &store) {
+
+    atomic<int> nextPair(0);
+    auto worker = [&] {
+        vector<int> verWeights;
+        vector<int> horWeights;
+        for (int i = nextPair.fetch_add(1); i < (int) pairIds.size(); i = nextPair.fetch_add(1)) {
+            int id = pairIds[i];
+            auto sequences = pairAt(id);
+            size_t baseLength = get<1>(sequences);
+            size_t latestLength = get<3>(sequences);
+            if (baseLength == 0 || latestLength == 0) {
+                lengths[id] = 0;
+                continue;
+            }
+
+            verWeights.assign(baseLength, 0);
+            horWeights.assign(latestLength, 0);
+            CpuLCS_MinMaxBlocked(const_cast<int *>(get<0>(sequences)), baseLength,
+                                 const_cast<int *>(get<2>(sequences)), latestLength,
+                                 verWeights.data(), baseLength,
+                                 horWeights.data(), latestLength);
+            lengths[id] = horWeights.back();
+            if (store) {
+                store(id, verWeights, horWeights);
+            }
+        }
+    };
+
+    int threadCount = min((int) pairIds.size(), max(1, (int) thread::hardware_concurrency()));
+    vector<thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &th: threads) {
+        th.join();
+    }
+}
+
+MegaLCSBatchResult Mega::MegaLCS_Batch(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        const MegaLCSBatch &batch,
+        int step,
+        bool withWeights) {
+
+    ValidBatch(batch, step);
+
+    int pairCount = (int) batch.baseOffsets.size() - 1;
+    MegaLCSBatchResult result;
+    result.lengths.assign(pairCount, 0);
+    if (withWeights) {
+        result.verWeights.assign(batch.baseVals.size(), 0);
+        result.horWeights.assign(batch.latestVals.size(), 0);
+    }
+
+    vector<int> allPairs(pairCount);
+    iota(allPairs.begin(), allPairs.end(), 0);
+
+    // 没有设备或者设备出错时，所有对在CPU上计算，权重按对的偏移写回
+    auto cpuBatch = [&] {
+        auto pairAt = [&](int p) {
+            return make_tuple(batch.baseVals.data() + batch.baseOffsets[p],
+                              (size_t) (batch.baseOffsets[p + 1] - batch.baseOffsets[p]),
+                              batch.latestVals.data() + batch.latestOffsets[p],
+                              (size_t) (batch.latestOffsets[p + 1] - batch.latestOffsets[p]));
+        };
+        auto store = [&](int p, const vector<int> &verWeights, const vector<int> &horWeights) {
+            copy(verWeights.begin(), verWeights.end(), result.verWeights.begin() + batch.baseOffsets[p]);
+            copy(horWeights.begin(), horWeights.end(), result.horWeights.begin() + batch.latestOffsets[p]);
+        };
+        CpuLCS_Pairs(allPairs, pairAt, result.lengths,
+                     withWeights ? function<void(int, const vector<int> &, const vector<int> &)>(store) : nullptr);
+        result.processByCpu = true;
+    };
+
+    shared_ptr<MegaLCSEngine> engine;
+    if (platformId != nullptr && deviceId != nullptr) {
+        engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    }
+
+    // 如果没有可用的设备，则全部使用CPU处理
+    if (engine == nullptr || !engine->IsReady()) {
+        cpuBatch();
+        return result;
+    }
+
+    // 大对单独走整个矩阵的wavefront，其余的打包成一个批次
+    vector<long long> pairTiles(pairCount);
+    for (int p = 0; p < pairCount; p++) {
+        long long baseTiles = (batch.baseOffsets[p + 1] - batch.baseOffsets[p] + step - 1) / step;
+        long long latestTiles = (batch.latestOffsets[p + 1] - batch.latestOffsets[p] + step - 1) / step;
+        pairTiles[p] = baseTiles * latestTiles;
+    }
+    vector<int> largePairs;
+    vector<int> smallPairs;
+    tie(largePairs, smallPairs) = SplitLargePairs(deviceId, pairTiles);
+
+    // 没有大对时（常见情况）直接使用原来的批次，不复制
+    MegaLCSBatch smallBatch;
+    if (!largePairs.empty()) {
+        for (int p: smallPairs) {
+            smallBatch.baseVals.insert(smallBatch.baseVals.end(),
+                                       batch.baseVals.begin() + batch.baseOffsets[p],
+                                       batch.baseVals.begin() + batch.baseOffsets[p + 1]);
+            smallBatch.latestVals.insert(smallBatch.latestVals.end(),
+                                         batch.latestVals.begin() + batch.latestOffsets[p],
+                                         batch.latestVals.begin() + batch.latestOffsets[p + 1]);
+            smallBatch.baseOffsets.push_back((int) smallBatch.baseVals.size());
+            smallBatch.latestOffsets.push_back((int) smallBatch.latestVals.size());
+        }
+    }
+    const MegaLCSBatch &deviceBatch = largePairs.empty() ? batch : smallBatch;
+
+    MegaLCSBatchResult deviceResult;
+    if (!engine->HostLCS_Batch(deviceBatch, step, withWeights, deviceResult)) {
+        // 设备出错时整个批次改用CPU计算
+        cpuBatch();
+        return result;
+    }
+
+    if (largePairs.empty()) {
+        return deviceResult;
+    }
+
+    for (int i = 0; i < (int) smallPairs.size(); i++) {
+        int p = smallPairs[i];
+        result.lengths[p] = deviceResult.lengths[i];
+        if (withWeights) {
+            copy(deviceResult.verWeights.begin() + smallBatch.baseOffsets[i],
+                 deviceResult.verWeights.begin() + smallBatch.baseOffsets[i + 1],
+                 result.verWeights.begin() + batch.baseOffsets[p]);
+            copy(deviceResult.horWeights.begin() + smallBatch.latestOffsets[i],
+                 deviceResult.horWeights.begin() + smallBatch.latestOffsets[i + 1],
+                 result.horWeights.begin() + batch.latestOffsets[p]);
+        }
+    }
+
+    for (int p: largePairs) {
+        vector<int> baseVals(batch.baseVals.begin() + batch.baseOffsets[p],
+                             batch.baseVals.begin() + batch.baseOffsets[p + 1]);
+        vector<int> latestVals(batch.latestVals.begin() + batch.latestOffsets[p],
+                               batch.latestVals.begin() + batch.latestOffsets[p + 1]);
+        auto pairResult = MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, step, false);
+        result.lengths[p] = get<2>(pairResult).back();
+        if (withWeights) {
+            copy(get<1>(pairResult).begin(), get<1>(pairResult).end(), result.verWeights.begin() + batch.baseOffsets[p]);
+            copy(get<2>(pairResult).begin(), get<2>(pairResult).end(), result.horWeights.begin() + batch.latestOffsets[p]);
+        }
+    }
+
+    return result;
+}
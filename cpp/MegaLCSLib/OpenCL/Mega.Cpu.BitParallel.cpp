@@ -0,0 +1,256 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+
+// 每次处理latest方向的64个word（4096列），匹配掩码表的大小和列块成正比
+static const int BitParallelBlockWords = 64;
+
+/*
+位并行LCS（Allison-Dix / Hyyrö），一个64位word同时推进64个单元
+latest方向的横向差值Δh∈{0,1}编码成位向量V：第j位为1表示D[b][j]-D[b][j-1]==0
+每处理一个base元素：U = V & M[base[b]]，V = (V + U) | (V - U)
+加法的进位就是纵向差值Δv：左边界的Δv从进位输入，右边界的Δv从进位输出，
+所以可以按列块处理，块之间每一行传递一个进位
+
+输入输出和CpuLCS_MinMax完全相同，在边界上做权重和差值的转换：
+  hors -> 初始V，vers -> 每一行的进位输入
+  最后的V -> hors，每一行的进位输出 -> vers
+左上角的权重没有传入时，和CpuLCS_MinMax一样取min(verWeights[0], horWeights[0])
+分块计算时vers[0]和hors[0]可能都比左上角大1，这时必须传入真实的左上角才能得到精确结果
+
+位并行要求边界是一个合法DP的边界：hors/vers相邻差值∈{0,1}，|vers[0]-hors[0]|<=1
+全0的边界（经典LCS）总是满足；不满足时回退到CpuLCS_MinMax
+
+注意：位并行计算的是精确的DP，CpuLCS_MinMax在匹配且左值==上值==对角+1时会多算1，
+小字母表时两者的结果可能不同，这里的结果和CpuLCS_DPMatrix一致
+ */
+void Mega::CpuLCS_BitParallel(
+        int *baseVals, int baseValsLength,
+        int *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength,
+        const int *leftTopWeight) {
+
+    CpuLCS_BitParallel<int>(baseVals, baseValsLength,
+                            latestVals, latestValsLength,
+                            verWeights, verWeightsLength,
+                            horWeights, horWeightsLength,
+                            leftTopWeight);
+}
+
+// 匹配掩码按值建表，所有元素类型共用同一份实现
+template<typename T>
+void Mega::CpuLCS_BitParallel(
+        T *baseVals, int baseValsLength,
+        T *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength,
+        const int *leftTopWeight) {
+
+    // 和CpuLCS_MinMax相同的校验
+    if (baseValsLength == 0) {
+        throw std::runtime_error("CpuLCS(): baseVals数组为空");
+    }
+
+    if (latestValsLength == 0) {
+        throw std::runtime_error("CpuLCS(): latestVals数组为空");
+    }
+
+    if (horWeightsLength == 0) {
+        throw std::runtime_error("CpuLCS(): horWeights数组为空");
+    }
+
+    if (verWeightsLength == 0) {
+        throw std::runtime_error("CpuLCS(): verWeights数组为空");
+    }
+
+    if (baseValsLength != verWeightsLength) {
+        throw std::runtime_error("CpuLCS(): baseVals数组长度与verWeights数组长度不匹配");
+    }
+
+    if (latestValsLength != horWeightsLength) {
+        throw std::runtime_error("CpuLCS(): latestVals数组长度与horWeights数组长度不匹配");
+    }
+
+    if (!IsBitParallelFrame(verWeights, verWeightsLength, horWeights, horWeightsLength, leftTopWeight)) {
+        CpuLCS_MinMax(baseVals, baseValsLength,
+                      latestVals, latestValsLength,
+                      verWeights, verWeightsLength,
+                      horWeights, horWeightsLength);
+        return;
+    }
+
+    const int m = baseValsLength;
+    const int n = latestValsLength;
+    const int corner = leftTopWeight != nullptr ? *leftTopWeight : std::min(verWeights[0], horWeights[0]);
+    const int lastRowLeft = verWeights[m - 1];
+    const int lastColTop = horWeights[n - 1];
+
+    // latest中出现的值编号为0..K-1，base中没有出现在latest里的值为-1，匹配掩码恒为0
+    std::unordered_map<T, int> ids;
+    ids.reserve(n);
+    std::vector<int> latestIds(n);
+    for (int l = 0; l < n; l++) {
+        latestIds[l] = ids.emplace(latestVals[l], (int) ids.size()).first->second;
+    }
+
+    std::vector<int> baseIds(m);
+    for (int b = 0; b < m; b++) {
+        auto found = ids.find(baseVals[b]);
+        baseIds[b] = found == ids.end() ? -1 : found->second;
+    }
+
+    // 每一行左边界的Δv，处理完一个列块后变成该块右边界的Δv
+    std::vector<uint8_t> carries(m);
+    carries[0] = (uint8_t) (verWeights[0] - corner);
+    for (int b = 1; b < m; b++) {
+        carries[b] = (uint8_t) (verWeights[b] - verWeights[b - 1]);
+    }
+
+    // 列块内每个值的掩码在表里的位置
+    std::vector<int> slots(ids.size(), -1);
+    std::vector<uint64_t> masks;
+    std::vector<uint64_t> vectors(BitParallelBlockWords);
+
+    const int blockCols = BitParallelBlockWords * 64;
+
+    // 上一个列块最后一列的原始上边界权重（horWeights会被逐块覆盖为输出）
+    int previousTop = corner;
+
+    for (int blockBegin = 0; blockBegin < n; blockBegin += blockCols) {
+        const int blockEnd = std::min(n, blockBegin + blockCols);
+        const int words = (blockEnd - blockBegin + 63) / 64;
+
+        // 初始V来自上边界的横向差值，块末尾多出的位置1，进位可以穿过它们到达word的最高位
+        std::fill(vectors.begin(), vectors.begin() + words, ~0ULL);
+        for (int l = blockBegin; l < blockEnd; l++) {
+            int previous = l == blockBegin ? previousTop : horWeights[l - 1];
+            if (horWeights[l] != previous) {
+                int bit = l - blockBegin;
+                vectors[bit / 64] &= ~(1ULL << (bit % 64));
+            }
+        }
+
+        // 构建匹配掩码，块外的值没有槽位
+        int slotCount = 0;
+        for (int l = blockBegin; l < blockEnd; l++) {
+            if (slots[latestIds[l]] < 0) {
+                slots[latestIds[l]] = slotCount++;
+            }
+        }
+
+        masks.assign((size_t) slotCount * words, 0);
+        for (int l = blockBegin; l < blockEnd; l++) {
+            int bit = l - blockBegin;
+            masks[(size_t) slots[latestIds[l]] * words + bit / 64] |= 1ULL << (bit % 64);
+        }
+
+        for (int b = 0; b < m; b++) {
+            int slot = baseIds[b] < 0 ? -1 : slots[baseIds[b]];
+            uint64_t carry = carries[b];
+
+            if (slot < 0) {
+                // 没有匹配时U=0，V只受进位影响：V = (V + carry) | V
+                for (int w = 0; w < words && carry; w++) {
+                    uint64_t v = vectors[w];
+                    uint64_t sum = v + carry;
+                    carry = sum < v;
+                    vectors[w] = sum | v;
+                }
+            } else {
+                const uint64_t *mask = &masks[(size_t) slot * words];
+                for (int w = 0; w < words; w++) {
+                    uint64_t v = vectors[w];
+                    uint64_t u = v & mask[w];
+                    uint64_t partial = v + u;
+                    uint64_t sum = partial + carry;
+                    carry = (partial < v) | (sum < partial);
+                    vectors[w] = sum | (v - u);
+                }
+            }
+
+            carries[b] = (uint8_t) carry;
+        }
+
+        previousTop = horWeights[blockEnd - 1];
+
+        // 横向差值还原成最后一行的权重
+        int weight = blockBegin == 0 ? lastRowLeft : horWeights[blockBegin - 1];
+        for (int l = blockBegin; l < blockEnd; l++) {
+            int bit = l - blockBegin;
+            weight += (int) (((vectors[bit / 64] >> (bit % 64)) & 1ULL) ^ 1ULL);
+            horWeights[l] = weight;
+        }
+
+        for (int l = blockBegin; l < blockEnd; l++) {
+            slots[latestIds[l]] = -1;
+        }
+    }
+
+    // 右边界的纵向差值还原成最后一列的权重
+    int weight = lastColTop;
+    for (int b = 0; b < m; b++) {
+        weight += carries[b];
+        verWeights[b] = weight;
+    }
+}
+
+template void Mega::CpuLCS_BitParallel<uint8_t>(
+        uint8_t *, int, uint8_t *, int, int *, int, int *, int, const int *);
+template void Mega::CpuLCS_BitParallel<uint16_t>(
+        uint16_t *, int, uint16_t *, int, int *, int, int *, int, const int *);
+template void Mega::CpuLCS_BitParallel<int>(
+        int *, int, int *, int, int *, int, int *, int, const int *);
+template void Mega::CpuLCS_BitParallel<int64_t>(
+        int64_t *, int, int64_t *, int, int *, int, int *, int, const int *);
+
+bool Mega::IsBitParallelFrame(
+        const int *verWeights, int verWeightsLength,
+        const int *horWeights, int horWeightsLength,
+        const int *leftTopWeight) {
+
+    if (leftTopWeight != nullptr) {
+        int verDelta = verWeights[0] - *leftTopWeight;
+        int horDelta = horWeights[0] - *leftTopWeight;
+        if ((verDelta != 0 && verDelta != 1) || (horDelta != 0 && horDelta != 1)) {
+            return false;
+        }
+    } else if (std::abs(verWeights[0] - horWeights[0]) > 1) {
+        return false;
+    }
+
+    for (int b = 1; b < verWeightsLength; b++) {
+        int delta = verWeights[b] - verWeights[b - 1];
+        if (delta != 0 && delta != 1) {
+            return false;
+        }
+    }
+
+    for (int l = 1; l < horWeightsLength; l++) {
+        int delta = horWeights[l] - horWeights[l - 1];
+        if (delta != 0 && delta != 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
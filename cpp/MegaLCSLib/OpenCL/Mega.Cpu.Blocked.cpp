@@ -0,0 +1,141 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <stdexcept>
+
+/*
+CpuLCS_MinMax的cache分块版本
+CpuLCS_MinMax每处理一个base元素都要完整扫一遍horWeights，latest有1M元素时每行要从L3/内存读写4MB
+这里和KernelLCS_Shared一样按step*step的tile推进：
+vers的一段先拷到局部数组（对应内核的local vers），沿latest方向逐个tile向右推进，
+每个tile里hors/latests各只有step个元素，整个工作集(4*step个int)留在L1/L2里
+horWeights的读写次数从每行一次降到每step行一次
+单元的计算顺序只是重新分组，依赖关系不变，结果和CpuLCS_MinMax逐元素一致
+ */
+namespace {
+    // 完整tile，STEP是编译期常量，内层循环次数固定，便于编译器展开
+    template<int STEP>
+    void MinMaxTile(const int *bases, const int *latests, int *vers, int *hors) {
+        for (int b = 0; b < STEP; b++) {
+            int base = bases[b];
+            int leftWeight = vers[b];
+            for (int l = 0; l < STEP; l++) {
+                int topWeight = hors[l];
+                int weight = base == latests[l]
+                             ? std::min(leftWeight, topWeight) + 1
+                             : std::max(leftWeight, topWeight);
+                hors[l] = weight;
+                leftWeight = weight;
+            }
+            vers[b] = leftWeight;
+        }
+    }
+
+    // 最后一行/列不满step的tile
+    void MinMaxTile(const int *bases, int baseLength, const int *latests, int latestLength, int *vers, int *hors) {
+        for (int b = 0; b < baseLength; b++) {
+            int base = bases[b];
+            int leftWeight = vers[b];
+            for (int l = 0; l < latestLength; l++) {
+                int topWeight = hors[l];
+                int weight = base == latests[l]
+                             ? std::min(leftWeight, topWeight) + 1
+                             : std::max(leftWeight, topWeight);
+                hors[l] = weight;
+                leftWeight = weight;
+            }
+            vers[b] = leftWeight;
+        }
+    }
+
+    template<int STEP>
+    void MinMaxBlocked(const int *baseVals, int baseValsLength,
+                       const int *latestVals, int latestValsLength,
+                       int *verWeights, int *horWeights) {
+        int localVers[STEP];
+
+        for (int baseOffset = 0; baseOffset < baseValsLength; baseOffset += STEP) {
+            int baseLength = std::min(STEP, baseValsLength - baseOffset);
+            std::copy(verWeights + baseOffset, verWeights + baseOffset + baseLength, localVers);
+
+            for (int latestOffset = 0; latestOffset < latestValsLength; latestOffset += STEP) {
+                int latestLength = std::min(STEP, latestValsLength - latestOffset);
+
+                if (baseLength == STEP && latestLength == STEP) {
+                    MinMaxTile<STEP>(baseVals + baseOffset, latestVals + latestOffset,
+                                     localVers, horWeights + latestOffset);
+                } else {
+                    MinMaxTile(baseVals + baseOffset, baseLength, latestVals + latestOffset, latestLength,
+                               localVers, horWeights + latestOffset);
+                }
+            }
+
+            std::copy(localVers, localVers + baseLength, verWeights + baseOffset);
+        }
+    }
+}
+
+void Mega::CpuLCS_MinMaxBlocked(
+        int *baseVals, int baseValsLength,
+        int *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength,
+        int step) {
+
+    // 和CpuLCS_MinMax相同的校验
+    if (baseValsLength == 0) {
+        throw std::runtime_error("CpuLCS(): baseVals数组为空");
+    }
+
+    if (latestValsLength == 0) {
+        throw std::runtime_error("CpuLCS(): latestVals数组为空");
+    }
+
+    if (horWeightsLength == 0) {
+        throw std::runtime_error("CpuLCS(): horWeights数组为空");
+    }
+
+    if (verWeightsLength == 0) {
+        throw std::runtime_error("CpuLCS(): verWeights数组为空");
+    }
+
+    if (baseValsLength != verWeightsLength) {
+        throw std::runtime_error("CpuLCS(): baseVals数组长度与verWeights数组长度不匹配");
+    }
+
+    if (latestValsLength != horWeightsLength) {
+        throw std::runtime_error("CpuLCS(): latestVals数组长度与horWeights数组长度不匹配");
+    }
+
+    switch (step) {
+        case 64:
+            MinMaxBlocked<64>(baseVals, baseValsLength, latestVals, latestValsLength, verWeights, horWeights);
+            break;
+        case 128:
+            MinMaxBlocked<128>(baseVals, baseValsLength, latestVals, latestValsLength, verWeights, horWeights);
+            break;
+        case 256:
+            MinMaxBlocked<256>(baseVals, baseValsLength, latestVals, latestValsLength, verWeights, horWeights);
+            break;
+        case 512:
+            MinMaxBlocked<512>(baseVals, baseValsLength, latestVals, latestValsLength, verWeights, horWeights);
+            break;
+        default:
+            throw std::runtime_error("step is invalid.");
+    }
+}
@@ -0,0 +1,432 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// x86上用GCC/Clang的target属性单独编译各个指令集的版本，运行时检测CPU后选择
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MEGALCS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// AArch64上NEON总是可用
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MEGALCS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+CpuLCS_MinMax的反对角线版本
+和KernelLCS_Shared一样，同一条反对角线b+l=d上的单元互不依赖：
+单元(b,l)只读写vers[b]和hors[l]，同一条对角线上的b和l各不相同
+把hors和latest倒序存放后，对角线上的单元在vers/bases和revHors/revLatests里都是连续的，
+可以直接用8个（AVX2）或16个（AVX-512）lane一次处理
+递推公式和CpuLCS_MinMax逐单元相同，结果逐位一致
+ */
+namespace {
+    struct DiagonalSweep {
+        const int *bases;
+        const int *revLatests;
+        int *vers;
+        int *revHors;
+        int baseLength;
+        int latestLength;
+    };
+
+    // 对角线d上b的范围是[bBegin, bBegin+count)，对应revHors的起点是kBegin
+    inline void DiagonalRange(const DiagonalSweep &sweep, int d, int &bBegin, int &count, int &kBegin) {
+        bBegin = std::max(0, d - (sweep.latestLength - 1));
+        int bEnd = std::min(sweep.baseLength - 1, d);
+        count = bEnd - bBegin + 1;
+        kBegin = sweep.latestLength - 1 - d + bBegin;
+    }
+
+    inline void CellScalar(const DiagonalSweep &sweep, int b, int k) {
+        int leftWeight = sweep.vers[b];
+        int topWeight = sweep.revHors[k];
+        int weight = sweep.bases[b] == sweep.revLatests[k]
+                     ? std::min(leftWeight, topWeight) + 1
+                     : std::max(leftWeight, topWeight);
+        sweep.vers[b] = weight;
+        sweep.revHors[k] = weight;
+    }
+
+    void SweepScalar(const DiagonalSweep &sweep) {
+        int totalDiagonal = sweep.baseLength + sweep.latestLength - 1;
+        for (int d = 0; d < totalDiagonal; d++) {
+            int bBegin, count, kBegin;
+            DiagonalRange(sweep, d, bBegin, count, kBegin);
+            for (int i = 0; i < count; i++) {
+                CellScalar(sweep, bBegin + i, kBegin + i);
+            }
+        }
+    }
+
+#ifdef MEGALCS_SIMD_X86
+
+    __attribute__((target("avx2")))
+    void SweepAvx2(const DiagonalSweep &sweep) {
+        const __m256i one = _mm256_set1_epi32(1);
+        int totalDiagonal = sweep.baseLength + sweep.latestLength - 1;
+
+        for (int d = 0; d < totalDiagonal; d++) {
+            int bBegin, count, kBegin;
+            DiagonalRange(sweep, d, bBegin, count, kBegin);
+
+            int *vers = sweep.vers + bBegin;
+            int *hors = sweep.revHors + kBegin;
+            const int *bases = sweep.bases + bBegin;
+            const int *latests = sweep.revLatests + kBegin;
+
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m256i leftWeight = _mm256_loadu_si256((const __m256i *) (vers + i));
+                __m256i topWeight = _mm256_loadu_si256((const __m256i *) (hors + i));
+                __m256i isMatch = _mm256_cmpeq_epi32(
+                        _mm256_loadu_si256((const __m256i *) (bases + i)),
+                        _mm256_loadu_si256((const __m256i *) (latests + i)));
+
+                __m256i matchWeight = _mm256_add_epi32(_mm256_min_epi32(leftWeight, topWeight), one);
+                __m256i otherWeight = _mm256_max_epi32(leftWeight, topWeight);
+                __m256i weight = _mm256_blendv_epi8(otherWeight, matchWeight, isMatch);
+
+                _mm256_storeu_si256((__m256i *) (vers + i), weight);
+                _mm256_storeu_si256((__m256i *) (hors + i), weight);
+            }
+
+            for (; i < count; i++) {
+                CellScalar(sweep, bBegin + i, kBegin + i);
+            }
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void SweepAvx512(const DiagonalSweep &sweep) {
+        const __m512i one = _mm512_set1_epi32(1);
+        int totalDiagonal = sweep.baseLength + sweep.latestLength - 1;
+
+        for (int d = 0; d < totalDiagonal; d++) {
+            int bBegin, count, kBegin;
+            DiagonalRange(sweep, d, bBegin, count, kBegin);
+
+            int *vers = sweep.vers + bBegin;
+            int *hors = sweep.revHors + kBegin;
+            const int *bases = sweep.bases + bBegin;
+            const int *latests = sweep.revLatests + kBegin;
+
+            // 尾部用掩码处理，不需要标量循环
+            for (int i = 0; i < count; i += 16) {
+                __mmask16 lanes = count - i >= 16 ? (__mmask16) 0xFFFF : (__mmask16) ((1u << (count - i)) - 1u);
+
+                __m512i leftWeight = _mm512_maskz_loadu_epi32(lanes, vers + i);
+                __m512i topWeight = _mm512_maskz_loadu_epi32(lanes, hors + i);
+                __mmask16 isMatch = _mm512_mask_cmpeq_epi32_mask(
+                        lanes,
+                        _mm512_maskz_loadu_epi32(lanes, bases + i),
+                        _mm512_maskz_loadu_epi32(lanes, latests + i));
+
+                __m512i matchWeight = _mm512_add_epi32(_mm512_min_epi32(leftWeight, topWeight), one);
+                __m512i otherWeight = _mm512_max_epi32(leftWeight, topWeight);
+                __m512i weight = _mm512_mask_blend_epi32(isMatch, otherWeight, matchWeight);
+
+                _mm512_mask_storeu_epi32(vers + i, lanes, weight);
+                _mm512_mask_storeu_epi32(hors + i, lanes, weight);
+            }
+        }
+    }
+
+#endif
+
+#ifdef MEGALCS_SIMD_NEON
+
+    void SweepNeon(const DiagonalSweep &sweep) {
+        const int32x4_t one = vdupq_n_s32(1);
+        int totalDiagonal = sweep.baseLength + sweep.latestLength - 1;
+
+        for (int d = 0; d < totalDiagonal; d++) {
+            int bBegin, count, kBegin;
+            DiagonalRange(sweep, d, bBegin, count, kBegin);
+
+            int *vers = sweep.vers + bBegin;
+            int *hors = sweep.revHors + kBegin;
+            const int *bases = sweep.bases + bBegin;
+            const int *latests = sweep.revLatests + kBegin;
+
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                int32x4_t leftWeight = vld1q_s32(vers + i);
+                int32x4_t topWeight = vld1q_s32(hors + i);
+                uint32x4_t isMatch = vceqq_s32(vld1q_s32(bases + i), vld1q_s32(latests + i));
+
+                int32x4_t matchWeight = vaddq_s32(vminq_s32(leftWeight, topWeight), one);
+                int32x4_t otherWeight = vmaxq_s32(leftWeight, topWeight);
+                int32x4_t weight = vbslq_s32(isMatch, matchWeight, otherWeight);
+
+                vst1q_s32(vers + i, weight);
+                vst1q_s32(hors + i, weight);
+            }
+
+            for (; i < count; i++) {
+                CellScalar(sweep, bBegin + i, kBegin + i);
+            }
+        }
+    }
+
+#endif
+
+    /*
+    公共前缀/后缀的长度，用于Anchored预处理裁掉两端相同的部分
+    一次比较一个向量，全部相等时继续，否则在掩码里找第一个（后缀是最后一个）不相等的位置
+     */
+    size_t PrefixScalar(const int *a, const int *b, size_t length) {
+        size_t i = 0;
+        while (i < length && a[i] == b[i]) {
+            i++;
+        }
+        return i;
+    }
+
+    // a和b指向最后一个元素之后
+    size_t SuffixScalar(const int *aEnd, const int *bEnd, size_t length) {
+        size_t i = 0;
+        while (i < length && aEnd[-1 - (ptrdiff_t) i] == bEnd[-1 - (ptrdiff_t) i]) {
+            i++;
+        }
+        return i;
+    }
+
+#ifdef MEGALCS_SIMD_X86
+
+    __attribute__((target("avx2")))
+    size_t PrefixAvx2(const int *a, const int *b, size_t length) {
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            __m256i isEqual = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) (a + i)),
+                                                 _mm256_loadu_si256((const __m256i *) (b + i)));
+            unsigned mask = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(isEqual));
+            if (mask != 0xFFu) {
+                return i + __builtin_ctz(~mask);
+            }
+        }
+        return i + PrefixScalar(a + i, b + i, length - i);
+    }
+
+    __attribute__((target("avx2")))
+    size_t SuffixAvx2(const int *aEnd, const int *bEnd, size_t length) {
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            __m256i isEqual = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) (aEnd - i - 8)),
+                                                 _mm256_loadu_si256((const __m256i *) (bEnd - i - 8)));
+            unsigned mask = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(isEqual));
+            if (mask != 0xFFu) {
+                // 第7位对应离结尾最近的元素
+                return i + (__builtin_clz(~mask & 0xFFu) - 24);
+            }
+        }
+        return i + SuffixScalar(aEnd - i, bEnd - i, length - i);
+    }
+
+    __attribute__((target("avx512f")))
+    size_t PrefixAvx512(const int *a, const int *b, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __mmask16 notEqual = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+            if (notEqual != 0) {
+                return i + __builtin_ctz(notEqual);
+            }
+        }
+        return i + PrefixScalar(a + i, b + i, length - i);
+    }
+
+    __attribute__((target("avx512f")))
+    size_t SuffixAvx512(const int *aEnd, const int *bEnd, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __mmask16 notEqual = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(aEnd - i - 16),
+                                                          _mm512_loadu_si512(bEnd - i - 16));
+            if (notEqual != 0) {
+                return i + (__builtin_clz((unsigned) notEqual) - 16);
+            }
+        }
+        return i + SuffixScalar(aEnd - i, bEnd - i, length - i);
+    }
+
+    // 一次比较32个字节，找到第一个等于value的位置，用于切分token
+    __attribute__((target("avx2")))
+    size_t FindByteAvx2(const char *data, size_t length, char value) {
+        const __m256i needle = _mm256_set1_epi8(value);
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            __m256i isEqual = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (data + i)), needle);
+            unsigned mask = (unsigned) _mm256_movemask_epi8(isEqual);
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        for (; i < length; i++) {
+            if (data[i] == value) {
+                return i;
+            }
+        }
+        return length;
+    }
+
+#endif
+}
+
+size_t Mega::FindByte(const char *data, size_t length, char value) {
+#ifdef MEGALCS_SIMD_X86
+    if (GetBestCpuIsa() == MegaLCSCpuIsa::AVX512 || GetBestCpuIsa() == MegaLCSCpuIsa::AVX2) {
+        return FindByteAvx2(data, length, value);
+    }
+#endif
+
+    const void *found = memchr(data, value, length);
+    return found == nullptr ? length : (const char *) found - data;
+}
+
+size_t Mega::CommonPrefixLength(const int *a, const int *b, size_t length) {
+    switch (GetBestCpuIsa()) {
+#ifdef MEGALCS_SIMD_X86
+        case MegaLCSCpuIsa::AVX512:
+            return PrefixAvx512(a, b, length);
+        case MegaLCSCpuIsa::AVX2:
+            return PrefixAvx2(a, b, length);
+#endif
+        default:
+            return PrefixScalar(a, b, length);
+    }
+}
+
+size_t Mega::CommonSuffixLength(const int *aEnd, const int *bEnd, size_t length) {
+    switch (GetBestCpuIsa()) {
+#ifdef MEGALCS_SIMD_X86
+        case MegaLCSCpuIsa::AVX512:
+            return SuffixAvx512(aEnd, bEnd, length);
+        case MegaLCSCpuIsa::AVX2:
+            return SuffixAvx2(aEnd, bEnd, length);
+#endif
+        default:
+            return SuffixScalar(aEnd, bEnd, length);
+    }
+}
+
+bool Mega::IsCpuIsaSupported(MegaLCSCpuIsa isa) {
+    switch (isa) {
+        case MegaLCSCpuIsa::Auto:
+        case MegaLCSCpuIsa::Scalar:
+            return true;
+#ifdef MEGALCS_SIMD_X86
+        case MegaLCSCpuIsa::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case MegaLCSCpuIsa::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef MEGALCS_SIMD_NEON
+        case MegaLCSCpuIsa::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+MegaLCSCpuIsa Mega::GetBestCpuIsa() {
+    // CPU不会在运行期间变化，只检测一次
+    static const MegaLCSCpuIsa bestIsa = [] {
+        for (auto isa: {MegaLCSCpuIsa::AVX512, MegaLCSCpuIsa::AVX2, MegaLCSCpuIsa::NEON}) {
+            if (IsCpuIsaSupported(isa)) {
+                return isa;
+            }
+        }
+        return MegaLCSCpuIsa::Scalar;
+    }();
+
+    return bestIsa;
+}
+
+void Mega::CpuLCS_MinMaxSimd(
+        int *baseVals, int baseValsLength,
+        int *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength,
+        MegaLCSCpuIsa isa) {
+
+    // 和CpuLCS_MinMax相同的校验
+    if (baseValsLength == 0) {
+        throw std::runtime_error("CpuLCS(): baseVals数组为空");
+    }
+
+    if (latestValsLength == 0) {
+        throw std::runtime_error("CpuLCS(): latestVals数组为空");
+    }
+
+    if (horWeightsLength == 0) {
+        throw std::runtime_error("CpuLCS(): horWeights数组为空");
+    }
+
+    if (verWeightsLength == 0) {
+        throw std::runtime_error("CpuLCS(): verWeights数组为空");
+    }
+
+    if (baseValsLength != verWeightsLength) {
+        throw std::runtime_error("CpuLCS(): baseVals数组长度与verWeights数组长度不匹配");
+    }
+
+    if (latestValsLength != horWeightsLength) {
+        throw std::runtime_error("CpuLCS(): latestVals数组长度与horWeights数组长度不匹配");
+    }
+
+    if (isa == MegaLCSCpuIsa::Auto) {
+        isa = GetBestCpuIsa();
+    }
+
+    if (!IsCpuIsaSupported(isa)) {
+        throw std::runtime_error("CpuLCS(): 当前CPU不支持指定的指令集");
+    }
+
+    // latest方向倒序，使反对角线上的单元连续
+    std::vector<int> revLatests(latestVals, latestVals + latestValsLength);
+    std::vector<int> revHors(horWeights, horWeights + horWeightsLength);
+    std::reverse(revLatests.begin(), revLatests.end());
+    std::reverse(revHors.begin(), revHors.end());
+
+    DiagonalSweep sweep{baseVals, revLatests.data(), verWeights, revHors.data(), baseValsLength, latestValsLength};
+
+    switch (isa) {
+#ifdef MEGALCS_SIMD_X86
+        case MegaLCSCpuIsa::AVX512:
+            SweepAvx512(sweep);
+            break;
+        case MegaLCSCpuIsa::AVX2:
+            SweepAvx2(sweep);
+            break;
+#endif
+#ifdef MEGALCS_SIMD_NEON
+        case MegaLCSCpuIsa::NEON:
+            SweepNeon(sweep);
+            break;
+#endif
+        default:
+            SweepScalar(sweep);
+            break;
+    }
+
+    std::reverse_copy(revHors.begin(), revHors.end(), horWeights);
+}
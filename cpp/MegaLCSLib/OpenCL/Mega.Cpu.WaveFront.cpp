@@ -0,0 +1,178 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+
+/*
+多线程的CPU tile wavefront
+和HostLCS_WaveFront相同的分块：step*step的tile，tile(b,l)读写verWeights的第b段和horWeights的第l段
+tile(b,l)只依赖左边tile(b,l-1)和上边tile(b-1,l)，所以不按对角带同步，
+每个tile有一个依赖计数，两个依赖都完成后立即可以执行
+调度用work-stealing：每个线程有自己的双端队列，自己从尾部取（刚解锁的右边tile，vers还在cache里），
+空闲线程从别人的头部偷（最早解锁的tile）
+最后一行/列的tile可以不满step，CPU上不需要像GPU那样要求长度是step的倍数
+ */
+namespace {
+    struct TileQueue {
+        mutex queueMutex;
+        deque<int> tiles;
+    };
+}
+
+void Mega::CpuLCS_WaveFront(
+        int *baseVals, int baseValsLength,
+        int *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength,
+        int step,
+        int threadCount) {
+
+    // 和CpuLCS_MinMax相同的校验
+    if (baseValsLength == 0) {
+        throw runtime_error("CpuLCS(): baseVals数组为空");
+    }
+
+    if (latestValsLength == 0) {
+        throw runtime_error("CpuLCS(): latestVals数组为空");
+    }
+
+    if (horWeightsLength == 0) {
+        throw runtime_error("CpuLCS(): horWeights数组为空");
+    }
+
+    if (verWeightsLength == 0) {
+        throw runtime_error("CpuLCS(): verWeights数组为空");
+    }
+
+    if (baseValsLength != verWeightsLength) {
+        throw runtime_error("CpuLCS(): baseVals数组长度与verWeights数组长度不匹配");
+    }
+
+    if (latestValsLength != horWeightsLength) {
+        throw runtime_error("CpuLCS(): latestVals数组长度与horWeights数组长度不匹配");
+    }
+
+    if (step < 1) {
+        throw runtime_error("step is invalid.");
+    }
+
+    int baseSlices = (baseValsLength + step - 1) / step;
+    int latestSlices = (latestValsLength + step - 1) / step;
+    int totalTiles = baseSlices * latestSlices;
+
+    auto runTile = [&](int tile) {
+        int baseOffset = tile / latestSlices * step;
+        int latestOffset = tile % latestSlices * step;
+        int baseLength = min(step, baseValsLength - baseOffset);
+        int latestLength = min(step, latestValsLength - latestOffset);
+
+        CpuLCS_MinMaxSimd(baseVals + baseOffset, baseLength,
+                          latestVals + latestOffset, latestLength,
+                          verWeights + baseOffset, baseLength,
+                          horWeights + latestOffset, latestLength);
+    };
+
+    // 同时可以执行的tile最多是较短一边的tile数
+    if (threadCount <= 0) {
+        threadCount = max(1, (int) thread::hardware_concurrency());
+    }
+    threadCount = min(threadCount, min(baseSlices, latestSlices));
+
+    // 单线程时按行顺序执行，天然满足依赖
+    if (threadCount == 1) {
+        for (int tile = 0; tile < totalTiles; tile++) {
+            runTile(tile);
+        }
+        return;
+    }
+
+    // 第一行和第一列只有一个依赖，tile(0,0)没有依赖
+    vector<atomic<int>> pendingDeps(totalTiles);
+    for (int tile = 0; tile < totalTiles; tile++) {
+        int b = tile / latestSlices;
+        int l = tile % latestSlices;
+        pendingDeps[tile].store((b > 0 ? 1 : 0) + (l > 0 ? 1 : 0), memory_order_relaxed);
+    }
+
+    vector<TileQueue> queues(threadCount);
+    queues[0].tiles.push_back(0);
+    atomic<int> remainingTiles(totalTiles);
+
+    auto worker = [&](int self) {
+        while (remainingTiles.load(memory_order_acquire) > 0) {
+            int tile = -1;
+
+            {
+                lock_guard<mutex> lock(queues[self].queueMutex);
+                if (!queues[self].tiles.empty()) {
+                    tile = queues[self].tiles.back();
+                    queues[self].tiles.pop_back();
+                }
+            }
+
+            for (int k = 1; tile < 0 && k < threadCount; k++) {
+                TileQueue &victim = queues[(self + k) % threadCount];
+                lock_guard<mutex> lock(victim.queueMutex);
+                if (!victim.tiles.empty()) {
+                    tile = victim.tiles.front();
+                    victim.tiles.pop_front();
+                }
+            }
+
+            if (tile < 0) {
+                this_thread::yield();
+                continue;
+            }
+
+            runTile(tile);
+
+            // 先放下边再放右边，自己下一个取到的是同一行的右边tile
+            int b = tile / latestSlices;
+            int l = tile % latestSlices;
+            int readyTiles[2];
+            int readyCount = 0;
+            if (b + 1 < baseSlices && pendingDeps[tile + latestSlices].fetch_sub(1, memory_order_acq_rel) == 1) {
+                readyTiles[readyCount++] = tile + latestSlices;
+            }
+            if (l + 1 < latestSlices && pendingDeps[tile + 1].fetch_sub(1, memory_order_acq_rel) == 1) {
+                readyTiles[readyCount++] = tile + 1;
+            }
+
+            if (readyCount > 0) {
+                lock_guard<mutex> lock(queues[self].queueMutex);
+                for (int i = 0; i < readyCount; i++) {
+                    queues[self].tiles.push_back(readyTiles[i]);
+                }
+            }
+
+            remainingTiles.fetch_sub(1, memory_order_acq_rel);
+        }
+    };
+
+    vector<thread> threads;
+    for (int t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (auto &th: threads) {
+        th.join();
+    }
+}
@@ -35,6 +35,20 @@ void Mega::CpuLCS_MinMax(
         int *verWeights, int verWeightsLength,
         int *horWeights, int horWeightsLength) {
 
+    CpuLCS_MinMax<int>(baseVals, baseValsLength,
+                       latestVals, latestValsLength,
+                       verWeights, verWeightsLength,
+                       horWeights, horWeightsLength);
+}
+
+// 元素只参与相等比较，所有元素类型共用同一份实现
+template<typename T>
+void Mega::CpuLCS_MinMax(
+        T *baseVals, int baseValsLength,
+        T *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength) {
+
     // 先做校验，这个是由理论分析后的结果，必须满足
     if (baseValsLength == 0) {
         throw std::runtime_error("CpuLCS(): baseVals数组为空");
@@ -212,4 +226,7 @@ std::pair<std::vector<int>, std::vector<int>> Mega::CpuLCS_DPMatrix(
     return std::make_pair(verWeights, horWeights);
 }
 
-
+template void Mega::CpuLCS_MinMax<uint8_t>(uint8_t *, int, uint8_t *, int, int *, int, int *, int);
+template void Mega::CpuLCS_MinMax<uint16_t>(uint16_t *, int, uint16_t *, int, int *, int, int *, int);
+template void Mega::CpuLCS_MinMax<int>(int *, int, int *, int, int *, int, int *, int);
+template void Mega::CpuLCS_MinMax<int64_t>(int64_t *, int, int64_t *, int, int *, int, int *, int);
@@ -95,3 +95,55 @@ pair<cl_platform_id, cl_device_id> Mega::GetFirstGpuDevice() {
 
     return make_pair(platformId, deviceId);
 }
+
+vector<pair<cl_platform_id, cl_device_id>> Mega::CreateSubDevices(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        int count) {
+
+    vector<pair<cl_platform_id, cl_device_id>> result;
+    if (count <= 0) {
+        return result;
+    }
+
+    // 按计算单元平均切分，每个子设备至少一个计算单元
+    cl_uint computeUnits = 0;
+    cl_int err = clGetDeviceInfo(deviceId, CL_DEVICE_PARTITION_MAX_SUB_DEVICES, sizeof(cl_uint), &computeUnits,
+                                 nullptr);
+    if (err != CL_SUCCESS || computeUnits < (cl_uint) count) {
+        return result;
+    }
+
+    err = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, nullptr);
+    if (err != CL_SUCCESS || computeUnits < (cl_uint) count) {
+        return result;
+    }
+
+    cl_device_partition_property properties[] = {
+            CL_DEVICE_PARTITION_EQUALLY, (cl_device_partition_property) (computeUnits / count),
+            0
+    };
+
+    cl_uint subDeviceCount = 0;
+    err = clCreateSubDevices(deviceId, properties, 0, nullptr, &subDeviceCount);
+    if (err != CL_SUCCESS || subDeviceCount == 0) {
+        return result;
+    }
+
+    vector<cl_device_id> subDevices(subDeviceCount);
+    err = clCreateSubDevices(deviceId, properties, subDeviceCount, subDevices.data(), nullptr);
+    if (err != CL_SUCCESS) {
+        return result;
+    }
+
+    // 余下的计算单元可能多切出子设备，只保留前count个
+    for (cl_uint d = 0; d < subDeviceCount; d++) {
+        if ((int) d < count) {
+            result.emplace_back(platformId, subDevices[d]);
+        } else {
+            clReleaseDevice(subDevices[d]);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+
+using namespace std;
+
+template<typename T>
+int Mega::RemapDense(
+        const vector<T> &baseVals,
+        const vector<T> &latestVals,
+        vector<int> &baseRanks,
+        vector<int> &latestRanks) {
+
+    // 两边的值合在一起排序去重，名次就是在去重后数组里的位置
+    vector<T> values;
+    values.reserve(baseVals.size() + latestVals.size());
+    values.insert(values.end(), baseVals.begin(), baseVals.end());
+    values.insert(values.end(), latestVals.begin(), latestVals.end());
+    sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+
+    auto rank = [&values](const T &val) {
+        return (int) (lower_bound(values.begin(), values.end(), val) - values.begin());
+    };
+
+    baseRanks.resize(baseVals.size());
+    transform(baseVals.begin(), baseVals.end(), baseRanks.begin(), rank);
+
+    latestRanks.resize(latestVals.size());
+    transform(latestVals.begin(), latestVals.end(), latestRanks.begin(), rank);
+
+    return (int) values.size();
+}
+
+MegaLCSElementType Mega::GetNarrowestElementType(int alphabetSize) {
+    if (alphabetSize <= 256) {
+        return MegaLCSElementType::UInt8;
+    }
+
+    if (alphabetSize <= 65536) {
+        return MegaLCSElementType::UInt16;
+    }
+
+    // 名次总是int，不需要64位
+    return MegaLCSElementType::Int32;
+}
+
+template int Mega::RemapDense<uint8_t>(
+        const vector<uint8_t> &, const vector<uint8_t> &, vector<int> &, vector<int> &);
+template int Mega::RemapDense<uint16_t>(
+        const vector<uint16_t> &, const vector<uint16_t> &, vector<int> &, vector<int> &);
+template int Mega::RemapDense<int>(
+        const vector<int> &, const vector<int> &, vector<int> &, vector<int> &);
+template int Mega::RemapDense<int64_t>(
+        const vector<int64_t> &, const vector<int64_t> &, vector<int> &, vector<int> &);
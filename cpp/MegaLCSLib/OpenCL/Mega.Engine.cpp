@@ -0,0 +1,204 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+
+using namespace std;
+
+MegaLCSEngine::MegaLCSEngine(cl_platform_id platformId, cl_device_id deviceId)
+        : platformId(platformId), deviceId(deviceId) {
+
+    // 创建上下文
+    cl_context_properties contextProperties[] = {
+            CL_CONTEXT_PLATFORM, (cl_context_properties) platformId,
+            0
+    };
+
+    cl_int err;
+    context = clCreateContext(
+            contextProperties,
+            1,
+            &deviceId,
+            nullptr,
+            nullptr,
+            &err);
+
+    if (err != CL_SUCCESS || context == nullptr) {
+        cerr << "Failed to create OpenCL context for device." << endl;
+        context = nullptr;
+        return;
+    }
+
+    // 创建命令队列
+    cl_device_id device = nullptr;
+    commandQueue = Mega::CreateCommandQueue(context, &device);
+    if (commandQueue == nullptr) {
+        clReleaseContext(context);
+        context = nullptr;
+    }
+}
+
+MegaLCSEngine::~MegaLCSEngine() {
+    for (auto &item: kernelCache) {
+        cl_mem noMemObjects[4] = {nullptr, nullptr, nullptr, nullptr};
+        Mega::Cleanup(nullptr, nullptr, item.second.first, item.second.second, noMemObjects);
+    }
+    kernelCache.clear();
+
+    cl_mem noMemObjects[4] = {nullptr, nullptr, nullptr, nullptr};
+    Mega::Cleanup(context, commandQueue, nullptr, nullptr, noMemObjects);
+}
+
+bool MegaLCSEngine::IsReady() const {
+    return context != nullptr && commandQueue != nullptr;
+}
+
+cl_platform_id MegaLCSEngine::GetPlatformId() const {
+    return platformId;
+}
+
+cl_device_id MegaLCSEngine::GetDeviceId() const {
+    return deviceId;
+}
+
+void MegaLCSEngine::SetSubmitMode(MegaLCSSubmitMode mode) {
+    lock_guard<mutex> lock(engineMutex);
+    submitMode = mode;
+}
+
+MegaLCSSubmitMode MegaLCSEngine::GetSubmitMode() {
+    lock_guard<mutex> lock(engineMutex);
+    return submitMode;
+}
+
+void MegaLCSEngine::SetKernelVariant(MegaLCSKernelVariant variant) {
+    lock_guard<mutex> lock(engineMutex);
+    kernelVariant = variant;
+}
+
+MegaLCSKernelVariant MegaLCSEngine::GetKernelVariant() {
+    lock_guard<mutex> lock(engineMutex);
+    return kernelVariant;
+}
+
+void MegaLCSEngine::SetElementNarrowing(bool isNarrowing) {
+    lock_guard<mutex> lock(engineMutex);
+    elementNarrowing = isNarrowing;
+}
+
+bool MegaLCSEngine::GetElementNarrowing() {
+    lock_guard<mutex> lock(engineMutex);
+    return elementNarrowing;
+}
+
+void MegaLCSEngine::SetCpuCoExecution(bool isCoExecution) {
+    lock_guard<mutex> lock(engineMutex);
+    cpuCoExecution = isCoExecution;
+}
+
+bool MegaLCSEngine::GetCpuCoExecution() {
+    lock_guard<mutex> lock(engineMutex);
+    return cpuCoExecution;
+}
+
+void MegaLCSEngine::SetPackedWeights(bool isPacked) {
+    lock_guard<mutex> lock(engineMutex);
+    packedWeights = isPacked;
+}
+
+bool MegaLCSEngine::GetPackedWeights() {
+    lock_guard<mutex> lock(engineMutex);
+    return packedWeights;
+}
+
+cl_kernel MegaLCSEngine::GetKernel(
+        MegaLCSKernelVariant variant,
+        bool isSharedVersion,
+        int threadPerBlock,
+        int step,
+        int stepBase,
+        bool isDebug,
+        MegaLCSElementType elementType,
+        bool isPackedWeights,
+        Mega::PairLayout layout) {
+
+    auto key = make_tuple(variant, isSharedVersion, threadPerBlock, step, stepBase, isDebug, elementType,
+                          isPackedWeights, layout);
+    auto found = kernelCache.find(key);
+    if (found != kernelCache.end()) {
+        return found->second.second;
+    }
+
+    // 创建程序，每个tile形状和元素类型只编译一次
+    cl_program program = Mega::CreateProgram(context, deviceId, isSharedVersion, step, isDebug, variant, threadPerBlock,
+                                             elementType, isPackedWeights, stepBase, layout);
+    if (program == nullptr) {
+        return nullptr;
+    }
+
+    // 创建内核
+    cl_int err;
+    const char *kernelName = "KernelLCS_MinMax";
+    if (layout == Mega::PairLayout::Batch || layout == Mega::PairLayout::OneToMany) {
+        kernelName = "KernelLCS_Batch";
+    } else if (variant == MegaLCSKernelVariant::Persistent) {
+        kernelName = "KernelLCS_Persistent";
+    } else if (variant == MegaLCSKernelVariant::BitParallel) {
+        kernelName = "KernelLCS_BitParallel";
+    } else if (variant == MegaLCSKernelVariant::Compact) {
+        kernelName = "KernelLCS_Compact";
+    } else if (threadPerBlock > 0) {
+        kernelName = "KernelLCS_Coarsened";
+    }
+    cl_kernel kernel = clCreateKernel(program, kernelName, &err);
+    if (err != CL_SUCCESS || kernel == nullptr) {
+        cerr << "Failed to create kernel" << endl;
+        clReleaseProgram(program);
+        return nullptr;
+    }
+
+    kernelCache[key] = make_pair(program, kernel);
+    return kernel;
+}
+
+shared_ptr<MegaLCSEngine> MegaLCSEngine::GetDefault(cl_platform_id platformId, cl_device_id deviceId) {
+    // 故意不释放：部分OpenCL驱动在进程退出阶段先于静态析构卸载，析构时再释放对象会崩溃
+    static auto *engines = new map<cl_device_id, shared_ptr<MegaLCSEngine>>();
+    static mutex enginesMutex;
+
+    lock_guard<mutex> lock(enginesMutex);
+
+    auto found = engines->find(deviceId);
+    if (found != engines->end()) {
+        return found->second;
+    }
+
+    auto engine = make_shared<MegaLCSEngine>(platformId, deviceId);
+
+    // 创建失败的不缓存，下次调用重新尝试
+    if (engine->IsReady()) {
+        // 有调优结果时使用调优选出的提交方式和内核变体
+        MegaLCSTuning tuning;
+        if (Mega::LoadTuning(platformId, deviceId, tuning)) {
+            engine->SetSubmitMode(tuning.submitMode);
+            engine->SetKernelVariant(tuning.kernelVariant);
+        }
+
+        (*engines)[deviceId] = engine;
+    }
+
+    return engine;
+}
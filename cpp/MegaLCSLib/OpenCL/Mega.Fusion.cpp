@@ -15,25 +15,127 @@ limitations under the License.
 */
 
 #include "Mega.h"
-#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+
+// CPU/GPU同时计算时base方向的行带数，设备算第一个行带时CPU在等，行带越多这段空闲越短
+static const int FusionCoExecutionBands = 16;
+
+// CPU的多线程wavefront在CPU/GPU总吞吐中的占比，每个设备和step第一次使用时测一次
+// 测量用min(16*step, 2048)见方的随机数据，设备先跑一次编译内核，第二次计时
+static double FusionCpuShare(const shared_ptr<MegaLCSEngine> &engine, int step) {
+    static map<pair<cl_device_id, int>, double> shares;
+    static mutex sharesMutex;
+
+    auto key = make_pair(engine->GetDeviceId(), step);
+    {
+        lock_guard<mutex> lock(sharesMutex);
+        auto found = shares.find(key);
+        if (found != shares.end()) {
+            return found->second;
+        }
+    }
 
-int Mega::MegaLCSLen(const vector<int> &baseVals, const vector<int> &latestVals) {
-    // 使用默认最佳值
-    const int step = 256;
+    int length = min(16 * step, 2048);
+    mt19937 rand(step);
+    vector<int> baseVals(length);
+    vector<int> latestVals(length);
+    for (int i = 0; i < length; i++) {
+        baseVals[i] = (int) (rand() % 4);
+        latestVals[i] = (int) (rand() % 4);
+    }
+
+    double deviceSeconds = 0;
+    for (int run = 0; run < 2; run++) {
+        vector<int> verWeights(length, 0);
+        vector<int> horWeights(length, 0);
+        auto start = chrono::high_resolution_clock::now();
+        if (!engine->TryHostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, step)) {
+            return 0;
+        }
+        deviceSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // 和流水线里一样留一个核心给驱动设备的线程
+    vector<int> verWeights(length, 0);
+    vector<int> horWeights(length, 0);
+    auto start = chrono::high_resolution_clock::now();
+    Mega::CpuLCS_WaveFront(baseVals.data(), length, latestVals.data(), length,
+                           verWeights.data(), length, horWeights.data(), length,
+                           step, max(1, (int) thread::hardware_concurrency() - 1));
+    double cpuSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    // 吞吐和时间成反比
+    double share = deviceSeconds / max(deviceSeconds + cpuSeconds, 1e-9);
+
+    lock_guard<mutex> lock(sharesMutex);
+    shares[key] = share;
+    return share;
+}
+
+// Fusion中所有CPU计算的入口，按cpuEngine选择实现
+static void RunCpuLCS(
+        MegaLCSCpuEngine cpuEngine,
+        int *baseVals, int baseValsLength,
+        int *latestVals, int latestValsLength,
+        int *verWeights, int verWeightsLength,
+        int *horWeights, int horWeightsLength) {
+
+    if (cpuEngine == MegaLCSCpuEngine::BitParallel) {
+        Mega::CpuLCS_BitParallel(baseVals, baseValsLength,
+                                 latestVals, latestValsLength,
+                                 verWeights, verWeightsLength,
+                                 horWeights, horWeightsLength);
+        return;
+    }
 
+    if (cpuEngine == MegaLCSCpuEngine::MinMaxSimd) {
+        Mega::CpuLCS_MinMaxSimd(baseVals, baseValsLength,
+                                latestVals, latestValsLength,
+                                verWeights, verWeightsLength,
+                                horWeights, horWeightsLength);
+        return;
+    }
+
+    // 分块版本不用每行扫一遍整个horWeights
+    Mega::CpuLCS_MinMaxBlocked(baseVals, baseValsLength,
+                               latestVals, latestValsLength,
+                               verWeights, verWeightsLength,
+                               horWeights, horWeightsLength);
+}
+
+pair<cl_platform_id, cl_device_id> Mega::GetDefaultGpuDevice() {
     // 获取第一个GPU设备，当然如果CPU够强，也可以
-    auto allDevices = GetAllDevices();
-    cl_platform_id platformId = nullptr;
-    cl_device_id deviceId = nullptr;
-
-    for (const auto &device: allDevices) {
-        if (get<3>(device) == CL_DEVICE_TYPE_GPU) {
-            platformId = get<0>(device);
-            deviceId = get<1>(device);
-            break;
+    // 设备枚举只做一次，后续调用直接复用（静态局部变量的初始化是线程安全的）
+    static const pair<cl_platform_id, cl_device_id> gpuDevice = [] {
+        for (const auto &device: GetAllDevices()) {
+            if (get<3>(device) == CL_DEVICE_TYPE_GPU) {
+                return make_pair(get<0>(device), get<1>(device));
+            }
         }
+        return make_pair((cl_platform_id) nullptr, (cl_device_id) nullptr);
+    }();
+
+    return gpuDevice;
+}
+
+int Mega::GetDefaultStep(cl_platform_id platformId, cl_device_id deviceId) {
+    MegaLCSTuning tuning;
+    if (LoadTuning(platformId, deviceId, tuning)) {
+        return tuning.step;
     }
 
+    // 没有调优结果时使用在Tesla P40上调出的默认值
+    return 256;
+}
+
+int Mega::MegaLCSLen(const vector<int> &baseVals, const vector<int> &latestVals) {
+    auto gpuDevice = GetDefaultGpuDevice();
+    cl_platform_id platformId = gpuDevice.first;
+    cl_device_id deviceId = gpuDevice.second;
+    int step = GetDefaultStep(platformId, deviceId);
+
     auto result = MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, step, false);
     auto &horWeights = get<2>(result);
 
@@ -49,7 +151,8 @@ tuple<bool, vector<int>, vector<int>> Mega::MegaLCS_Fusion(
         const vector<int> &baseVals,
         const vector<int> &latestVals,
         int step,
-        bool isDebug) {
+        bool isDebug,
+        MegaLCSCpuEngine cpuEngine) {
 
     if (!(1 <= step && step <= 256)) {
         throw runtime_error("step is invalid.");
@@ -62,137 +165,71 @@ tuple<bool, vector<int>, vector<int>> Mega::MegaLCS_Fusion(
     // 首先检查是否可以直接使用CpuLCS
     // 如果任意一个序列长度小于等于step，直接使用CPU版本
     if (baseVals.size() <= (size_t) step || latestVals.size() <= (size_t) step) {
-        CpuLCS_MinMax(const_cast<int *>(baseVals.data()), baseVals.size(),
-                      const_cast<int *>(latestVals.data()), latestVals.size(),
-                      verWeights.data(), verWeights.size(),
-                      horWeights.data(), horWeights.size());
+        RunCpuLCS(cpuEngine,
+                  const_cast<int *>(baseVals.data()), baseVals.size(),
+                  const_cast<int *>(latestVals.data()), latestVals.size(),
+                  verWeights.data(), verWeights.size(),
+                  horWeights.data(), horWeights.size());
         return make_tuple(true, verWeights, horWeights);
     }
 
     // 如果没有找到GPU设备，则全部使用CPU处理
+    // MinMax的结果和分块无关，用多线程的tile wavefront占满所有核心
     if (platformId == nullptr || deviceId == nullptr) {
-        CpuLCS_MinMax(const_cast<int *>(baseVals.data()), baseVals.size(),
-                      const_cast<int *>(latestVals.data()), latestVals.size(),
-                      verWeights.data(), verWeights.size(),
-                      horWeights.data(), horWeights.size());
+        if (cpuEngine != MegaLCSCpuEngine::BitParallel) {
+            CpuLCS_WaveFront(const_cast<int *>(baseVals.data()), baseVals.size(),
+                             const_cast<int *>(latestVals.data()), latestVals.size(),
+                             verWeights.data(), verWeights.size(),
+                             horWeights.data(), horWeights.size(),
+                             step);
+            return make_tuple(true, verWeights, horWeights);
+        }
+
+        RunCpuLCS(cpuEngine,
+                  const_cast<int *>(baseVals.data()), baseVals.size(),
+                  const_cast<int *>(latestVals.data()), latestVals.size(),
+                  verWeights.data(), verWeights.size(),
+                  horWeights.data(), horWeights.size());
         return make_tuple(true, verWeights, horWeights);
     }
 
-    // 计算分块信息
-    // baseSliceSize: baseVals可以完整分成多少个step大小的块
-    // baseRemainder: baseVals除以step后的余数（最后一块的大小）
-    // latestSliceSize: latestVals可以完整分成多少个step大小的块
-    // latestRemainder: latestVals除以step后的余数（最后一块的大小）
-    int baseSliceSize = baseVals.size() / step;
-    int baseRemainder = baseVals.size() % step;
-    int latestSliceSize = latestVals.size() / step;
-    int latestRemainder = latestVals.size() % step;
-
-    int baseLTSize = baseSliceSize * step;
-    int latestLTSize = latestSliceSize * step;
-
-    // 处理左上角规整区域（使用HostLCS）
-    // 注意：由于前面的条件判断，这里baseSliceSize和latestSliceSize都必然>0
-    // 但为了代码健壮性，仍然保留这个检查
-    if (baseSliceSize > 0 && latestSliceSize > 0) {
-        vector<int> baseLTVals(baseLTSize);
-        vector<int> verLTWeights(baseLTSize);
-
-        vector<int> latestLTVals(latestLTSize);
-        vector<int> horLTWeights(latestLTSize);
-
-        copy(baseVals.begin(), baseVals.begin() + baseLTSize, baseLTVals.begin());
-        copy(latestVals.begin(), latestVals.begin() + latestLTSize, latestLTVals.begin());
-
-        // 调用HostLCS处理
-        HostLCS_WaveFront(platformId, deviceId,
-                          baseLTVals, latestLTVals,
-                          verLTWeights, horLTWeights,
-                          true, step, isDebug);
-
-        // 将权重结果复制回原权重
-        copy(verLTWeights.begin(), verLTWeights.end(), verWeights.begin());
-        copy(horLTWeights.begin(), horLTWeights.end(), horWeights.begin());
+    // 调优选出了线程粗化内核并且step相同时优先使用它，边缘不满的tile由内核屏蔽
+    // 调优的其他结果（提交方式、内核变体）已经设置在默认引擎上，下面的两条路径都会使用
+    // 线程粗化内核是MinMax，引擎设置成位并行内核（精确DP）时不使用
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    MegaLCSTuning tuning;
+    if (!isDebug && engine->IsReady() && LoadTuning(platformId, deviceId, tuning) &&
+        tuning.threadPerBlock > 0 && tuning.step == step &&
+        engine->GetKernelVariant() != MegaLCSKernelVariant::BitParallel) {
+        engine->HostLCS_WaveFront(const_cast<vector<int> &>(baseVals), const_cast<vector<int> &>(latestVals),
+                                  verWeights, horWeights,
+                                  tuning.threadPerBlock, step, false);
+        return make_tuple(false, verWeights, horWeights);
     }
 
-    // 处理右上角
-    // 当latest有余数时处理（baseSliceSize必然>0，因为前面条件保证）
-    if (latestRemainder > 0) {
-        vector<int> baseRTVals(baseLTSize);
-        vector<int> verRTWeights(baseLTSize);
-
-        vector<int> latestRTVals(latestRemainder);
-        vector<int> horRTWeights(latestRemainder);
-
-        copy(baseVals.begin(), baseVals.begin() + baseRTVals.size(), baseRTVals.begin());
-        copy(latestVals.begin() + latestLTSize, latestVals.end(), latestRTVals.begin());
-
-        // 从已计算的权重中获取verWeights的初始值
-        copy(verWeights.begin(), verWeights.begin() + verRTWeights.size(), verRTWeights.begin());
-        copy(horWeights.begin() + latestLTSize, horWeights.begin() + latestLTSize + horRTWeights.size(),
-             horRTWeights.begin());
-
-        CpuLCS_MinMax(baseRTVals.data(), baseRTVals.size(),
-                      latestRTVals.data(), latestRTVals.size(),
-                      verRTWeights.data(), verRTWeights.size(),
-                      horRTWeights.data(), horRTWeights.size());
-
-        // 回填权重
-        copy(verRTWeights.begin(), verRTWeights.end(), verWeights.begin());
-        copy(horRTWeights.begin(), horRTWeights.end(), horWeights.begin() + latestLTSize);
-    }
-
-    // 处理左下角
-    // 当base有余数时处理（latestSliceSize必然>0，因为前面条件保证）
-    if (baseRemainder > 0) {
-        vector<int> baseLBVals(baseRemainder);
-        vector<int> verLBWeights(baseRemainder);
-
-        vector<int> latestLBVals(latestLTSize);
-        vector<int> horLBWeights(latestLTSize);
-
-        copy(baseVals.begin() + baseLTSize, baseVals.end(), baseLBVals.begin());
-        copy(latestVals.begin(), latestVals.begin() + latestLBVals.size(), latestLBVals.begin());
-
-        copy(verWeights.begin() + baseLTSize, verWeights.end(), verLBWeights.begin());
-        // 从已计算的权重中获取horWeights的初始值
-        copy(horWeights.begin(), horWeights.begin() + horLBWeights.size(), horLBWeights.begin());
-
-        CpuLCS_MinMax(baseLBVals.data(), baseLBVals.size(),
-                      latestLBVals.data(), latestLBVals.size(),
-                      verLBWeights.data(), verLBWeights.size(),
-                      horLBWeights.data(), horLBWeights.size());
-
-        // 更新权重
-        copy(verLBWeights.begin(), verLBWeights.end(), verWeights.begin() + baseLTSize);
-        copy(horLBWeights.begin(), horLBWeights.end(), horWeights.begin());
+    // CPU和设备同时计算：latest方向左边的列交给设备，右边的条带交给CPU的多线程wavefront
+    // 设备每算完一个行带，CPU就拿这个行带的右边界开始算自己的条带，墙钟时间接近两者中较慢的一个
+    // 设备至少保留一列tile；位并行内核的结果是精确DP，不和CPU的MinMax混用
+    if (!isDebug && engine->IsReady() && engine->GetCpuCoExecution() &&
+        engine->GetKernelVariant() != MegaLCSKernelVariant::BitParallel) {
+        int latestTiles = (int) ((latestVals.size() + step - 1) / step);
+        int cpuTiles = min((int) (latestTiles * FusionCpuShare(engine, step) + 0.5), latestTiles - 1);
+        if (cpuTiles > 0) {
+            int baseTiles = (int) ((baseVals.size() + step - 1) / step);
+            int deviceColumns = (latestTiles - cpuTiles) * step;
+            auto weights = RunColumnPipeline({engine, nullptr}, {0, deviceColumns, (int) latestVals.size()},
+                                             baseVals, latestVals, step, min(baseTiles, FusionCoExecutionBands));
+            return make_tuple(false, weights.first, weights.second);
+        }
     }
 
-    // 处理右下角
-    // 当base和latest都有余数时处理
-    if (baseRemainder > 0 && latestRemainder > 0) {
-        vector<int> baseRBVals(baseRemainder);
-        vector<int> verRBWeights(baseRemainder);
-
-        vector<int> latestRBVals(latestRemainder);
-        vector<int> horRBWeights(latestRemainder);
-
-        copy(baseVals.begin() + baseLTSize, baseVals.end(), baseRBVals.begin());
-        copy(latestVals.begin() + latestLTSize, latestVals.end(), latestRBVals.begin());
-
-        // 从左下和右上的已计算的权重中获取初始值
-        copy(verWeights.begin() + baseLTSize, verWeights.end(), verRBWeights.begin());
-        copy(horWeights.begin() + latestLTSize, horWeights.end(), horRBWeights.begin());
-
-        CpuLCS_MinMax(baseRBVals.data(), baseRBVals.size(),
-                      latestRBVals.data(), latestRBVals.size(),
-                      verRBWeights.data(), verRBWeights.size(),
-                      horRBWeights.data(), horRBWeights.size());
-
-        // 回填权重
-        copy(verRBWeights.begin(), verRBWeights.end(), verWeights.begin() + baseLTSize);
-        copy(horRBWeights.begin(), horRBWeights.end(), horWeights.begin() + latestLTSize);
-    }
+    // 长度不是step的倍数时也整体交给设备，边缘不满的tile由内核屏蔽多出来的线程
+    // 整个矩阵只跑一个wavefront，不再在GPU结束后用单个CPU核心计算右边和下边的余数条带
+    // 内核只读base/latest，不需要复制
+    HostLCS_WaveFront(platformId, deviceId,
+                      const_cast<vector<int> &>(baseVals), const_cast<vector<int> &>(latestVals),
+                      verWeights, horWeights,
+                      true, step, isDebug);
 
     // 返回最终的LCS权重
     return make_tuple(false, verWeights, horWeights);
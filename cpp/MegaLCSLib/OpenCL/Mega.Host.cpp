@@ -17,9 +17,52 @@ limitations under the License.
 #include "Mega.h"
 #include <algorithm>
 #include <sstream>
+#include <type_traits>
 
 using namespace std;
 
+// Pipelined模式下每入队这么多个对角带flush一次
+static const int PipelinedFlushBands = 64;
+
+// Persistent模式下每个计算单元常驻的block数
+static const int PersistentBlocksPerComputeUnit = 4;
+
+// int权重的内核实际测试256比较合适，更大的tile使用16位权重的Compact内核
+static const int MaxSharedStep = 256;
+static const int MaxCompactStep = 1024;
+
+// 位并行内核每个tile的work-item数，tile内同时推进的word最多step/32个，不需要每列一个thread
+static const int BitParallelLanes = 32;
+
+// host元素类型对应的MegaLCSElementType
+template<typename T>
+static MegaLCSElementType ElementTypeOf() {
+    if constexpr (is_same_v<T, uint8_t>) {
+        return MegaLCSElementType::UInt8;
+    } else if constexpr (is_same_v<T, uint16_t>) {
+        return MegaLCSElementType::UInt16;
+    } else if constexpr (is_same_v<T, int64_t>) {
+        return MegaLCSElementType::Int64;
+    } else {
+        static_assert(is_same_v<T, int>, "element type must be uint8_t/uint16_t/int/int64_t");
+        return MegaLCSElementType::Int32;
+    }
+}
+
+// 内核源码中__ELEMENT__替换成的OpenCL类型
+static const char *ElementTypeName(MegaLCSElementType elementType) {
+    switch (elementType) {
+        case MegaLCSElementType::UInt8:
+            return "uchar";
+        case MegaLCSElementType::UInt16:
+            return "ushort";
+        case MegaLCSElementType::Int64:
+            return "long";
+        default:
+            return "int";
+    }
+}
+
 void Mega::HostLCS_WaveFront(
         cl_platform_id platformId,
         cl_device_id deviceId,
@@ -31,72 +74,337 @@ void Mega::HostLCS_WaveFront(
         int step,
         bool isDebug) {
 
-    int _baseSliceSize = Valid(baseVals, isSharedVersion, step);
-    int _latestSliceSize = Valid(latestVals, isSharedVersion, step);
-
-    cl_context context = nullptr;
-    cl_command_queue commandQueue = nullptr;
-    cl_program program = nullptr;
-    cl_kernel kernel = nullptr;
-    cl_device_id device = nullptr;
+    HostLCS_WaveFront<int>(platformId, deviceId, baseVals, latestVals, verWeights, horWeights,
+                           isSharedVersion, step, isDebug);
+}
 
-    cl_mem deviceMemObjects[4] = {nullptr, nullptr, nullptr, nullptr};
+template<typename T>
+void Mega::HostLCS_WaveFront(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        vector<T> &baseVals,
+        vector<T> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        bool isSharedVersion,
+        int step,
+        bool isDebug) {
 
-    // 创建上下文
-    cl_context_properties contextProperties[] = {
-            CL_CONTEXT_PLATFORM, (cl_context_properties) platformId,
-            0
-    };
+    // 先校验参数，设备不可用时也和原来一样抛出异常
+    Valid(baseVals.size(), isSharedVersion, step);
+    Valid(latestVals.size(), isSharedVersion, step);
 
-    cl_int err;
-    context = clCreateContext(
-            contextProperties,
-            1,
-            &deviceId,
-            nullptr,
-            nullptr,
-            &err);
-
-    if (err != CL_SUCCESS || context == nullptr) {
-        cerr << "Failed to create OpenCL context for device." << endl;
+    // 同一个设备复用默认引擎，避免每次调用都重建context/program
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    if (!engine->IsReady()) {
         return;
     }
 
-    // 创建命令队列
-    commandQueue = CreateCommandQueue(context, &device);
-    if (commandQueue == nullptr) {
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-        return;
-    }
+    engine->HostLCS_WaveFront(
+            baseVals,
+            latestVals,
+            verWeights,
+            horWeights,
+            isSharedVersion,
+            step,
+            isDebug);
+}
 
-    // 创建程序
-    program = CreateProgram(context, device, isSharedVersion, step, isDebug);
-    if (program == nullptr) {
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
+void Mega::HostLCS_WaveFront(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int threadPerBlock,
+        int step,
+        bool isDebug) {
+
+    ValidCoarsened(baseVals, threadPerBlock, step);
+    ValidCoarsened(latestVals, threadPerBlock, step);
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    if (!engine->IsReady()) {
         return;
     }
 
-    // 创建内核
-    kernel = clCreateKernel(program, "KernelLCS_MinMax", &err);
-    if (err != CL_SUCCESS || kernel == nullptr) {
-        cerr << "Failed to create kernel" << endl;
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
+    engine->HostLCS_WaveFront(
+            baseVals,
+            latestVals,
+            verWeights,
+            horWeights,
+            threadPerBlock,
+            step,
+            isDebug);
+}
+
+void Mega::HostLCS_WaveFront(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int threadPerBlock,
+        int stepBase,
+        int stepLatest,
+        bool isDebug) {
+
+    ValidStepBase(baseVals, stepBase);
+    ValidCoarsened(latestVals, threadPerBlock, stepLatest);
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    if (!engine->IsReady()) {
         return;
     }
 
-    // 创建内存对象
-    if (!CreateMemObjects(
-            context,
-            deviceMemObjects,
-            commandQueue,
+    engine->HostLCS_WaveFront(
             baseVals,
             latestVals,
             verWeights,
-            horWeights)) {
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-        return;
+            horWeights,
+            threadPerBlock,
+            stepBase,
+            stepLatest,
+            isDebug);
+}
+
+void MegaLCSEngine::HostLCS_WaveFront(
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        bool isSharedVersion,
+        int step,
+        bool isDebug) {
+
+    HostLCS_WaveFront<int>(baseVals, latestVals, verWeights, horWeights, isSharedVersion, step, isDebug);
+}
+
+bool MegaLCSEngine::TryHostLCS_WaveFront(
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int step) {
+
+    int _baseSliceSize = Mega::Valid(baseVals.size(), true, step);
+    int _latestSliceSize = Mega::Valid(latestVals.size(), true, step);
+
+    return RunWaveFrontNarrowed(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                                true, 0, step, step, false);
+}
+
+bool MegaLCSEngine::TryHostLCS_WaveFront(
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int step,
+        MegaLCSKernelVariant variant) {
+
+    int _baseSliceSize = Mega::Valid(baseVals.size(), true, step);
+    int _latestSliceSize = Mega::Valid(latestVals.size(), true, step);
+
+    return RunWaveFrontNarrowed(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                                true, 0, step, step, false, variant);
+}
+
+template<typename T>
+void MegaLCSEngine::HostLCS_WaveFront(
+        vector<T> &baseVals,
+        vector<T> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        bool isSharedVersion,
+        int step,
+        bool isDebug) {
+
+    int _baseSliceSize = Mega::Valid(baseVals.size(), isSharedVersion, step);
+    int _latestSliceSize = Mega::Valid(latestVals.size(), isSharedVersion, step);
+
+    RunWaveFrontNarrowed(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                         isSharedVersion, 0, step, step, isDebug);
+}
+
+void MegaLCSEngine::HostLCS_WaveFront(
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int threadPerBlock,
+        int step,
+        bool isDebug) {
+
+    int _baseSliceSize = Mega::ValidCoarsened(baseVals, threadPerBlock, step);
+    int _latestSliceSize = Mega::ValidCoarsened(latestVals, threadPerBlock, step);
+
+    RunWaveFrontNarrowed(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                         true, threadPerBlock, step, step, isDebug);
+}
+
+void MegaLCSEngine::HostLCS_WaveFront(
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int threadPerBlock,
+        int stepBase,
+        int stepLatest,
+        bool isDebug) {
+
+    // 两个方向的slice数各自计算，对角带的划分只依赖slice数
+    int _baseSliceSize = Mega::ValidStepBase(baseVals, stepBase);
+    int _latestSliceSize = Mega::ValidCoarsened(latestVals, threadPerBlock, stepLatest);
+
+    RunWaveFrontNarrowed(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                         true, threadPerBlock, stepLatest, stepBase, isDebug);
+}
+
+template<typename T>
+bool MegaLCSEngine::RunWaveFrontNarrowed(
+        vector<T> &baseVals,
+        vector<T> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int _baseSliceSize,
+        int _latestSliceSize,
+        bool isSharedVersion,
+        int threadPerBlock,
+        int step,
+        int stepBase,
+        bool isDebug,
+        optional<MegaLCSKernelVariant> callVariant) {
+
+    if (!GetElementNarrowing()) {
+        return RunWaveFront(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                            isSharedVersion, threadPerBlock, step, stepBase, isDebug, nullptr, callVariant);
+    }
+
+    // 内核只比较相等，换成稠密的名次不影响结果
+    vector<int> baseRanks;
+    vector<int> latestRanks;
+    int alphabetSize = Mega::RemapDense(baseVals, latestVals, baseRanks, latestRanks);
+
+    switch (Mega::GetNarrowestElementType(alphabetSize)) {
+        case MegaLCSElementType::UInt8: {
+            vector<uint8_t> baseNarrow(baseRanks.begin(), baseRanks.end());
+            vector<uint8_t> latestNarrow(latestRanks.begin(), latestRanks.end());
+            return RunWaveFront(baseNarrow, latestNarrow, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                                isSharedVersion, threadPerBlock, step, stepBase, isDebug, nullptr, callVariant);
+        }
+        case MegaLCSElementType::UInt16: {
+            vector<uint16_t> baseNarrow(baseRanks.begin(), baseRanks.end());
+            vector<uint16_t> latestNarrow(latestRanks.begin(), latestRanks.end());
+            return RunWaveFront(baseNarrow, latestNarrow, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                                isSharedVersion, threadPerBlock, step, stepBase, isDebug, nullptr, callVariant);
+        }
+        default:
+            return RunWaveFront(baseRanks, latestRanks, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                                isSharedVersion, threadPerBlock, step, stepBase, isDebug, nullptr, callVariant);
+    }
+}
+
+template<typename T>
+bool MegaLCSEngine::RunWaveFront(
+        vector<T> &baseVals,
+        vector<T> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int _baseSliceSize,
+        int _latestSliceSize,
+        bool isSharedVersion,
+        int threadPerBlock,
+        int step,
+        int stepBase,
+        bool isDebug,
+        MegaLCSCheckpoints *checkpoints,
+        optional<MegaLCSKernelVariant> callVariant) {
+
+    // 同一个引擎内的内核参数和命令队列是共享的，串行化整个计算过程
+    lock_guard<mutex> lock(engineMutex);
+
+    cl_mem deviceMemObjects[4] = {nullptr, nullptr, nullptr, nullptr};
+
+    // 线程粗化的内核只支持逐带调度，检查点需要逐带调度，tile内是位并行（精确回溯）或MinMax
+    // 调用方指定了变体时只影响这一次计算，不改变引擎的设置
+    MegaLCSKernelVariant variant = threadPerBlock == 0 && checkpoints == nullptr
+                                   ? callVariant.value_or(kernelVariant)
+                                   : MegaLCSKernelVariant::Shared;
+    if (checkpoints != nullptr && checkpoints->isExact) {
+        variant = MegaLCSKernelVariant::BitParallel;
+    }
+
+    // 长度不是step的倍数时，常驻内核不处理边缘不满的tile，回退到共享内存版本（结果相同）
+    bool isRagged = baseVals.size() % step != 0 || latestVals.size() % step != 0;
+    if (isRagged && variant == MegaLCSKernelVariant::Persistent) {
+        variant = MegaLCSKernelVariant::Shared;
+    }
+
+    // 位并行内核按32位word处理，并且要求输入边界是合法的DP边界，否则回退到共享内存版本
+    if (variant == MegaLCSKernelVariant::BitParallel &&
+        (step % 32 != 0 ||
+         !Mega::IsBitParallelFrame(verWeights.data(), verWeights.size(), horWeights.data(), horWeights.size()))) {
+        variant = MegaLCSKernelVariant::Shared;
+    }
+
+    // 超过256的tile优先使用16位权重的Compact内核
+    if (step > MaxSharedStep && threadPerBlock == 0) {
+        variant = MegaLCSKernelVariant::Compact;
+    }
+
+    // 16位的tile内权重要求输入边界是合法的DP边界，否则回退到共享内存版本
+    if (variant == MegaLCSKernelVariant::Compact &&
+        !Mega::IsBitParallelFrame(verWeights.data(), verWeights.size(), horWeights.data(), horWeights.size())) {
+        variant = MegaLCSKernelVariant::Shared;
+    }
+
+    // 每列一个thread，tile宽度不能超过设备的work-group上限
+    if (step > MaxSharedStep && threadPerBlock == 0) {
+        size_t maxWorkGroupSize = 0;
+        cl_int infoErr = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t),
+                                         &maxWorkGroupSize, nullptr);
+        if (infoErr != CL_SUCCESS || maxWorkGroupSize < (size_t) step) {
+            cerr << "step exceeds the max work-group size of the device." << endl;
+            return false;
+        }
+    }
+
+    // 打包的边界只用于逐带调度的共享内存内核，调试打印和检查点读取的都是原始格式
+    // 和Compact一样要求输入边界是合法的DP边界，否则tile输出的差值可能超出{0,1}，无法写回打包的格式
+    vector<uint32_t> verRecords;
+    vector<uint32_t> horRecords;
+    bool isPacked = packedWeights &&
+                    variant == MegaLCSKernelVariant::Shared &&
+                    isSharedVersion && threadPerBlock == 0 &&
+                    checkpoints == nullptr && !isDebug &&
+                    Mega::IsBitParallelFrame(verWeights.data(), verWeights.size(),
+                                             horWeights.data(), horWeights.size()) &&
+                    Mega::PackWeights(verWeights, step, verRecords) &&
+                    Mega::PackWeights(horWeights, step, horRecords);
+
+    // 获取缓存的内核，第一次使用该step时才编译
+    cl_kernel kernel = GetKernel(variant, isSharedVersion, threadPerBlock, step, stepBase, isDebug, ElementTypeOf<T>(),
+                                 isPacked);
+    if (kernel == nullptr) {
+        return false;
     }
 
+    // 创建内存对象
+    bool isCreated = isPacked
+                     ? Mega::CreateMemObjects(context, deviceMemObjects, commandQueue, baseVals, latestVals,
+                                              verRecords.data(), verRecords.size() * sizeof(uint32_t),
+                                              horRecords.data(), horRecords.size() * sizeof(uint32_t))
+                     : Mega::CreateMemObjects(context, deviceMemObjects, commandQueue, baseVals, latestVals,
+                                              verWeights, horWeights);
+    if (!isCreated) {
+        Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+        return false;
+    }
+
+    cl_int err;
+
     // 设置内核参数 (gBases,gLatests,gVerWeights,gHorWeights)
     err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &deviceMemObjects[0]);
     err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &deviceMemObjects[1]);
@@ -109,23 +417,179 @@ void Mega::HostLCS_WaveFront(
     err |= clSetKernelArg(kernel, 4, sizeof(int), &baseSliceSize);
     err |= clSetKernelArg(kernel, 5, sizeof(int), &latestSliceSize);
 
+    // 逐带调度的内核按实际长度屏蔽边缘tile里多出来的行和列，位并行内核的长度在gCorners之后
+    int baseLength = baseVals.size();
+    int latestLength = latestVals.size();
+    if (variant == MegaLCSKernelVariant::BitParallel) {
+        err |= clSetKernelArg(kernel, 9, sizeof(int), &baseLength);
+        err |= clSetKernelArg(kernel, 10, sizeof(int), &latestLength);
+    } else if (threadPerBlock > 0 ||
+               variant == MegaLCSKernelVariant::Shared || variant == MegaLCSKernelVariant::Compact) {
+        err |= clSetKernelArg(kernel, 8, sizeof(int), &baseLength);
+        err |= clSetKernelArg(kernel, 9, sizeof(int), &latestLength);
+    }
+
     if (err != CL_SUCCESS) {
         cerr << "Error setting kernel arguments." << endl;
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-        return;
+        Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+        return false;
+    }
+
+    // 位并行内核需要每个tile左上角的权重，由左边（或上边）的tile在设备端传递，每个base slice一个
+    cl_mem cornerMem = nullptr;
+    if (variant == MegaLCSKernelVariant::BitParallel) {
+        vector<int> zeros(_baseSliceSize, 0);
+        cornerMem = clCreateBuffer(
+                context,
+                CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                _baseSliceSize * sizeof(int),
+                zeros.data(),
+                &err);
+
+        if (err == CL_SUCCESS) {
+            err = clSetKernelArg(kernel, 8, sizeof(cl_mem), &cornerMem);
+        }
+
+        if (err != CL_SUCCESS) {
+            cerr << "Error creating corner buffer." << endl;
+            if (cornerMem != nullptr) {
+                clReleaseMemObject(cornerMem);
+            }
+            Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+            return false;
+        }
+    }
+
+    // 每个block的thread数：线程粗化内核由调用方指定，位并行内核固定BitParallelLanes个，其余每列一个thread
+    int blockThreads = threadPerBlock > 0 ? threadPerBlock
+                       : variant == MegaLCSKernelVariant::BitParallel ? BitParallelLanes : step;
+
+    // persistent内核一次启动走完所有tile，否则由host逐个对角带启动
+    bool isCompleted = variant == MegaLCSKernelVariant::Persistent
+                       ? EnqueuePersistent(kernel, _baseSliceSize, step)
+                       : EnqueueWaveFrontBands(kernel, deviceMemObjects, _baseSliceSize, _latestSliceSize,
+                                               baseVals.size(), latestVals.size(),
+                                               blockThreads, step, isDebug,
+                                               checkpoints, cornerMem);
+
+    if (cornerMem != nullptr) {
+        clReleaseMemObject(cornerMem);
+    }
+
+    if (!isCompleted) {
+        // 已经入队的检查点读取可能还在写host内存，等它们结束后才能返回
+        if (checkpoints != nullptr) {
+            clFinish(commandQueue);
+        }
+        Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+        return false;
+    }
+
+    // 打包的结果直接读回记录，在host解码
+    if (isPacked) {
+        err = clEnqueueReadBuffer(
+                commandQueue,
+                deviceMemObjects[2],
+                CL_TRUE,
+                0,
+                verRecords.size() * sizeof(uint32_t),
+                verRecords.data(),
+                0,
+                nullptr,
+                nullptr);
+
+        err |= clEnqueueReadBuffer(
+                commandQueue,
+                deviceMemObjects[3],
+                CL_TRUE,
+                0,
+                horRecords.size() * sizeof(uint32_t),
+                horRecords.data(),
+                0,
+                nullptr,
+                nullptr);
+
+        Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+
+        if (err != CL_SUCCESS) {
+            cerr << "Error reading result buffer." << endl;
+            return false;
+        }
+
+        Mega::UnpackWeights(verRecords, step, verWeights);
+        Mega::UnpackWeights(horRecords, step, horWeights);
+        return true;
+    }
+
+    // 读取最终结果
+    err = clEnqueueReadBuffer(
+            commandQueue,
+            deviceMemObjects[2],
+            CL_TRUE,
+            0,
+            baseVals.size() * sizeof(int),
+            verWeights.data(),
+            0,
+            nullptr,
+            nullptr);
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error reading result buffer." << endl;
+        Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+        return false;
     }
 
+    err = clEnqueueReadBuffer(
+            commandQueue,
+            deviceMemObjects[3],
+            CL_TRUE,
+            0,
+            latestVals.size() * sizeof(int),
+            horWeights.data(),
+            0,
+            nullptr,
+            nullptr);
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error reading result buffer." << endl;
+        Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+        return false;
+    }
+
+    Mega::Cleanup(nullptr, nullptr, nullptr, nullptr, deviceMemObjects);
+    return true;
+}
+
+bool MegaLCSEngine::EnqueueWaveFrontBands(
+        cl_kernel kernel,
+        cl_mem deviceMemObjects[4],
+        int _baseSliceSize,
+        int _latestSliceSize,
+        size_t baseLength,
+        size_t latestLength,
+        int threadPerBlock,
+        int step,
+        bool isDebug,
+        MegaLCSCheckpoints *checkpoints,
+        cl_mem cornerMem) {
+
+    cl_int err;
+
     // Queue the kernel up for execution across the array
     int totalWave = _baseSliceSize + _latestSliceSize - 1;
 
+    // 队列是in-order的，后一个对角带的内核一定在前一个完成后才开始，不需要每带都clFinish
+    // clSetKernelArg的值在入队时已经被捕获，入队后修改参数不影响之前的内核
+    bool isPipelined = submitMode == MegaLCSSubmitMode::Pipelined && !isDebug;
+
     // wavefront算法类似波，沿着对角带的方向前进
     for (int outerWaveFrontBand = 0;
          outerWaveFrontBand < totalWave;
          outerWaveFrontBand++) {
 
         // 首先：共享内存版本STEP个thread每Block，block内元素处理和线程一一对应
-        size_t threadPerBlock = step;
-        size_t localWorkSize_ThreadPerBlock[] = {threadPerBlock};
+        // 线程粗化版本每个thread负责STEP/threadPerBlock列
+        size_t localWorkSize_ThreadPerBlock[] = {(size_t) threadPerBlock};
 
         // latest是X轴/水平方向，sliceID最小值
         int latestSliceIDMin = max(0, outerWaveFrontBand - (_baseSliceSize - 1));
@@ -155,8 +619,7 @@ void Mega::HostLCS_WaveFront(
 
         if (err != CL_SUCCESS) {
             cerr << "Error setting kernel arguments." << endl;
-            Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-            return;
+            return false;
         }
 
         // 执行内核
@@ -173,25 +636,77 @@ void Mega::HostLCS_WaveFront(
 
         if (err != CL_SUCCESS) {
             cerr << "Error queuing kernel for execution." << endl;
-            Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-            return;
+            return false;
         }
 
-        err = clFinish(commandQueue);
-        if (err != CL_SUCCESS) {
-            cerr << "Error queuing kernel for execution Finish." << endl;
-            Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-            return;
+        // 检查点：in-order队列保证读到的是这个对角带完成后的权重，非阻塞读取不打断流水
+        int nextWave = outerWaveFrontBand + 1;
+        if (checkpoints != nullptr && nextWave < totalWave && nextWave % checkpoints->interval == 0) {
+            int checkpointId = nextWave / checkpoints->interval;
+            err = clEnqueueReadBuffer(
+                    commandQueue,
+                    deviceMemObjects[2],
+                    CL_FALSE,
+                    0,
+                    baseLength * sizeof(int),
+                    checkpoints->vers[checkpointId].data(),
+                    0,
+                    nullptr,
+                    nullptr);
+
+            err |= clEnqueueReadBuffer(
+                    commandQueue,
+                    deviceMemObjects[3],
+                    CL_FALSE,
+                    0,
+                    latestLength * sizeof(int),
+                    checkpoints->hors[checkpointId].data(),
+                    0,
+                    nullptr,
+                    nullptr);
+
+            if (cornerMem != nullptr && !checkpoints->corners.empty()) {
+                err |= clEnqueueReadBuffer(
+                        commandQueue,
+                        cornerMem,
+                        CL_FALSE,
+                        0,
+                        _baseSliceSize * sizeof(int),
+                        checkpoints->corners[checkpointId].data(),
+                        0,
+                        nullptr,
+                        nullptr);
+            }
+
+            if (err != CL_SUCCESS) {
+                cerr << "Error reading checkpoint buffer." << endl;
+                return false;
+            }
+        }
+
+        if (!isPipelined) {
+            err = clFinish(commandQueue);
+            if (err != CL_SUCCESS) {
+                cerr << "Error queuing kernel for execution Finish." << endl;
+                return false;
+            }
+        } else if ((outerWaveFrontBand + 1) % PipelinedFlushBands == 0) {
+            // 分批flush，让设备在host继续入队的同时就开始执行
+            err = clFlush(commandQueue);
+            if (err != CL_SUCCESS) {
+                cerr << "Error flushing command queue." << endl;
+                return false;
+            }
         }
 
         if (isDebug) {
-            vector<int> newVerWeights(baseVals.size());
+            vector<int> newVerWeights(baseLength);
             err = clEnqueueReadBuffer(
                     commandQueue,
                     deviceMemObjects[2],
                     CL_TRUE,
                     0,
-                    baseVals.size() * sizeof(int),
+                    baseLength * sizeof(int),
                     newVerWeights.data(),
                     0,
                     nullptr,
@@ -199,17 +714,16 @@ void Mega::HostLCS_WaveFront(
 
             if (err != CL_SUCCESS) {
                 cerr << "Error reading result buffer." << endl;
-                Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-                return;
+                return false;
             }
 
-            vector<int> newHorWeights(latestVals.size());
+            vector<int> newHorWeights(latestLength);
             err = clEnqueueReadBuffer(
                     commandQueue,
                     deviceMemObjects[3],
                     CL_TRUE,
                     0,
-                    latestVals.size() * sizeof(int),
+                    latestLength * sizeof(int),
                     newHorWeights.data(),
                     0,
                     nullptr,
@@ -217,8 +731,7 @@ void Mega::HostLCS_WaveFront(
 
             if (err != CL_SUCCESS) {
                 cerr << "Error reading result buffer." << endl;
-                Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-                return;
+                return false;
             }
 
             // 打印结果
@@ -238,63 +751,138 @@ void Mega::HostLCS_WaveFront(
         } // end of if (isDebug)
     } // end of for
 
-    // 读取最终结果
-    err = clEnqueueReadBuffer(
-            commandQueue,
-            deviceMemObjects[2],
-            CL_TRUE,
-            0,
-            baseVals.size() * sizeof(int),
-            verWeights.data(),
-            0,
-            nullptr,
-            nullptr);
+    if (isPipelined) {
+        // 整个wavefront只在这里同步一次，同时检查执行期间的错误
+        err = clFinish(commandQueue);
+        if (err != CL_SUCCESS) {
+            cerr << "Error queuing kernel for execution Finish." << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MegaLCSEngine::EnqueuePersistent(
+        cl_kernel kernel,
+        int _baseSliceSize,
+        int step) {
+
+    cl_int err;
+
+    // 常驻的block个数：每个计算单元放几个block，不超过base方向的slice数
+    cl_uint computeUnits = 1;
+    err = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, nullptr);
+    if (err != CL_SUCCESS || computeUnits == 0) {
+        computeUnits = 1;
+    }
+
+    size_t totalBlock = min((size_t) _baseSliceSize, (size_t) computeUnits * PersistentBlocksPerComputeUnit);
+
+    // 行计数器和每行进度都从0开始
+    // rowCounter[0]：下一个要领取的base行
+    // rowProgress[b]：第b行已经完成的tile数，下一行据此判断上方的tile是否就绪
+    vector<int> zeros(_baseSliceSize + 1, 0);
+    cl_mem rowCounter = clCreateBuffer(
+            context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int),
+            zeros.data(),
+            &err);
 
     if (err != CL_SUCCESS) {
-        cerr << "Error reading result buffer." << endl;
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-        return;
+        cerr << "Error creating row counter buffer." << endl;
+        return false;
     }
 
-    err = clEnqueueReadBuffer(
+    cl_mem rowProgress = clCreateBuffer(
+            context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            _baseSliceSize * sizeof(int),
+            zeros.data(),
+            &err);
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error creating row progress buffer." << endl;
+        clReleaseMemObject(rowCounter);
+        return false;
+    }
+
+    err = clSetKernelArg(kernel, 6, sizeof(cl_mem), &rowCounter);
+    err |= clSetKernelArg(kernel, 7, sizeof(cl_mem), &rowProgress);
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error setting kernel arguments." << endl;
+        clReleaseMemObject(rowCounter);
+        clReleaseMemObject(rowProgress);
+        return false;
+    }
+
+    // 只启动一次，所有对角带在设备端推进
+    size_t localWorkSize_ThreadPerBlock[] = {(size_t) step};
+    size_t globalWorkSize_AllThreadInOneGrid[] = {totalBlock * step};
+
+    err = clEnqueueNDRangeKernel(
             commandQueue,
-            deviceMemObjects[3],
-            CL_TRUE,
-            0,
-            latestVals.size() * sizeof(int),
-            horWeights.data(),
+            kernel,
+            1,
+            nullptr,
+            globalWorkSize_AllThreadInOneGrid,
+            localWorkSize_ThreadPerBlock,
             0,
             nullptr,
             nullptr);
 
+    if (err == CL_SUCCESS) {
+        err = clFinish(commandQueue);
+    }
+
+    clReleaseMemObject(rowCounter);
+    clReleaseMemObject(rowProgress);
+
     if (err != CL_SUCCESS) {
-        cerr << "Error reading result buffer." << endl;
-        Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
-        return;
+        cerr << "Error queuing persistent kernel for execution." << endl;
+        return false;
     }
 
-    Cleanup(context, commandQueue, program, kernel, deviceMemObjects);
+    return true;
 }
 
+template<typename T>
 bool Mega::CreateMemObjects(
         cl_context context,
         cl_mem memObjects[4],
         cl_command_queue commandQueue,
-        const vector<int> &bases,
-        const vector<int> &latests,
+        const vector<T> &bases,
+        const vector<T> &latests,
         vector<int> &verWeights,
         vector<int> &horWeights) {
 
+    return CreateMemObjects(context, memObjects, commandQueue, bases, latests,
+                            verWeights.data(), bases.size() * sizeof(int),
+                            horWeights.data(), latests.size() * sizeof(int));
+}
+
+template<typename T>
+bool Mega::CreateMemObjects(
+        cl_context context,
+        cl_mem memObjects[4],
+        cl_command_queue commandQueue,
+        const vector<T> &bases,
+        const vector<T> &latests,
+        const void *verData,
+        size_t verBytes,
+        const void *horData,
+        size_t horBytes) {
+
     cl_int err;
-    size_t INT_BASE_AXIS_BYTES = bases.size() * sizeof(int);
-    size_t INT_LATEST_AXIS_BYTES = latests.size() * sizeof(int);
 
-    // 创建输入缓冲区
+    // 创建输入缓冲区，按元素的实际宽度上传
     memObjects[0] = clCreateBuffer(
             context,
             CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-            INT_BASE_AXIS_BYTES,
-            const_cast<int *>(bases.data()),
+            bases.size() * sizeof(T),
+            const_cast<T *>(bases.data()),
             &err);
 
     if (err != CL_SUCCESS) {
@@ -305,8 +893,8 @@ bool Mega::CreateMemObjects(
     memObjects[1] = clCreateBuffer(
             context,
             CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-            INT_LATEST_AXIS_BYTES,
-            const_cast<int *>(latests.data()),
+            latests.size() * sizeof(T),
+            const_cast<T *>(latests.data()),
             &err);
 
     if (err != CL_SUCCESS) {
@@ -318,7 +906,7 @@ bool Mega::CreateMemObjects(
     memObjects[2] = clCreateBuffer(
             context,
             CL_MEM_READ_WRITE,
-            INT_BASE_AXIS_BYTES,
+            verBytes,
             nullptr,
             &err);
 
@@ -330,7 +918,7 @@ bool Mega::CreateMemObjects(
     memObjects[3] = clCreateBuffer(
             context,
             CL_MEM_READ_WRITE,
-            INT_LATEST_AXIS_BYTES,
+            horBytes,
             nullptr,
             &err);
 
@@ -345,8 +933,8 @@ bool Mega::CreateMemObjects(
             memObjects[2],
             CL_TRUE,
             0,
-            INT_BASE_AXIS_BYTES,
-            verWeights.data(),
+            verBytes,
+            verData,
             0,
             nullptr,
             nullptr);
@@ -361,8 +949,8 @@ bool Mega::CreateMemObjects(
             memObjects[3],
             CL_TRUE,
             0,
-            INT_LATEST_AXIS_BYTES,
-            horWeights.data(),
+            horBytes,
+            horData,
             0,
             nullptr,
             nullptr);
@@ -380,9 +968,42 @@ cl_program Mega::CreateProgram(
         cl_device_id device,
         bool IsSharedVersion,
         int _step,
-        bool isDebug) {
+        bool isDebug,
+        MegaLCSKernelVariant variant,
+        int threadPerBlock,
+        MegaLCSElementType elementType,
+        bool isPackedWeights,
+        int _stepBase,
+        PairLayout layout) {
 
     string code = IsSharedVersion ? Mega::KernelLCS_Shared : ""; // 简化处理，实际应包含寄存器版本
+    if (layout == PairLayout::Batch || layout == PairLayout::OneToMany) {
+        code = Mega::KernelLCS_Batch;
+    } else if (variant == MegaLCSKernelVariant::Persistent) {
+        code = Mega::KernelLCS_Persistent;
+    } else if (variant == MegaLCSKernelVariant::BitParallel) {
+        code = Mega::KernelLCS_BitParallel;
+    } else if (variant == MegaLCSKernelVariant::Compact) {
+        code = Mega::KernelLCS_Compact;
+    } else if (threadPerBlock > 0) {
+        code = Mega::KernelLCS_Coarsened;
+    }
+
+    // 替换 __THREADS__ 宏
+    string threadsStr = to_string(threadPerBlock);
+    size_t threadsPos = 0;
+    while ((threadsPos = code.find("__THREADS__", threadsPos)) != string::npos) {
+        code.replace(threadsPos, 11, threadsStr);
+        threadsPos += threadsStr.length();
+    }
+
+    // 替换 __STEP_BASE__ 宏，只有线程粗化的内核有，0表示正方形tile
+    string stepBaseStr = to_string(_stepBase > 0 ? _stepBase : _step);
+    size_t stepBasePos = 0;
+    while ((stepBasePos = code.find("__STEP_BASE__", stepBasePos)) != string::npos) {
+        code.replace(stepBasePos, 13, stepBaseStr);
+        stepBasePos += stepBaseStr.length();
+    }
 
     // 替换 __STEP__ 宏
     string stepStr = to_string(_step);
@@ -392,29 +1013,73 @@ cl_program Mega::CreateProgram(
         pos += stepStr.length();
     }
 
-    const char *source = code.c_str();
-    size_t sourceSize = code.length();
+    // 替换 __ELEMENT__ 宏
+    string elementStr = ElementTypeName(elementType);
+    size_t elementPos = 0;
+    while ((elementPos = code.find("__ELEMENT__", elementPos)) != string::npos) {
+        code.replace(elementPos, 11, elementStr);
+        elementPos += elementStr.length();
+    }
 
-    cl_int err;
-    cl_program program = clCreateProgramWithSource(
-            context,
-            1,
-            &source,
-            &sourceSize,
-            &err);
+    // 编译选项
+    string compileOptions = isDebug ? "-DDEBUG" : "";
+    if (isPackedWeights) {
+        compileOptions += compileOptions.empty() ? "-DPACKED_WEIGHTS" : " -DPACKED_WEIGHTS";
+    }
+    if (layout == PairLayout::OneToMany) {
+        compileOptions += compileOptions.empty() ? "-DSHARED_BASE" : " -DSHARED_BASE";
+    }
 
-    if (err != CL_SUCCESS || program == nullptr) {
-        cerr << "Failed to create CL program from source." << endl;
-        return nullptr;
+    // 优先使用磁盘缓存的二进制，命中时完全跳过源码编译
+    string cacheKey = GetProgramCacheKey(device, code, _step, compileOptions);
+    cl_program program = LoadProgramBinary(context, device, cacheKey, compileOptions);
+    if (program != nullptr) {
+        return program;
     }
 
-    // 编译选项
-    const char *compileOptions = isDebug ? "-DDEBUG" : nullptr;
-    err = clBuildProgram(
+    // 其次使用构建时预编译的SPIR-V，调试版本需要-DDEBUG，只能走源码，预编译的只有int元素
+    if (IsSharedVersion && !isDebug && variant == MegaLCSKernelVariant::Shared && threadPerBlock == 0 &&
+        elementType == MegaLCSElementType::Int32 && !isPackedWeights) {
+        program = CreateProgramFromEmbeddedIL(context, device, _step);
+    }
+
+    if (program == nullptr) {
+        const char *source = code.c_str();
+        size_t sourceSize = code.length();
+
+        cl_int err;
+        program = clCreateProgramWithSource(
+                context,
+                1,
+                &source,
+                &sourceSize,
+                &err);
+
+        if (err != CL_SUCCESS || program == nullptr) {
+            cerr << "Failed to create CL program from source." << endl;
+            return nullptr;
+        }
+
+        if (!BuildProgram(program, device, compileOptions)) {
+            clReleaseProgram(program);
+            return nullptr;
+        }
+    }
+
+    SaveProgramBinary(program, cacheKey);
+    return program;
+}
+
+bool Mega::BuildProgram(
+        cl_program program,
+        cl_device_id device,
+        const string &compileOptions) {
+
+    cl_int err = clBuildProgram(
             program,
             1,
             &device,
-            compileOptions,
+            compileOptions.empty() ? nullptr : compileOptions.c_str(),
             nullptr,
             nullptr);
 
@@ -442,11 +1107,10 @@ cl_program Mega::CreateProgram(
         cerr << buildLog.data() << endl;
         cerr << "==========================================================" << endl;
 
-        clReleaseProgram(program);
-        return nullptr;
+        return false;
     }
 
-    return program;
+    return true;
 }
 
 void Mega::Cleanup(
@@ -557,13 +1221,21 @@ int Mega::Valid(
         bool IsSharedVersion,
         int step) {
 
-    if (originalValues.empty()) {
+    return Valid(originalValues.size(), IsSharedVersion, step);
+}
+
+int Mega::Valid(
+        size_t length,
+        bool IsSharedVersion,
+        int step) {
+
+    if (length == 0) {
         throw runtime_error("originalValues.Length is invalid.");
     }
 
     if (IsSharedVersion) {
-        // 实际测试256比较合适，再大测试用例错误
-        if (!(1 <= step && step <= 256)) {
+        // 超过256时由Compact内核计算，还要受设备work-group上限的约束
+        if (!(1 <= step && step <= MaxCompactStep)) {
             throw runtime_error("step is invalid.");
         }
     } else {
@@ -576,13 +1248,63 @@ int Mega::Valid(
         }
     }
 
-    // 不允许step的值超过_originalArray的长度，没有意义
-    if (originalValues.size() < (size_t) step)
-        throw invalid_argument("N must be less than or equal to the length of the original array.");
+    // 长度不需要是step的倍数，最后一个slice由内核按实际长度屏蔽多出来的线程
+    return (length + step - 1) / step;
+}
 
-    if (originalValues.size() % step != 0) {
-        throw invalid_argument("originalValues.Length % step != 0");
+int Mega::ValidCoarsened(
+        const vector<int> &originalValues,
+        int threadPerBlock,
+        int step) {
+
+    if (originalValues.empty()) {
+        throw runtime_error("originalValues.Length is invalid.");
     }
 
-    return originalValues.size() / step;
+    if (!(1 <= threadPerBlock && threadPerBlock <= 256)) {
+        throw runtime_error("threadPerBlock is invalid.");
+    }
+
+    // 每个线程的列放在寄存器里，列数太多会溢出到私有内存
+    // bases/vers两个共享数组，step最大2048时共16KB
+    if (!(threadPerBlock <= step && step <= 2048) ||
+        step % threadPerBlock != 0 ||
+        step / threadPerBlock > 32) {
+        throw runtime_error("step is invalid.");
+    }
+
+    // 长度不需要是step的倍数，最后一个slice由内核按实际长度屏蔽多出来的列
+    return (originalValues.size() + step - 1) / step;
+}
+
+int Mega::ValidStepBase(
+        const vector<int> &originalValues,
+        int stepBase) {
+
+    if (originalValues.empty()) {
+        throw runtime_error("originalValues.Length is invalid.");
+    }
+
+    // base方向只有bases/vers两个共享数组，和ValidCoarsened的列数上限相同
+    if (!(1 <= stepBase && stepBase <= 2048)) {
+        throw runtime_error("stepBase is invalid.");
+    }
+
+    // 长度不需要是stepBase的倍数，最后一个slice由内核按实际长度屏蔽多出来的行
+    return (originalValues.size() + stepBase - 1) / stepBase;
 }
+
+// 支持的元素类型，int的HostLCS_WaveFront和RunWaveFront（Traceback使用）也由这里实例化
+#define MEGALCS_INSTANTIATE_ELEMENT(T) \
+    template void Mega::HostLCS_WaveFront<T>( \
+            cl_platform_id, cl_device_id, vector<T> &, vector<T> &, vector<int> &, vector<int> &, bool, int, bool); \
+    template void MegaLCSEngine::HostLCS_WaveFront<T>( \
+            vector<T> &, vector<T> &, vector<int> &, vector<int> &, bool, int, bool); \
+    template bool MegaLCSEngine::RunWaveFront<T>( \
+            vector<T> &, vector<T> &, vector<int> &, vector<int> &, int, int, bool, int, int, int, bool, \
+            MegaLCSCheckpoints *, optional<MegaLCSKernelVariant>);
+
+MEGALCS_INSTANTIATE_ELEMENT(uint8_t)
+MEGALCS_INSTANTIATE_ELEMENT(uint16_t)
+MEGALCS_INSTANTIATE_ELEMENT(int)
+MEGALCS_INSTANTIATE_ELEMENT(int64_t)
@@ -0,0 +1,243 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+/*
+文本文件的读取
+1. 两个文件都做内存映射（MegaLCSMappedFile），token直接引用映射的内存，不复制
+2. 文件按线程数切成块，块的起点挪到分隔符之后，保证token不跨块
+   第一遍每个线程用SIMD找分隔符统计自己块内的token数，前缀和得到每块在结果数组里的起点
+3. 第二遍每个线程对token做归一化的hash，在分片加锁的共享表里驻留成ID，直接写到结果数组的对应位置
+   两个文件共用一张表，所以相同的token在两边是同一个ID
+归一化（忽略空白、大小写）只影响hash和比较，不修改原文
+ */
+
+namespace {
+    struct TokenKey {
+        string_view text;
+        uint64_t hash;
+    };
+
+    inline bool IsIgnoredSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline char FoldCase(char c) {
+        return c >= 'A' && c <= 'Z' ? (char) (c - 'A' + 'a') : c;
+    }
+
+    // 分片加锁的驻留表，ID全局递增，保证两个文件的ID落在同一个稠密区间
+    class TokenInterner {
+    public:
+        explicit TokenInterner(const MegaLCSTokenizeOptions &options)
+                : options(options),
+                  shards(ShardCount) {
+            for (auto &shard: shards) {
+                shard.tokens = unordered_map<TokenKey, int, KeyHash, KeyEqual>(16, KeyHash(), KeyEqual{&this->options});
+            }
+        }
+
+        // FNV-1a 64位，归一化后的字节参与计算
+        uint64_t Hash(string_view text) const {
+            uint64_t hash = 14695981039346656037ULL;
+            for (char c: text) {
+                if (options.ignoreWhitespace && IsIgnoredSpace(c)) {
+                    continue;
+                }
+                hash ^= (unsigned char) (options.ignoreCase ? FoldCase(c) : c);
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        int Intern(string_view text) {
+            TokenKey key{text, Hash(text)};
+            Shard &shard = shards[key.hash % ShardCount];
+
+            lock_guard<mutex> lock(shard.shardMutex);
+            auto it = shard.tokens.find(key);
+            if (it != shard.tokens.end()) {
+                return it->second;
+            }
+
+            int id = nextId.fetch_add(1);
+            shard.tokens.emplace(key, id);
+            return id;
+        }
+
+        int Size() const {
+            return nextId.load();
+        }
+
+    private:
+        static const int ShardCount = 64;
+
+        struct KeyHash {
+            size_t operator()(const TokenKey &key) const {
+                return (size_t) key.hash;
+            }
+        };
+
+        // 按归一化后的内容比较，hash相同不代表token相同
+        struct KeyEqual {
+            const MegaLCSTokenizeOptions *options;
+
+            bool operator()(const TokenKey &a, const TokenKey &b) const {
+                if (a.hash != b.hash) {
+                    return false;
+                }
+
+                size_t i = 0;
+                size_t j = 0;
+                while (true) {
+                    if (options->ignoreWhitespace) {
+                        while (i < a.text.size() && IsIgnoredSpace(a.text[i])) i++;
+                        while (j < b.text.size() && IsIgnoredSpace(b.text[j])) j++;
+                    }
+
+                    if (i == a.text.size() || j == b.text.size()) {
+                        return i == a.text.size() && j == b.text.size();
+                    }
+
+                    char ca = options->ignoreCase ? FoldCase(a.text[i]) : a.text[i];
+                    char cb = options->ignoreCase ? FoldCase(b.text[j]) : b.text[j];
+                    if (ca != cb) {
+                        return false;
+                    }
+                    i++;
+                    j++;
+                }
+            }
+        };
+
+        struct Shard {
+            mutex shardMutex;
+            unordered_map<TokenKey, int, KeyHash, KeyEqual> tokens;
+        };
+
+        MegaLCSTokenizeOptions options;
+        vector<Shard> shards;
+        atomic<int> nextId{0};
+    };
+
+    // 在threadCount个线程上执行task(0..taskCount-1)
+    template<typename Task>
+    void RunParallel(int taskCount, int threadCount, const Task &task) {
+        atomic<int> nextTask(0);
+        auto worker = [&] {
+            for (int t = nextTask.fetch_add(1); t < taskCount; t = nextTask.fetch_add(1)) {
+                task(t);
+            }
+        };
+
+        vector<thread> threads;
+        for (int t = 1; t < min(taskCount, threadCount); t++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &th: threads) {
+            th.join();
+        }
+    }
+
+    // 把一个映射好的文件转换成ID数组
+    vector<int> Tokenize(const MegaLCSMappedFile &file, TokenInterner &interner,
+                         const MegaLCSTokenizeOptions &options, int threadCount) {
+        const char *data = file.data;
+        size_t size = file.size;
+        if (size == 0) {
+            return {};
+        }
+
+        char delimiter = options.delimiter;
+
+        // 块太小时线程的开销大于收益
+        const size_t MinChunkBytes = 1 << 16;
+        int chunkCount = (int) max<size_t>(1, min<size_t>(threadCount, size / MinChunkBytes));
+
+        // 块的起点挪到名义位置之前最近的分隔符之后（第一块从0开始）
+        vector<size_t> chunkBegins(chunkCount + 1, size);
+        chunkBegins[0] = 0;
+        for (int c = 1; c < chunkCount; c++) {
+            size_t nominal = size * c / chunkCount;
+            size_t from = max(chunkBegins[c - 1], nominal - 1);
+            size_t found = from + Mega::FindByte(data + from, size - from, delimiter);
+            chunkBegins[c] = found < size ? found + 1 : size;
+        }
+
+        // 第一遍：每块的token数，最后一个token可以没有结尾的分隔符
+        vector<size_t> chunkTokens(chunkCount, 0);
+        RunParallel(chunkCount, threadCount, [&](int c) {
+            size_t position = chunkBegins[c];
+            size_t end = chunkBegins[c + 1];
+            size_t count = 0;
+            while (position < end) {
+                position += Mega::FindByte(data + position, end - position, delimiter) + 1;
+                count++;
+            }
+            chunkTokens[c] = count;
+        });
+
+        vector<size_t> chunkOffsets(chunkCount + 1, 0);
+        for (int c = 0; c < chunkCount; c++) {
+            chunkOffsets[c + 1] = chunkOffsets[c] + chunkTokens[c];
+        }
+
+        // 第二遍：hash、驻留，直接写到结果数组
+        vector<int> ids(chunkOffsets[chunkCount]);
+        RunParallel(chunkCount, threadCount, [&](int c) {
+            size_t position = chunkBegins[c];
+            size_t end = chunkBegins[c + 1];
+            size_t output = chunkOffsets[c];
+            while (position < end) {
+                size_t length = Mega::FindByte(data + position, end - position, delimiter);
+                ids[output++] = interner.Intern(string_view(data + position, length));
+                position += length + 1;
+            }
+        });
+
+        return ids;
+    }
+}
+
+MegaLCSTokenizedFiles Mega::MegaLCS_LoadFiles(
+        const string &basePath,
+        const string &latestPath,
+        const MegaLCSTokenizeOptions &options) {
+
+    int threadCount = options.threadCount > 0
+                      ? options.threadCount
+                      : max(1, (int) thread::hardware_concurrency());
+
+    // 驻留表引用映射的内存，两个文件在驻留结束前都要保持映射
+    MegaLCSMappedFile baseFile(basePath);
+    MegaLCSMappedFile latestFile(latestPath);
+    TokenInterner interner(options);
+
+    MegaLCSTokenizedFiles result;
+    result.baseVals = Tokenize(baseFile, interner, options, threadCount);
+    result.latestVals = Tokenize(latestFile, interner, options, threadCount);
+    result.alphabetSize = interner.Size();
+    return result;
+}
@@ -0,0 +1,167 @@
+#include "Mega.h"
+
+using std::string;
+
+// __STEP__ MUST = [1->256]
+// __ELEMENT__ = uchar/ushort/int/long，base/latest的元素类型（MegaLCSElementType）
+// SHARED_BASE：一对多版本（HostLCS_OneToMany），所有对共用gBaseOffsets[0..1]的base
+const string Mega::KernelLCS_Batch = R"(
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+批量版本：很多对互不相关的(base, latest)一次启动，常驻的block循环领取下一对
+第p对的元素和权重是gBases/gVerWeights的[gBaseOffsets[p], gBaseOffsets[p+1])，latest方向同理
+gOrder是领取的顺序（host按单元数从大到小排好），大的先开始，最后剩下的都是小的
+
+一对由一个block独占，按行优先的顺序逐个计算tile：
+tile(b,l)的左边是同一个block刚算完的tile(b,l-1)，vers一直留在共享内存里
+上边是tile(b-1,l)写回的hors，写和读是同一个线程，不需要block之间同步
+tile内的计算和KernelLCS_MinMax完全相同，边缘不满的tile同样只计算前tileRows行、tileCols列
+
+定义SHARED_BASE时是一对多版本：同一个base和很多个候选latest比较，base只上传一次
+左边界的初始权重都是0，每一行tile开始时vers直接清零，gVerWeights不使用（可以是NULL）
+ */
+__kernel void KernelLCS_Batch(
+    __global __ELEMENT__ *gBases,
+    __global __ELEMENT__ *gLatests,
+    __global int *gVerWeights,
+    __global int *gHorWeights,
+    __global const int *gBaseOffsets,
+    __global const int *gLatestOffsets,
+    __global const int *gOrder,
+    const int pairCount,
+    __global int *gNextPair,
+    __global int *gLengths) {
+
+    const int threadIdx = get_local_id(0);
+
+    // 共享内存
+    __local __ELEMENT__ bases[__STEP__];
+    __local __ELEMENT__ latests[__STEP__];
+    __local int vers[__STEP__];
+    __local int hors[__STEP__];
+    __local int pairSlot[1];
+
+    while (true) {
+        // 领取下一对
+        if (threadIdx == 0) {
+            pairSlot[0] = atomic_inc(gNextPair);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const int slot = pairSlot[0];
+
+        // 所有线程读完之后线程0才能领取下一对
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (slot >= pairCount) {
+            break;
+        }
+
+        const int p = gOrder[slot];
+#ifdef SHARED_BASE
+        const int baseBegin = gBaseOffsets[0];
+        const int baseLength = gBaseOffsets[1] - baseBegin;
+#else
+        const int baseBegin = gBaseOffsets[p];
+        const int baseLength = gBaseOffsets[p + 1] - baseBegin;
+#endif
+        const int latestBegin = gLatestOffsets[p];
+        const int latestLength = gLatestOffsets[p + 1] - latestBegin;
+
+        // 空序列的LCS是0，权重保持初始值
+        if (baseLength == 0 || latestLength == 0) {
+            if (threadIdx == 0) {
+                gLengths[p] = 0;
+            }
+            continue;
+        }
+
+        int lastCols = 0;
+        for (int baseOffset = 0; baseOffset < baseLength; baseOffset += __STEP__) {
+            const int tileRows = min(__STEP__, baseLength - baseOffset);
+            const int baseValGlobalOffset = baseBegin + baseOffset + threadIdx;
+
+            if (threadIdx < tileRows) {
+                bases[threadIdx] = gBases[baseValGlobalOffset];
+#ifdef SHARED_BASE
+                vers[threadIdx] = 0;
+#else
+                vers[threadIdx] = gVerWeights[baseValGlobalOffset];
+#endif
+            }
+
+            for (int latestOffset = 0; latestOffset < latestLength; latestOffset += __STEP__) {
+                const int tileCols = min(__STEP__, latestLength - latestOffset);
+                const int latestValGlobalOffset = latestBegin + latestOffset + threadIdx;
+
+                if (threadIdx < tileCols) {
+                    latests[threadIdx] = gLatests[latestValGlobalOffset];
+                    hors[threadIdx] = gHorWeights[latestValGlobalOffset];
+                }
+
+                // 等待所有线程完成数据加载
+                barrier(CLK_LOCAL_MEM_FENCE);
+
+                for (int innerWaveFrontLine = 0;
+                         innerWaveFrontLine < tileRows + tileCols - 1;
+                         innerWaveFrontLine++) {
+                    int l = threadIdx;
+                    int b = innerWaveFrontLine - l;
+
+                    if (b >= 0 && b < tileRows && l < tileCols) {
+                        int leftWeight = vers[b];
+                        int topWeight = hors[l];
+
+                        // 匹配时取min(左值, 上值)+1，不匹配时取max(左值, 上值)
+                        if (bases[b] == latests[l]) {
+                            hors[l] = min(leftWeight, topWeight) + 1;
+                        } else {
+                            hors[l] = max(leftWeight, topWeight);
+                        }
+
+                        vers[b] = hors[l];
+                    }
+
+                    // 等待当前wavefront的所有线程完成计算
+                    barrier(CLK_LOCAL_MEM_FENCE);
+                } // end for innerWaveFrontLine
+
+                if (threadIdx < tileCols) {
+                    gHorWeights[latestValGlobalOffset] = hors[threadIdx];
+                }
+                lastCols = tileCols;
+            } // end for latestOffset
+
+#ifndef SHARED_BASE
+            // 一行tile结束，vers写回
+            if (threadIdx < tileRows) {
+                gVerWeights[baseValGlobalOffset] = vers[threadIdx];
+            }
+#endif
+
+            // 下一行加载bases/vers之前，所有线程都要读完这一行
+            barrier(CLK_LOCAL_MEM_FENCE);
+        } // end for baseOffset
+
+        // 最后一个tile是右下角，hors的最后一个有效值就是LCS长度
+        if (threadIdx == 0) {
+            gLengths[p] = hors[lastCols - 1];
+        }
+    } // end while
+}
+)";
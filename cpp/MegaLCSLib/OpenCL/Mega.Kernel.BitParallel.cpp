@@ -0,0 +1,275 @@
+#include "Mega.h"
+
+using std::string;
+
+// __STEP__ MUST = 32,64,...,256
+// __ELEMENT__ = uchar/ushort/int/long，base/latest的元素类型（MegaLCSElementType）
+const string Mega::KernelLCS_BitParallel = R"(
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#define WORDS (__STEP__ / 32)
+
+// 每个tile的work-item数，和host的BitParallelLanes一致
+#define LANES 32
+
+// 每个word通道每步推进的行数
+#define ROWS_PER_STEP 8
+
+// 匹配掩码的散列表，开放寻址，最多一半是满的
+#define TABLE_SIZE (__STEP__ * 2)
+
+/*
+位并行版本，调度方式和KernelLCS_MinMax相同（每个block一个tile），但是每个block只有LANES个线程，
+多一个参数gCorners用来传递tile左上角的权重
+
+tile内latest方向的横向差值Δh编码成WORDS个32位word：第j位为1表示Δh==0
+每一行：U = V & M[base]，V = (V + U) | (V - U)，加法的进位就是纵向差值Δv
+前WORDS个线程各持有一个word，线程w在第s步处理第(s-w)组的ROWS_PER_STEP行，进位通过carries[b]交给线程w+1，
+一个tile只需要STEP/ROWS_PER_STEP+WORDS-1步（STEP=256时39次barrier），每步一个线程推进ROWS_PER_STEP*32个单元
+tile内可以同时推进的word最多WORDS个，所以每个tile只用LANES个线程，其余的工作（加载、掩码、边界）按LANES跨步分摊
+
+匹配掩码按符号构建，不逐对比较：
+  latest的每一列插入散列表，同一个值的列得到同一个代表列rep，列j把自己的位或进symbols[rep]
+  base的每一行在散列表里查找自己的值，没有出现在latest里的行掩码为0
+  每个线程只做O(STEP/LANES)次散列，而不是STEP*STEP/LANES次比较
+
+tile左上角权重：
+  tile(b,l)的左上角等于tile(b,l-1)读入的hors最后一个值，由它写入gCorners[b]
+  tile(b,0)的左上角等于tile(b-1,0)读入的vers最后一个值，由它写入gCorners[b]
+  tile(0,0)取min(vers[0], hors[0])，和CpuLCS_BitParallel相同
+
+边缘不满的tile（tileRows行、tileCols列）补齐到STEP*STEP：
+  多出来的列不进散列表（匹配位为0）、Δh为0（V的位为1），进位原样穿过，不改变Δv
+  多出来的行匹配掩码为0、Δv为0，V保持不变
+所以补齐的部分不影响有效区域，最后一行/列取第tileRows-1行、第tileCols-1列的边界
+ */
+
+// 值在散列表里的起始槽位，64位的值高低两半都参与
+int Hash(__ELEMENT__ val) {
+    const ulong key = (ulong) val;
+    uint h = (uint) key ^ (uint) (key >> 32);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return (int) (h % TABLE_SIZE);
+}
+
+__kernel void KernelLCS_BitParallel(
+    __global __ELEMENT__ *gBases,
+    __global __ELEMENT__ *gLatests,
+    __global int *gVerWeights,
+    __global int *gHorWeights,
+    const int baseSliceSize,
+    const int latestSliceSize,
+    const int outerW,
+    const int totalThread,
+    __global int *gCorners,
+    const int baseLength,
+    const int latestLength) {
+
+    const int threadGIdx = get_global_id(0);
+    const int blockIdx = get_group_id(0);
+    const int threadIdx = get_local_id(0);
+
+    // 丢弃不在范围内的线程，做边界保护
+    if (threadGIdx >= totalThread) {
+        return;
+    }
+
+    // 共享内存
+    __local __ELEMENT__ bases[__STEP__];
+    __local __ELEMENT__ latests[__STEP__];
+    __local int vers[__STEP__];
+    __local int hors[__STEP__];
+    __local uint symbols[__STEP__ * WORDS];
+    __local int table[TABLE_SIZE];
+    __local int rowSymbols[__STEP__];
+    __local uint carries[__STEP__];
+    __local uint words[WORDS];
+    __local int wordOffsets[WORDS];
+    __local int cornerSlot[1];
+
+    const int latestSliceIDMin = max(0, outerW - (baseSliceSize - 1));
+    const int latestSliceID = latestSliceIDMin + blockIdx;
+    const int baseSliceID = outerW - latestSliceID;
+
+    const int baseGlobalBegin = baseSliceID * __STEP__;
+    const int latestGlobalBegin = latestSliceID * __STEP__;
+
+    const int tileRows = min(__STEP__, baseLength - baseGlobalBegin);
+    const int tileCols = min(__STEP__, latestLength - latestGlobalBegin);
+
+    for (int i = threadIdx; i < __STEP__; i += LANES) {
+        if (i < tileRows) {
+            bases[i] = gBases[baseGlobalBegin + i];
+            vers[i] = gVerWeights[baseGlobalBegin + i];
+        }
+        if (i < tileCols) {
+            latests[i] = gLatests[latestGlobalBegin + i];
+            hors[i] = gHorWeights[latestGlobalBegin + i];
+        }
+    }
+
+    for (int i = threadIdx; i < TABLE_SIZE; i += LANES) {
+        table[i] = -1;
+    }
+
+    // 等待所有线程完成数据加载
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // 先读出自己的左上角，再把右边和下边tile的左上角写进去
+    if (threadIdx == 0) {
+        cornerSlot[0] = (baseSliceID == 0 && latestSliceID == 0)
+                        ? min(vers[0], hors[0])
+                        : gCorners[baseSliceID];
+
+        gCorners[baseSliceID] = hors[tileCols - 1];
+        if (latestSliceID == 0 && baseSliceID + 1 < baseSliceSize) {
+            gCorners[baseSliceID + 1] = vers[tileRows - 1];
+        }
+    }
+
+    // latest的每一列插入散列表，第一个占到槽位的列是这个值的代表列，由它清零自己的掩码
+    int columnSymbols[WORDS];
+    for (int k = 0; k < WORDS; k++) {
+        const int j = threadIdx + k * LANES;
+        columnSymbols[k] = -1;
+        if (j >= tileCols) {
+            continue;
+        }
+
+        const __ELEMENT__ val = latests[j];
+        for (int h = Hash(val); ; h = h + 1 == TABLE_SIZE ? 0 : h + 1) {
+            const int owner = atomic_cmpxchg(&table[h], -1, j);
+            if (owner == -1) {
+                for (int w = 0; w < WORDS; w++) {
+                    symbols[j * WORDS + w] = 0;
+                }
+                columnSymbols[k] = j;
+                break;
+            }
+            if (latests[owner] == val) {
+                columnSymbols[k] = owner;
+                break;
+            }
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    const int corner = cornerSlot[0];
+    const int lastRowLeft = vers[tileRows - 1];
+    const int lastColTop = hors[tileCols - 1];
+
+    // 每一列把自己的位或进代表列的掩码
+    for (int k = 0; k < WORDS; k++) {
+        const int j = threadIdx + k * LANES;
+        if (columnSymbols[k] >= 0) {
+            atomic_or(&symbols[columnSymbols[k] * WORDS + j / 32], 1u << (j % 32));
+        }
+    }
+
+    // 每一行查找自己的代表列，并把左边界转换成Δv
+    for (int b = threadIdx; b < __STEP__; b += LANES) {
+        int symbol = -1;
+        if (b < tileRows) {
+            const __ELEMENT__ val = bases[b];
+            for (int h = Hash(val); table[h] != -1; h = h + 1 == TABLE_SIZE ? 0 : h + 1) {
+                if (latests[table[h]] == val) {
+                    symbol = table[h];
+                    break;
+                }
+            }
+            carries[b] = (uint) (vers[b] - (b == 0 ? corner : vers[b - 1]));
+        } else {
+            carries[b] = 0;
+        }
+        rowSymbols[b] = symbol;
+    }
+
+    // 前WORDS个线程把上边界转换成初始的V
+    uint vword = 0;
+    if (threadIdx < WORDS) {
+        for (int c = 0; c < 32; c++) {
+            const int j = threadIdx * 32 + c;
+            const int previous = j == 0 ? corner : hors[j - 1];
+            if (j >= tileCols || hors[j] == previous) {
+                vword |= 1u << c;
+            }
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // 同一步里线程w处理第s-w组，线程w+1处理第s-w-1组（线程w上一步写的），不会冲突
+    // 最后一个word的进位就是右边界的Δv，由它直接累加出新的vers
+    int right = lastColTop;
+    for (int innerWaveFrontLine = 0;
+             innerWaveFrontLine < __STEP__ / ROWS_PER_STEP + WORDS - 1;
+             innerWaveFrontLine++) {
+        const int group = innerWaveFrontLine - threadIdx;
+
+        if (threadIdx < WORDS && group >= 0 && group < __STEP__ / ROWS_PER_STEP) {
+            for (int b = group * ROWS_PER_STEP; b < (group + 1) * ROWS_PER_STEP; b++) {
+                const int symbol = rowSymbols[b];
+                const uint u = symbol < 0 ? 0 : vword & symbols[symbol * WORDS + threadIdx];
+                const uint partial = vword + u;
+                const uint sum = partial + carries[b];
+                const uint carry = (partial < vword) | (sum < partial);
+                vword = sum | (vword - u);
+
+                if (threadIdx == WORDS - 1) {
+                    right += (int) carry;
+                    vers[b] = right;
+                } else {
+                    carries[b] = carry;
+                }
+            }
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    } // end for innerWaveFrontLine
+
+    // 最后一行：左边界加上横向差值的前缀和，先求每个word之前的总和
+    if (threadIdx < WORDS) {
+        words[threadIdx] = ~vword;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (threadIdx == 0) {
+        int offset = lastRowLeft;
+        for (int w = 0; w < WORDS; w++) {
+            wordOffsets[w] = offset;
+            offset += popcount(words[w]);
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int i = threadIdx; i < __STEP__; i += LANES) {
+        if (i < tileRows) {
+            gVerWeights[baseGlobalBegin + i] = vers[i];
+        }
+        if (i < tileCols) {
+            const int c = i % 32;
+            const uint lowBits = c == 31 ? 0xffffffffu : ((1u << (c + 1)) - 1u);
+            gHorWeights[latestGlobalBegin + i] = wordOffsets[i / 32] + popcount(words[i / 32] & lowBits);
+        }
+    }
+}
+)";
@@ -0,0 +1,292 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <random>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/*
+编译后内核的磁盘缓存
+部分驱动编译KernelLCS_Shared需要几百毫秒，短生命周期的命令行任务每次都要付出这个代价
+第一次编译后通过CL_PROGRAM_BINARIES取出二进制写到磁盘，下次用clCreateProgramWithBinary直接加载
+文件格式：第一行是完整的key（用于排除hash碰撞），后面是驱动返回的原始二进制
+ */
+
+static mutex kernelCacheDirMutex;
+static bool kernelCacheDirOverridden = false;
+static string kernelCacheDirOverride;
+
+// FNV-1a 64位hash，只用于生成key和文件名，不要求抗碰撞
+string Mega::HashCacheKey(const string &text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c: text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    stringstream stream;
+    stream << hex << setw(16) << setfill('0') << hash;
+    return stream.str();
+}
+
+string Mega::GetDeviceInfoString(cl_device_id device, cl_device_info param) {
+    size_t size = 0;
+    if (clGetDeviceInfo(device, param, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+        return "";
+    }
+
+    vector<char> value(size);
+    if (clGetDeviceInfo(device, param, size, value.data(), nullptr) != CL_SUCCESS) {
+        return "";
+    }
+
+    return string(value.data());
+}
+
+void Mega::SetKernelCacheDir(const string &dir) {
+    lock_guard<mutex> lock(kernelCacheDirMutex);
+    kernelCacheDirOverridden = true;
+    kernelCacheDirOverride = dir;
+}
+
+string Mega::GetKernelCacheDir() {
+    lock_guard<mutex> lock(kernelCacheDirMutex);
+    if (kernelCacheDirOverridden) {
+        return kernelCacheDirOverride;
+    }
+
+    const char *env = getenv("MEGALCS_KERNEL_CACHE_DIR");
+    if (env != nullptr) {
+        return env;
+    }
+
+    error_code ec;
+    fs::path tempDir = fs::temp_directory_path(ec);
+    if (ec) {
+        return "";
+    }
+
+    return (tempDir / "MegaLCS" / "kernels").string();
+}
+
+string Mega::GetProgramCacheKey(
+        cl_device_id device,
+        const string &code,
+        int _step,
+        const string &compileOptions) {
+
+    stringstream key;
+    key << "device=" << GetDeviceInfoString(device, CL_DEVICE_NAME)
+        << ";driver=" << GetDeviceInfoString(device, CL_DRIVER_VERSION)
+        << ";version=" << GetDeviceInfoString(device, CL_DEVICE_VERSION)
+        << ";step=" << _step
+        << ";options=" << compileOptions
+        << ";source=" << HashCacheKey(code);
+    return key.str();
+}
+
+cl_program Mega::LoadProgramBinary(
+        cl_context context,
+        cl_device_id device,
+        const string &cacheKey,
+        const string &compileOptions) {
+
+    string cacheDir = GetKernelCacheDir();
+    if (cacheDir.empty()) {
+        return nullptr;
+    }
+
+    fs::path file = fs::path(cacheDir) / (HashCacheKey(cacheKey) + ".bin");
+    ifstream in(file, ios::binary);
+    if (!in) {
+        return nullptr;
+    }
+
+    // 第一行必须和key完全一致
+    string storedKey;
+    getline(in, storedKey);
+    if (storedKey != cacheKey) {
+        return nullptr;
+    }
+
+    vector<unsigned char> binary((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    if (binary.empty()) {
+        return nullptr;
+    }
+
+    const unsigned char *binaryData = binary.data();
+    size_t binarySize = binary.size();
+    cl_int binaryStatus;
+    cl_int err;
+    cl_program program = clCreateProgramWithBinary(
+            context,
+            1,
+            &device,
+            &binarySize,
+            &binaryData,
+            &binaryStatus,
+            &err);
+
+    // 驱动升级等原因导致二进制失效时，静默回退到重新编译
+    if (err != CL_SUCCESS || binaryStatus != CL_SUCCESS || program == nullptr) {
+        if (program != nullptr) {
+            clReleaseProgram(program);
+        }
+        return nullptr;
+    }
+
+    err = clBuildProgram(
+            program,
+            1,
+            &device,
+            compileOptions.empty() ? nullptr : compileOptions.c_str(),
+            nullptr,
+            nullptr);
+
+    if (err != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return nullptr;
+    }
+
+    return program;
+}
+
+void Mega::SaveProgramBinary(
+        cl_program program,
+        const string &cacheKey) {
+
+    string cacheDir = GetKernelCacheDir();
+    if (cacheDir.empty()) {
+        return;
+    }
+
+    // 单设备程序，只有一份二进制
+    size_t binarySize = 0;
+    cl_int err = clGetProgramInfo(
+            program,
+            CL_PROGRAM_BINARY_SIZES,
+            sizeof(size_t),
+            &binarySize,
+            nullptr);
+
+    if (err != CL_SUCCESS || binarySize == 0) {
+        return;
+    }
+
+    vector<unsigned char> binary(binarySize);
+    unsigned char *binaryData = binary.data();
+    err = clGetProgramInfo(
+            program,
+            CL_PROGRAM_BINARIES,
+            sizeof(unsigned char *),
+            &binaryData,
+            nullptr);
+
+    if (err != CL_SUCCESS) {
+        return;
+    }
+
+    // 多个进程同时写同一个key时不会读到半个文件
+    string contents = cacheKey + "\n";
+    contents.append(binary.begin(), binary.end());
+    WriteFileAtomically((fs::path(cacheDir) / (HashCacheKey(cacheKey) + ".bin")).string(), contents);
+}
+
+bool Mega::WriteFileAtomically(const string &path, const string &contents) {
+    fs::path file(path);
+    error_code ec;
+    fs::create_directories(file.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    // 先写同一目录下的临时文件再改名，改名是原子的
+    // 临时文件名取random_device，不同进程里相同的线程id不会撞名
+    fs::path tempFile = file.parent_path() / (file.filename().string() + "." + to_string(random_device()()) + ".tmp");
+
+    {
+        ofstream out(tempFile, ios::binary | ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(contents.data(), (streamsize) contents.size());
+        if (!out) {
+            out.close();
+            fs::remove(tempFile, ec);
+            return false;
+        }
+    }
+
+    fs::rename(tempFile, file, ec);
+    if (ec) {
+        fs::remove(tempFile, ec);
+        return false;
+    }
+    return true;
+}
+
+cl_program Mega::CreateProgramFromEmbeddedIL(
+        cl_context context,
+        cl_device_id device,
+        int _step) {
+
+    const unsigned char *ilData = nullptr;
+    size_t ilSize = 0;
+    if (!GetEmbeddedKernelIL(_step, &ilData, &ilSize)) {
+        return nullptr;
+    }
+
+    // 设备不支持IL（CL_DEVICE_IL_VERSION为空）时回退到源码编译
+    if (GetDeviceInfoString(device, CL_DEVICE_IL_VERSION).empty()) {
+        return nullptr;
+    }
+
+    cl_int err;
+    cl_program program = clCreateProgramWithIL(context, ilData, ilSize, &err);
+    if (err != CL_SUCCESS || program == nullptr) {
+        return nullptr;
+    }
+
+    if (!BuildProgram(program, device, "")) {
+        clReleaseProgram(program);
+        return nullptr;
+    }
+
+    return program;
+}
+
+#ifndef MEGALCS_EMBED_KERNEL_IL
+
+// 没有开启MEGALCS_EMBED_KERNEL_IL时没有内嵌的SPIR-V，总是走缓存或源码编译
+bool Mega::GetEmbeddedKernelIL(
+        int _step,
+        const unsigned char **data,
+        size_t *size) {
+    (void) _step;
+    *data = nullptr;
+    *size = 0;
+    return false;
+}
+
+#endif
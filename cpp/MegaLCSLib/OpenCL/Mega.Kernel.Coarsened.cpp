@@ -0,0 +1,130 @@
+#include "Mega.h"
+
+using std::string;
+
+// __STEP__ MUST = [1->2048], __THREADS__ MUST = [1->256]
+// __ELEMENT__ = uchar/ushort/int/long，base/latest的元素类型（MegaLCSElementType）
+// __STEP__ % __THREADS__ == 0，每个线程负责 __STEP__ / __THREADS__ 列
+// __STEP_BASE__ MUST = [1->2048]，tile的行数，正方形tile时等于 __STEP__
+const string Mega::KernelLCS_Coarsened = R"(
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#define COLS (__STEP__ / __THREADS__)
+
+/*
+线程粗化版本，参数和调度方式与KernelLCS_MinMax完全相同
+KernelLCS_MinMax每个线程一列，tile内需要2*STEP-1次barrier，对角线两端大部分线程空闲
+这里每个线程负责连续的COLS列，latests/hors放在寄存器里，
+线程t在第w步处理第b=w-t行：从左边线程拿到vers[b]，依次算完自己的COLS列，再把vers[b]交给右边的线程
+tile内只需要STEP+THREADS-1次barrier，每次barrier之间每个线程做COLS个单元
+
+tile可以是矩形：__STEP_BASE__行（base方向）*__STEP__列（latest方向），正方形时两者相同
+base方向的slice按__STEP_BASE__计算偏移，latest方向按__STEP__，对角带的划分只依赖两个方向的slice数
+长度不是tile大小的倍数时，最后一行/列的tile不满，按baseLength/latestLength屏蔽多出来的行和列
+ */
+__kernel void KernelLCS_Coarsened(
+    __global __ELEMENT__ *gBases,
+    __global __ELEMENT__ *gLatests,
+    __global int *gVerWeights,
+    __global int *gHorWeights,
+    const int baseSliceSize,
+    const int latestSliceSize,
+    const int outerW,
+    const int totalThread,
+    const int baseLength,
+    const int latestLength) {
+
+    const int threadGIdx = get_global_id(0);
+    const int blockIdx = get_group_id(0);
+    const int threadIdx = get_local_id(0);
+
+    // 丢弃不在范围内的线程，做边界保护
+    if (threadGIdx >= totalThread) {
+        return;
+    }
+
+    // 共享内存：base方向由所有线程共享，latest方向各线程私有
+    __local __ELEMENT__ bases[__STEP_BASE__];
+    __local int vers[__STEP_BASE__];
+
+    // 寄存器
+    __ELEMENT__ latests[COLS];
+    int hors[COLS];
+
+    const int latestSliceIDMin = max(0, outerW - (baseSliceSize - 1));
+    const int latestSliceID = latestSliceIDMin + blockIdx;
+    const int baseSliceID = outerW - latestSliceID;
+
+    const int baseGlobalOffset = baseSliceID * __STEP_BASE__;
+    const int latestGlobalOffset = latestSliceID * __STEP__ + threadIdx * COLS;
+
+    // 边缘tile的有效行数（block内相同，所有线程执行同样次数的barrier），以及本线程的有效列数
+    const int tileRows = min(__STEP_BASE__, baseLength - baseGlobalOffset);
+    const int threadCols = clamp(latestLength - latestGlobalOffset, 0, COLS);
+
+    // 线程数少于STEP，按步长协作搬迁
+    for (int i = threadIdx; i < tileRows; i += __THREADS__) {
+        bases[i] = gBases[baseGlobalOffset + i];
+        vers[i] = gVerWeights[baseGlobalOffset + i];
+    }
+
+    for (int c = 0; c < threadCols; c++) {
+        latests[c] = gLatests[latestGlobalOffset + c];
+        hors[c] = gHorWeights[latestGlobalOffset + c];
+    }
+
+    // 等待所有线程完成数据加载
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // 同一步里线程t写vers[w-t]，线程t+1读vers[w-t-1]（线程t上一步写的），不会冲突
+    // 没有有效列的线程都在有效列的右边，它们把vers[b]原样传下去
+    for (int innerWaveFrontLine = 0;
+             innerWaveFrontLine < tileRows + __THREADS__ - 1;
+             innerWaveFrontLine++) {
+        int b = innerWaveFrontLine - threadIdx;
+
+        if (b >= 0 && b < tileRows) {
+            __ELEMENT__ baseVal = bases[b];
+            int leftWeight = vers[b];
+
+            // 和KernelLCS_MinMax逐单元相同的递推，只是一行内的列由同一个线程顺序完成
+            for (int c = 0; c < threadCols; c++) {
+                int topWeight = hors[c];
+                if (baseVal == latests[c]) {
+                    hors[c] = min(leftWeight, topWeight) + 1;
+                } else {
+                    hors[c] = max(leftWeight, topWeight);
+                }
+                leftWeight = hors[c];
+            }
+
+            vers[b] = leftWeight;
+        }
+
+        // 等待当前wavefront的所有线程完成计算
+        barrier(CLK_LOCAL_MEM_FENCE);
+    } // end for innerWaveFrontLine
+
+    for (int i = threadIdx; i < tileRows; i += __THREADS__) {
+        gVerWeights[baseGlobalOffset + i] = vers[i];
+    }
+
+    for (int c = 0; c < threadCols; c++) {
+        gHorWeights[latestGlobalOffset + c] = hors[c];
+    }
+}
+)";
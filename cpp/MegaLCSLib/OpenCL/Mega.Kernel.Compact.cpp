@@ -0,0 +1,121 @@
+#include "Mega.h"
+
+using std::string;
+
+// __STEP__ MUST = [1->1024]，同时不超过设备的CL_DEVICE_MAX_WORK_GROUP_SIZE
+// __ELEMENT__ = uchar/ushort/int/long，base/latest的元素类型（MegaLCSElementType）
+// 和KernelLCS_Shared的tile内计算完全相同，共享内存里的权重是相对tile基准值的16位数
+const string Mega::KernelLCS_Compact = R"(
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+tile的输入边界是合法的DP边界时（相邻差值0或1），vers和hors都从各自的第一个值开始不减，
+所以tileBase = min(vers[0], hors[0])是整个tile的最小值，
+tile内每一步最多在max(左值, 上值)的基础上加1，所有权重都不超过 tileBase + 3*STEP
+共享内存只保存相对tileBase的ushort，vers/hors占用的共享内存减半，STEP可以到1024
+边缘不满的tile和KernelLCS_MinMax一样只计算前tileRows行、tileCols列
+ */
+__kernel void KernelLCS_Compact(
+    __global __ELEMENT__ *gBases,
+    __global __ELEMENT__ *gLatests,
+    __global int *gVerWeights,
+    __global int *gHorWeights,
+    const int baseSliceSize,
+    const int latestSliceSize,
+    const int outerW,
+    const int totalThread,
+    const int baseLength,
+    const int latestLength) {
+
+    const int threadGIdx = get_global_id(0);
+    const int blockIdx = get_group_id(0);
+    const int threadIdx = get_local_id(0);
+
+    // 丢弃不在范围内的线程，做边界保护
+    if (threadGIdx >= totalThread) {
+        return;
+    }
+
+    // 共享内存
+    __local __ELEMENT__ bases[__STEP__];
+    __local __ELEMENT__ latests[__STEP__];
+    __local ushort vers[__STEP__];
+    __local ushort hors[__STEP__];
+
+    const int latestSliceIDMin = max(0, outerW - (baseSliceSize - 1));
+    const int latestSliceID = latestSliceIDMin + blockIdx;
+    const int baseSliceID = outerW - latestSliceID;
+
+    const int baseGlobalOffset = baseSliceID * __STEP__;
+    const int latestGlobalOffset = latestSliceID * __STEP__;
+
+    const int baseValGlobalOffset = baseGlobalOffset + threadIdx;
+    const int latestValGlobalOffset = latestGlobalOffset + threadIdx;
+
+    const int tileRows = min(__STEP__, baseLength - baseGlobalOffset);
+    const int tileCols = min(__STEP__, latestLength - latestGlobalOffset);
+
+    // 所有线程读同一个地址，不需要额外的同步
+    const int tileBase = min(gVerWeights[baseGlobalOffset], gHorWeights[latestGlobalOffset]);
+
+    if (threadIdx < tileRows) {
+        bases[threadIdx] = gBases[baseValGlobalOffset];
+        vers[threadIdx] = (ushort) (gVerWeights[baseValGlobalOffset] - tileBase);
+    }
+
+    if (threadIdx < tileCols) {
+        latests[threadIdx] = gLatests[latestValGlobalOffset];
+        hors[threadIdx] = (ushort) (gHorWeights[latestValGlobalOffset] - tileBase);
+    }
+
+    // 等待所有线程完成数据加载
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int innerWaveFrontLine = 0;
+             innerWaveFrontLine < tileRows + tileCols - 1;
+             innerWaveFrontLine++) {
+        int l = threadIdx;
+        int b = innerWaveFrontLine - l;
+
+        if (b >= 0 && b < tileRows && l < tileCols) {
+            ushort leftWeight = vers[b];
+            ushort topWeight = hors[l];
+
+            // 匹配时取min(左值, 上值)+1，不匹配时取max(左值, 上值)
+            if (bases[b] == latests[l]) {
+                hors[l] = (ushort) (min(leftWeight, topWeight) + 1);
+            } else {
+                hors[l] = max(leftWeight, topWeight);
+            }
+
+            vers[b] = hors[l];
+        }
+
+        // 等待当前wavefront的所有线程完成计算
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // 加回基准值写回全局内存
+    if (threadIdx < tileRows) {
+        gVerWeights[baseValGlobalOffset] = tileBase + (int) vers[threadIdx];
+    }
+
+    if (threadIdx < tileCols) {
+        gHorWeights[latestValGlobalOffset] = tileBase + (int) hors[threadIdx];
+    }
+}
+)";
@@ -0,0 +1,120 @@
+#include "Mega.h"
+
+using std::string;
+
+// __STEP__ MUST = [1->256]
+// __ELEMENT__ = uchar/ushort/int/long，base/latest的元素类型（MegaLCSElementType）
+// 和KernelLCS_Shared的tile内计算完全相同，只是tile的调度从host搬到了设备端
+const string Mega::KernelLCS_Persistent = R"(
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+常驻内核：整个矩阵只启动一次，固定数量的block循环领取base方向的一行tile
+一行tile内从左到右依次计算，vers一直留在共享内存里，只有hors需要跨block传递
+tile(b,l)依赖左边的tile(b,l-1)（同一个block刚算完）和上边的tile(b-1,l)（rowProgress[b-1]>l）
+行是按顺序领取的，等待的上一行一定已经被某个正在运行的block领走，不会死锁
+相邻的block自然错开一个tile，效果就是设备端自己推进的wavefront
+ */
+__kernel void KernelLCS_Persistent(
+    __global __ELEMENT__ *gBases,
+    __global __ELEMENT__ *gLatests,
+    __global int *gVerWeights,
+    __global volatile int *gHorWeights,
+    const int baseSliceSize,
+    const int latestSliceSize,
+    __global int *gRowCounter,
+    __global int *gRowProgress) {
+
+    const int threadIdx = get_local_id(0);
+
+    // 共享内存
+    __local __ELEMENT__ bases[__STEP__];
+    __local __ELEMENT__ latests[__STEP__];
+    __local int vers[__STEP__];
+    __local int hors[__STEP__];
+    __local int rowSlot[1];
+
+    while (true) {
+        // 领取下一行
+        if (threadIdx == 0) {
+            rowSlot[0] = atomic_inc(gRowCounter);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const int baseSliceID = rowSlot[0];
+        if (baseSliceID >= baseSliceSize) {
+            break;
+        }
+
+        const int baseValGlobalOffset = baseSliceID * __STEP__ + threadIdx;
+        bases[threadIdx] = gBases[baseValGlobalOffset];
+        vers[threadIdx] = gVerWeights[baseValGlobalOffset];
+
+        for (int latestSliceID = 0; latestSliceID < latestSliceSize; latestSliceID++) {
+            // 等待上方的tile写完hors
+            if (threadIdx == 0 && baseSliceID > 0) {
+                while (atomic_add(&gRowProgress[baseSliceID - 1], 0) <= latestSliceID) {
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+
+            const int latestValGlobalOffset = latestSliceID * __STEP__ + threadIdx;
+            latests[threadIdx] = gLatests[latestValGlobalOffset];
+            hors[threadIdx] = gHorWeights[latestValGlobalOffset];
+
+            // 等待所有线程完成数据加载
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            // tile内的计算和KernelLCS_Shared逐行一致，保证结果逐位相同
+            for (int innerWaveFrontLine = 0;
+                     innerWaveFrontLine < 2 * __STEP__ - 1;
+                     innerWaveFrontLine++) {
+                int l = threadIdx;
+                int b = innerWaveFrontLine - l;
+
+                if (b >= 0 && b < __STEP__ && l >= 0 && l < __STEP__) {
+                    int leftWeight = vers[b];
+                    int topWeight = hors[l];
+                    int leftTopWeight = min(leftWeight, topWeight);
+
+                    if (bases[b] == latests[l]) {
+                        hors[l] = leftTopWeight + 1;
+                    } else {
+                        hors[l] = max(leftWeight, topWeight);
+                    }
+
+                    vers[b] = hors[l];
+                }
+
+                barrier(CLK_LOCAL_MEM_FENCE);
+            } // end for innerWaveFrontLine
+
+            // hors写回全局内存后才能发布进度，下一行的block读到进度时hors一定可见
+            gHorWeights[latestValGlobalOffset] = hors[threadIdx];
+            mem_fence(CLK_GLOBAL_MEM_FENCE);
+            barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+
+            if (threadIdx == 0) {
+                atomic_xchg(&gRowProgress[baseSliceID], latestSliceID + 1);
+            }
+        } // end for latestSliceID
+
+        // 一行结束，vers写回
+        gVerWeights[baseValGlobalOffset] = vers[threadIdx];
+    } // end while
+}
+)";
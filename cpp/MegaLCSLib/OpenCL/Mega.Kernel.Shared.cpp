@@ -3,6 +3,7 @@
 using std::string;
 
 // __STEP__ MUST = [1->256]
+// __ELEMENT__ = uchar/ushort/int/long，base/latest的元素类型（MegaLCSElementType）
 const string Mega::KernelLCS_Shared = R"(
 /*
 Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
@@ -20,16 +21,58 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#ifdef PACKED_WEIGHTS
+/*
+打包的边界权重：每个tile的vers/hors是一条TILE_WORDS个word的记录
+第0个word是tile第一个位置的权重，之后位置i占第1+i/32个word的第i%32位，表示和位置i-1的差值（0或1）
+位置0的位不使用，tile之间的权重互不依赖，所以每条记录单独解码
+ */
+#define TILE_WORDS (1 + (__STEP__ + 31) / 32)
+
+// 位置i的权重 = 基准值 + 第1..i位中1的个数
+int DecodeWeight(__local uint *record, int i) {
+    int weight = (int) record[0];
+    for (int w = 0; w < i / 32; w++) {
+        weight += (int) popcount(record[1 + w]);
+    }
+    // 2u << 31 溢出为0，减1后正好是全1
+    uint mask = (2u << (i % 32)) - 1u;
+    return weight + (int) popcount(record[1 + i / 32] & mask);
+}
+
+// 记录的第w个word：0是基准值，其余由32个位置的差值拼成
+uint EncodeWord(__local int *weights, int w) {
+    if (w == 0) {
+        return (uint) weights[0];
+    }
+
+    uint bits = 0;
+    for (int c = 0; c < 32; c++) {
+        int i = (w - 1) * 32 + c;
+        if (i >= 1 && i < __STEP__ && weights[i] != weights[i - 1]) {
+            bits |= 1u << c;
+        }
+    }
+    return bits;
+}
+#endif
 
 __kernel void KernelLCS_MinMax(
-    __global int *gBases,
-    __global int *gLatests,
+    __global __ELEMENT__ *gBases,
+    __global __ELEMENT__ *gLatests,
+#ifdef PACKED_WEIGHTS
+    __global uint *gVerWeights,
+    __global uint *gHorWeights,
+#else
     __global int *gVerWeights,
     __global int *gHorWeights,
+#endif
     const int baseSliceSize,
     const int latestSliceSize,
     const int outerW,
-    const int totalThread) {
+    const int totalThread,
+    const int baseLength,
+    const int latestLength) {
 
 #ifdef DEBUG
     const int step = __STEP__;
@@ -52,10 +95,14 @@ __kernel void KernelLCS_MinMax(
     }
 
     // 共享内存
-    __local int bases[__STEP__];
-    __local int latests[__STEP__];
+    __local __ELEMENT__ bases[__STEP__];
+    __local __ELEMENT__ latests[__STEP__];
     __local int vers[__STEP__];
     __local int hors[__STEP__];
+#ifdef PACKED_WEIGHTS
+    __local uint verRecord[TILE_WORDS];
+    __local uint horRecord[TILE_WORDS];
+#endif
     
     // 计算当前处理的latestSlice范围: latest轴相当于X轴/水平轴
     const int latestSliceIDMin = max(0, outerW - (baseSliceSize - 1));
@@ -69,6 +116,11 @@ __kernel void KernelLCS_MinMax(
     
     const int baseValGlobalOffset = baseGlobalOffset + threadIdx;
     const int latestValGlobalOffset = latestGlobalOffset + threadIdx;
+
+    // 长度不是STEP的倍数时，最后一行/列的tile不满，只有前tileRows行、tileCols列有效
+    // 多出来的线程只参与barrier，不读写全局内存（打包的边界总是完整的tile）
+    const int tileRows = min(__STEP__, baseLength - baseGlobalOffset);
+    const int tileCols = min(__STEP__, latestLength - latestGlobalOffset);
     
 
 #ifdef DEBUG
@@ -79,18 +131,34 @@ __kernel void KernelLCS_MinMax(
 
     printf("                   thread=g%d,%d| INIT    gBases={%d %d ..} gLatests={%d %d ..} gVers={%d %d ..} gHors={%d %d ..} \n",
             threadGIdx, threadIdx
-            , gBases[0], gBases[1]
-            , gLatests[0], gLatests[1]
+            , (int) gBases[0], (int) gBases[1]
+            , (int) gLatests[0], (int) gLatests[1]
             , gVerWeights[0], gVerWeights[1]
             , gHorWeights[0], gHorWeights[1]);
 #endif
 
+#ifdef PACKED_WEIGHTS
+    // 先把两条记录搬到共享内存，每个线程再解码出自己位置的权重
+    for (int w = threadIdx; w < TILE_WORDS; w += __STEP__) {
+        verRecord[w] = gVerWeights[baseSliceID * TILE_WORDS + w];
+        horRecord[w] = gHorWeights[latestSliceID * TILE_WORDS + w];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    bases[threadIdx] = gBases[baseValGlobalOffset];
+    vers[threadIdx] = DecodeWeight(verRecord, threadIdx);
+
+    latests[threadIdx] = gLatests[latestValGlobalOffset];
+    hors[threadIdx] = DecodeWeight(horRecord, threadIdx);
+#else
     // 设备端全局内部搬迁到设备端全局内存，线程和元素正好一一对应
     // 假设STEP=2，则需要搬迁2次，分别是0 1【外层会启动好2个线程】
-    if (threadIdx < __STEP__) {
+    if (threadIdx < tileRows) {
         bases[threadIdx] = gBases[baseValGlobalOffset];
         vers[threadIdx] = gVerWeights[baseValGlobalOffset];
+    }
 
+    if (threadIdx < tileCols) {
         latests[threadIdx] = gLatests[latestValGlobalOffset];
         hors[threadIdx] = gHorWeights[latestValGlobalOffset];
 
@@ -101,6 +169,7 @@ __kernel void KernelLCS_MinMax(
             , latestValGlobalOffset);
 #endif
     } // end of load
+#endif
 
     // 等待所有线程完成数据加载
     barrier(CLK_LOCAL_MEM_FENCE);
@@ -111,13 +180,13 @@ __kernel void KernelLCS_MinMax(
     if( step == 1 ){
         printf("                   thread=g%d,%d| LOAD OK bases={%d} latests={%d} hors={%d} vers={%d}\n",
             threadGIdx, threadIdx
-            , bases[0], latests[0]                       
+            , (int) bases[0], (int) latests[0]                       
             , vers[0], hors[0]);    
     }else if( step == 2 ){
         printf("                   thread=g%d,%d| LOAD OK bases={%d %d} latests={%d %d} vers={%d %d} hors={%d %d}\n",
             threadGIdx, threadIdx
-            , bases[0], bases[1]  
-            , latests[0], latests[1]
+            , (int) bases[0], (int) bases[1]  
+            , (int) latests[0], (int) latests[1]
             , vers[0], vers[1]          
             , hors[0], hors[1]);      
     }else{
@@ -134,15 +203,16 @@ __kernel void KernelLCS_MinMax(
     先是outerW的展开，然后是innerWaveFrontLine的线程展开，画图吧，否则难以理解
     也许是因为共享内存被加载到了寄存器，又因为全部并行化了，所以性能提升很快
     */
+    // tileRows/tileCols在block内相同，所有线程执行同样次数的barrier
     for (int innerWaveFrontLine = 0; 
-             innerWaveFrontLine < 2 * __STEP__ - 1; 
+             innerWaveFrontLine < tileRows + tileCols - 1; 
              innerWaveFrontLine++) {
         // 每个wavefront对应一条反斜对角线,每个线程根据 wavefrontID 计算自己的坐标 (l,b)         
         int l = threadIdx;        // X轴坐标（latest索引）
         int b = innerWaveFrontLine - l;       // Y轴坐标（base索引）
 
         // 线程激活逻辑: 仅允许对角线上的有效坐标参与计算，通过下列条件自动过滤无效坐标，无需硬编码。
-        if (b >= 0 && b < __STEP__ && l >= 0 && l < __STEP__) {
+        if (b >= 0 && b < tileRows && l >= 0 && l < tileCols) {
             // 左值：当l>0时使用本行前一个值，l=0时使用纵向基础权重
             // 特殊点：左侧无元素，和基础权重vers[b]比较，而不是和0比较
             int leftWeight = vers[b];
@@ -191,15 +261,15 @@ __kernel void KernelLCS_MinMax(
     if( step == 1 ){
         printf("                   thread=g%d,%d| CALC OK bases={%d} latests={%d} vers={%d} hors={%d} \n",
             threadGIdx, threadIdx
-            , bases[0]
-            , latests[0]  
+            , (int) bases[0]
+            , (int) latests[0]  
             , vers[0]                     
             , hors[0]);    
     }else if( step == 2 ){
         printf("                   thread=g%d,%d| CALC OK bases={%d %d} latests={%d %d} vers={%d %d} hors={%d %d}\n",
             threadGIdx, threadIdx
-            , bases[0], bases[1] 
-            , latests[0], latests[1]
+            , (int) bases[0], (int) bases[1] 
+            , (int) latests[0], (int) latests[1]
             , vers[0], vers[1]       
             , hors[0], hors[1]);      
     }else{
@@ -209,9 +279,19 @@ __kernel void KernelLCS_MinMax(
 
 #endif
 
+#ifdef PACKED_WEIGHTS
+    // 每个word由一个线程从共享内存收集，写回的数据量是原来的约1/28（STEP=256）
+    for (int w = threadIdx; w < TILE_WORDS; w += __STEP__) {
+        gVerWeights[baseSliceID * TILE_WORDS + w] = EncodeWord(vers, w);
+        gHorWeights[latestSliceID * TILE_WORDS + w] = EncodeWord(hors, w);
+    }
+#else
     // 设备端共享内存搬迁到设备端全局内存，线程和元素正好一一对应
-    if (threadIdx < __STEP__) {
+    if (threadIdx < tileRows) {
         gVerWeights[baseValGlobalOffset] = vers[threadIdx];
+    }
+
+    if (threadIdx < tileCols) {
         gHorWeights[latestValGlobalOffset] = hors[threadIdx];
         
 #ifdef DEBUG
@@ -221,6 +301,7 @@ __kernel void KernelLCS_MinMax(
             , latestValGlobalOffset);
 #endif
     }
+#endif
 
 #ifdef DEBUG
     // 打印一次内部的所有值，调试用，最多打印前2个值，下面的+0 +1是为了代替threadIdx
@@ -0,0 +1,129 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "Mega.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MegaLCSMappedFile::MegaLCSMappedFile(const string &path) {
+    Open(path, false, 0);
+}
+
+MegaLCSMappedFile::MegaLCSMappedFile(const string &path, size_t _size) {
+    Open(path, true, _size);
+}
+
+void MegaLCSMappedFile::Open(const string &path, bool writable, size_t _size) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                FILE_SHARE_READ, nullptr, writable ? CREATE_ALWAYS : OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw runtime_error("cannot open file: " + path);
+    }
+    file = handle;
+
+    LARGE_INTEGER fileSize;
+    if (writable) {
+        // 可写的文件先扩展到指定大小
+        fileSize.QuadPart = (LONGLONG) _size;
+        if (!SetFilePointerEx(handle, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) {
+            CloseHandle(handle);
+            throw runtime_error("cannot resize file: " + path);
+        }
+    } else if (!GetFileSizeEx(handle, &fileSize)) {
+        CloseHandle(handle);
+        throw runtime_error("cannot open file: " + path);
+    }
+    size = (size_t) fileSize.QuadPart;
+
+    if (size > 0) {
+        mapping = CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        data = mapping == nullptr ? nullptr
+                                  : (char *) MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+                                                           0, 0, 0);
+        if (data == nullptr) {
+            if (mapping != nullptr) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(handle);
+            throw runtime_error("cannot map file: " + path);
+        }
+    }
+#else
+    int fd = writable ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600) : open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("cannot open file: " + path);
+    }
+
+    if (writable) {
+        // 可写的文件先扩展到指定大小
+        if (ftruncate(fd, (off_t) _size) != 0) {
+            close(fd);
+            throw runtime_error("cannot resize file: " + path);
+        }
+        size = _size;
+    } else {
+        struct stat fileStat{};
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            throw runtime_error("cannot open file: " + path);
+        }
+        size = (size_t) fileStat.st_size;
+    }
+
+    if (size > 0) {
+        void *mapped = writable ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("cannot map file: " + path);
+        }
+        data = (char *) mapped;
+        // 顺序读取，提示内核预读
+        madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+#endif
+}
+
+MegaLCSMappedFile::~MegaLCSMappedFile() {
+#ifdef _WIN32
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle((HANDLE) mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle((HANDLE) file);
+    }
+#else
+    if (data != nullptr) {
+        munmap((void *) data, size);
+    }
+#endif
+}
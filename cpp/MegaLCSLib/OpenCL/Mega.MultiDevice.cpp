@@ -0,0 +1,270 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "Mega.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <random>
+#include <thread>
+
+using namespace std;
+
+/*
+一次比较分给多个设备（或者CPU设备切出来的子设备）
+1. latest方向按列切成块，每个设备一块，块宽按设备吞吐的比例分配（step的倍数）
+2. base方向切成行带，设备d按行带从上到下计算自己的列块，hors一直留在自己这边
+3. 设备d算完第k个行带后，把这个行带的右边界（vers）交给设备d+1，然后立即开始第k+1个行带
+   设备d+1拿到第k个行带的左边界就可以开始，所有设备像流水线一样同时工作
+行带数取设备数的4倍（不超过base方向的tile数），流水线的填充和排空只占一小部分
+MinMax的结果和分块无关，所以和整个矩阵在一个设备上计算的结果相同
+ */
+
+// 每个设备的行带数，越多流水线的填充和排空占比越小，但每个行带都要重新上传这一列块的latest
+static const int MultiDeviceBandsPerDevice = 4;
+
+// 流水线里的列块可能在CPU或其他设备上算MinMax，引擎设置成位并行内核（精确DP）时这里改用共享内存内核
+// 只影响这一次计算，不改变引擎的设置
+static MegaLCSKernelVariant PipelineVariant(const shared_ptr<MegaLCSEngine> &engine) {
+    MegaLCSKernelVariant variant = engine->GetKernelVariant();
+    return variant == MegaLCSKernelVariant::BitParallel ? MegaLCSKernelVariant::Shared : variant;
+}
+
+vector<double> Mega::MeasureDeviceThroughput(
+        const vector<pair<cl_platform_id, cl_device_id>> &devices,
+        int step) {
+
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+
+    // 8*8个tile的随机数据，先跑一次编译内核，第二次计时
+    int length = 8 * step;
+    mt19937 rand(step);
+    vector<int> baseVals(length);
+    vector<int> latestVals(length);
+    for (int i = 0; i < length; i++) {
+        baseVals[i] = (int) (rand() % 4);
+        latestVals[i] = (int) (rand() % 4);
+    }
+
+    vector<double> throughputs;
+    for (const auto &device: devices) {
+        auto engine = MegaLCSEngine::GetDefault(device.first, device.second);
+        double throughput = 0;
+        for (int run = 0; run < 2 && engine->IsReady(); run++) {
+            vector<int> verWeights(length, 0);
+            vector<int> horWeights(length, 0);
+            auto start = chrono::high_resolution_clock::now();
+            if (!engine->TryHostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, step,
+                                              PipelineVariant(engine))) {
+                throughput = 0;
+                break;
+            }
+            auto seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+            throughput = (double) length * length / max(seconds, 1e-9);
+        }
+        throughputs.push_back(throughput);
+    }
+
+    return throughputs;
+}
+
+pair<vector<int>, vector<int>> Mega::MegaLCS_MultiDevice(
+        const vector<pair<cl_platform_id, cl_device_id>> &devices,
+        const vector<int> &baseVals,
+        const vector<int> &latestVals,
+        int step,
+        vector<double> throughputs) {
+
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+    if (!throughputs.empty() && throughputs.size() != devices.size()) {
+        throw invalid_argument("throughputs must match devices.");
+    }
+
+    int baseLength = (int) baseVals.size();
+    int latestLength = (int) latestVals.size();
+    vector<int> verWeights(baseLength, 0);
+    vector<int> horWeights(latestLength, 0);
+    if (baseLength == 0 || latestLength == 0) {
+        return make_pair(verWeights, horWeights);
+    }
+
+    if (throughputs.empty()) {
+        throughputs = MeasureDeviceThroughput(devices, step);
+    }
+
+    // 按吞吐的比例分配latest方向的tile，吞吐为0的设备不参与
+    vector<int> activeDevices;
+    double totalThroughput = 0;
+    for (int d = 0; d < (int) devices.size(); d++) {
+        if (throughputs[d] > 0) {
+            activeDevices.push_back(d);
+            totalThroughput += throughputs[d];
+        }
+    }
+
+    int latestTiles = (latestLength + step - 1) / step;
+    vector<int> columnBegins = {0};
+    double cumulative = 0;
+    for (int d: activeDevices) {
+        cumulative += throughputs[d];
+        int tiles = (int) (latestTiles * (cumulative / totalThroughput) + 0.5);
+        columnBegins.push_back(min(latestLength, tiles * step));
+    }
+    if (activeDevices.empty()) {
+        // 没有可用的设备，整个矩阵作为一块在CPU上计算
+        activeDevices.push_back(-1);
+        columnBegins.push_back(latestLength);
+    }
+    columnBegins.back() = latestLength;
+
+    int baseTiles = (baseLength + step - 1) / step;
+    int bandCount = min(baseTiles, MultiDeviceBandsPerDevice * (int) activeDevices.size());
+
+    vector<shared_ptr<MegaLCSEngine>> engines;
+    for (int d: activeDevices) {
+        engines.push_back(d >= 0 ? MegaLCSEngine::GetDefault(devices[d].first, devices[d].second) : nullptr);
+    }
+
+    return RunColumnPipeline(engines, columnBegins, baseVals, latestVals, step, bandCount);
+}
+
+pair<vector<int>, vector<int>> Mega::RunColumnPipeline(
+        const vector<shared_ptr<MegaLCSEngine>> &engines,
+        const vector<int> &columnBegins,
+        const vector<int> &baseVals,
+        const vector<int> &latestVals,
+        int step,
+        int bandCount) {
+
+    int baseLength = (int) baseVals.size();
+    int latestLength = (int) latestVals.size();
+    vector<int> verWeights(baseLength, 0);
+    vector<int> horWeights(latestLength, 0);
+    int bandRows = (baseLength + bandCount - 1) / bandCount;
+    bandRows = (bandRows + step - 1) / step * step;
+    bandCount = (baseLength + bandRows - 1) / bandRows;
+
+    // boundaries[d][k]：第d个列块第k个行带的右边界，ready之后第d+1个列块才能使用
+    int blockCount = (int) engines.size();
+    vector<vector<vector<int>>> boundaries(blockCount, vector<vector<int>>(bandCount));
+    vector<vector<char>> ready(blockCount, vector<char>(bandCount, 0));
+    mutex boundaryMutex;
+    condition_variable boundaryReady;
+
+    // 任何一个列块出错时，等待左边界的列块不会再等到，全部提前结束，异常在调用线程重新抛出
+    vector<exception_ptr> errors(blockCount);
+    bool isFailed = false;
+    auto fail = [&] {
+        lock_guard<mutex> lock(boundaryMutex);
+        isFailed = true;
+        boundaryReady.notify_all();
+    };
+
+    // CPU的列块用多线程wavefront，留一个核心给驱动设备的线程
+    int cpuThreads = max(1, (int) thread::hardware_concurrency() - (int) engines.size() + 1);
+
+    auto compute = [&](int block) {
+        const auto &engine = engines[block];
+
+        int columnBegin = columnBegins[block];
+        int columnEnd = columnBegins[block + 1];
+        vector<int> latestBlock(latestVals.begin() + columnBegin, latestVals.begin() + columnEnd);
+        vector<int> hors(columnEnd - columnBegin, 0);
+
+        for (int band = 0; band < bandCount; band++) {
+            int rowBegin = band * bandRows;
+            int rowEnd = min(baseLength, rowBegin + bandRows);
+
+            // 左边界：第一个列块是0，其余的等左边的列块算完同一个行带
+            vector<int> vers(rowEnd - rowBegin, 0);
+            if (block > 0) {
+                unique_lock<mutex> lock(boundaryMutex);
+                boundaryReady.wait(lock, [&] { return isFailed || ready[block - 1][band] != 0; });
+                if (isFailed) {
+                    return;
+                }
+                vers = move(boundaries[block - 1][band]);
+            }
+
+            // 列块为空（列数少于设备数）时左边界原样传给右边
+            if (!hors.empty()) {
+                vector<int> baseBand(baseVals.begin() + rowBegin, baseVals.begin() + rowEnd);
+                bool isCompleted = engine != nullptr && engine->IsReady() &&
+                                   engine->TryHostLCS_WaveFront(baseBand, latestBlock, vers, hors, step,
+                                                                PipelineVariant(engine));
+                if (!isCompleted) {
+                    CpuLCS_WaveFront(baseBand.data(), baseBand.size(),
+                                     latestBlock.data(), latestBlock.size(),
+                                     vers.data(), vers.size(),
+                                     hors.data(), hors.size(),
+                                     step, cpuThreads);
+                }
+            }
+
+            // 最后一个列块的右边界就是整个矩阵的verWeights
+            if (block == blockCount - 1) {
+                copy(vers.begin(), vers.end(), verWeights.begin() + rowBegin);
+            } else {
+                lock_guard<mutex> lock(boundaryMutex);
+                boundaries[block][band] = move(vers);
+                ready[block][band] = 1;
+                boundaryReady.notify_all();
+            }
+        }
+
+        copy(hors.begin(), hors.end(), horWeights.begin() + columnBegin);
+    };
+
+    auto worker = [&](int block) {
+        try {
+            compute(block);
+        } catch (...) {
+            errors[block] = current_exception();
+            fail();
+        }
+    };
+
+    vector<thread> threads;
+    try {
+        for (int block = 1; block < blockCount; block++) {
+            threads.emplace_back(worker, block);
+        }
+    } catch (...) {
+        fail();
+        for (auto &th: threads) {
+            th.join();
+        }
+        throw;
+    }
+    worker(0);
+    for (auto &th: threads) {
+        th.join();
+    }
+
+    for (auto &error: errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    return make_pair(verWeights, horWeights);
+}
@@ -0,0 +1,355 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "Mega.h"
+#include <algorithm>
+#include <climits>
+#include <numeric>
+
+using namespace std;
+
+/*
+同一个base和很多个候选比较（例如一个版本和500个候选修订）
+逐个调用MegaLCS_Fusion时每次都要重新上传base、分配全部缓冲区、逐带启动内核
+这里base只上传一次，候选按单元数从大到小排好后分块上传，
+每一块启动一次定义了SHARED_BASE的KernelLCS_Batch，常驻的block各自领取一个候选，所有候选的wavefront并排推进
+常驻block的个数、大候选的分流和没有设备时的CPU计算都和批量接口共用
+ */
+
+// 每一块候选的元素个数上限，设备上只保留一块候选的latests和hors
+static const size_t OneToManyChunkElements = (size_t) 1 << 22;
+
+static void ValidOneToMany(const vector<int> &baseVals, const vector<vector<int>> &candidates, int step) {
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+
+    if (baseVals.size() > (size_t) INT_MAX) {
+        throw invalid_argument("baseVals is too large.");
+    }
+    for (const auto &candidate: candidates) {
+        if (candidate.size() > (size_t) INT_MAX) {
+            throw invalid_argument("candidate is too large.");
+        }
+    }
+}
+
+bool MegaLCSEngine::HostLCS_OneToMany(
+        const vector<int> &baseVals,
+        const vector<vector<int>> &candidates,
+        int step,
+        bool withWeights,
+        MegaLCSOneToManyResult &result) {
+
+    ValidOneToMany(baseVals, candidates, step);
+
+    int candidateCount = (int) candidates.size();
+    result.processByCpu = false;
+    result.lengths.assign(candidateCount, 0);
+    result.horWeights.clear();
+    if (withWeights) {
+        result.horWeights.resize(candidateCount);
+        for (int c = 0; c < candidateCount; c++) {
+            result.horWeights[c].assign(candidates[c].size(), 0);
+        }
+    }
+    if (candidateCount == 0 || baseVals.empty()) {
+        return true;
+    }
+
+    // 按长度从大到小排好，再按元素个数切块，每块内也是大的先领取
+    vector<int> sorted(candidateCount);
+    iota(sorted.begin(), sorted.end(), 0);
+    stable_sort(sorted.begin(), sorted.end(),
+                [&](int a, int b) { return candidates[a].size() > candidates[b].size(); });
+
+    // 每块在sorted中的区间[chunkBegins[k], chunkBegins[k+1])，单个候选超过上限时自成一块
+    vector<int> chunkBegins = {0};
+    size_t chunkElements = 0;
+    size_t capacity = 1;
+    int maxChunkCount = 1;
+    for (int i = 0; i < candidateCount; i++) {
+        size_t length = candidates[sorted[i]].size();
+        if (i > chunkBegins.back() && chunkElements + length > OneToManyChunkElements) {
+            chunkBegins.push_back(i);
+            chunkElements = 0;
+        }
+        chunkElements += length;
+        capacity = max(capacity, chunkElements);
+        maxChunkCount = max(maxChunkCount, i + 1 - chunkBegins.back());
+    }
+    chunkBegins.push_back(candidateCount);
+    int chunkCount = (int) chunkBegins.size() - 1;
+
+    // 每块打包好的候选，在最后一次同步之前都要保持有效
+    vector<vector<int>> chunkLatests(chunkCount);
+    vector<vector<int>> chunkOffsets(chunkCount);
+    vector<vector<int>> chunkLengths(chunkCount);
+    vector<vector<int>> chunkHors(chunkCount);
+    for (int k = 0; k < chunkCount; k++) {
+        chunkOffsets[k].push_back(0);
+        for (int i = chunkBegins[k]; i < chunkBegins[k + 1]; i++) {
+            const auto &candidate = candidates[sorted[i]];
+            chunkLatests[k].insert(chunkLatests[k].end(), candidate.begin(), candidate.end());
+            chunkOffsets[k].push_back((int) chunkLatests[k].size());
+        }
+        chunkLengths[k].assign(chunkBegins[k + 1] - chunkBegins[k], 0);
+        if (withWeights) {
+            chunkHors[k].assign(chunkLatests[k].size(), 0);
+        }
+    }
+
+    lock_guard<mutex> lock(engineMutex);
+
+    cl_kernel kernel = GetKernel(MegaLCSKernelVariant::Shared, true, 0, step, step, false, MegaLCSElementType::Int32, false,
+                                 Mega::PairLayout::OneToMany);
+    if (kernel == nullptr) {
+        cerr << "Failed to create one-to-many kernel." << endl;
+        return false;
+    }
+
+    // 0 base, 1 latests, 2 hors, 3 baseOffsets, 4 latestOffsets, 5 order, 6 nextCandidate, 7 lengths
+    cl_mem memObjects[8] = {};
+    auto releaseMemObjects = [&] {
+        for (auto &memObject: memObjects) {
+            if (memObject != nullptr) {
+                clReleaseMemObject(memObject);
+                memObject = nullptr;
+            }
+        }
+    };
+
+    // 每块内已经排好序，领取顺序就是块内的下标
+    vector<int> order(maxChunkCount);
+    iota(order.begin(), order.end(), 0);
+    vector<int> zeros(max(capacity, (size_t) maxChunkCount + 1), 0);
+
+    // 所有候选共用同一个base
+    vector<int> baseOffsets = {0, (int) baseVals.size()};
+
+    cl_int errs[8];
+    memObjects[0] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, baseVals.size() * sizeof(int),
+                                   (void *) baseVals.data(), &errs[0]);
+    memObjects[1] = clCreateBuffer(context, CL_MEM_READ_ONLY, capacity * sizeof(int), nullptr, &errs[1]);
+    memObjects[2] = clCreateBuffer(context, CL_MEM_READ_WRITE, capacity * sizeof(int), nullptr, &errs[2]);
+    memObjects[3] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, 2 * sizeof(int),
+                                   baseOffsets.data(), &errs[3]);
+    memObjects[4] = clCreateBuffer(context, CL_MEM_READ_ONLY, (maxChunkCount + 1) * sizeof(int), nullptr, &errs[4]);
+    memObjects[5] = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, maxChunkCount * sizeof(int),
+                                   order.data(), &errs[5]);
+    memObjects[6] = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(int), nullptr, &errs[6]);
+    memObjects[7] = clCreateBuffer(context, CL_MEM_READ_WRITE, maxChunkCount * sizeof(int), nullptr, &errs[7]);
+
+    for (cl_int err: errs) {
+        if (err != CL_SUCCESS) {
+            cerr << "Error creating one-to-many memory objects." << endl;
+            releaseMemObjects();
+            return false;
+        }
+    }
+
+    // 参数和批量接口相同，左边界在内核里清零，gVerWeights不使用
+    cl_mem noVerWeights = nullptr;
+    cl_int err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &memObjects[0]);
+    err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &memObjects[1]);
+    err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &noVerWeights);
+    for (int i = 2; i < 6; i++) {
+        err |= clSetKernelArg(kernel, i + 1, sizeof(cl_mem), &memObjects[i]);
+    }
+    err |= clSetKernelArg(kernel, 8, sizeof(cl_mem), &memObjects[6]);
+    err |= clSetKernelArg(kernel, 9, sizeof(cl_mem), &memObjects[7]);
+    if (err != CL_SUCCESS) {
+        cerr << "Error setting kernel arguments." << endl;
+        releaseMemObjects();
+        return false;
+    }
+
+    size_t residentBlocks = Mega::ResidentPairBlocks(deviceId);
+
+    // 所有块连续入队，依靠in-order队列保证上一块读回之后才覆盖缓冲区，只在最后同步一次
+    err = CL_SUCCESS;
+    for (int k = 0; k < chunkCount && err == CL_SUCCESS; k++) {
+        int count = chunkBegins[k + 1] - chunkBegins[k];
+        size_t elements = chunkLatests[k].size();
+
+        if (elements > 0) {
+            err |= clEnqueueWriteBuffer(commandQueue, memObjects[1], CL_FALSE, 0, elements * sizeof(int),
+                                        chunkLatests[k].data(), 0, nullptr, nullptr);
+            err |= clEnqueueWriteBuffer(commandQueue, memObjects[2], CL_FALSE, 0, elements * sizeof(int),
+                                        zeros.data(), 0, nullptr, nullptr);
+        }
+        err |= clEnqueueWriteBuffer(commandQueue, memObjects[4], CL_FALSE, 0, (count + 1) * sizeof(int),
+                                    chunkOffsets[k].data(), 0, nullptr, nullptr);
+        err |= clEnqueueWriteBuffer(commandQueue, memObjects[6], CL_FALSE, 0, sizeof(int),
+                                    zeros.data(), 0, nullptr, nullptr);
+        err |= clSetKernelArg(kernel, 7, sizeof(int), &count);
+        if (err != CL_SUCCESS) {
+            break;
+        }
+
+        size_t totalBlock = min((size_t) count, residentBlocks);
+        size_t localWorkSize_ThreadPerBlock[] = {(size_t) step};
+        size_t globalWorkSize_AllThreadInOneGrid[] = {totalBlock * step};
+
+        err = clEnqueueNDRangeKernel(
+                commandQueue,
+                kernel,
+                1,
+                nullptr,
+                globalWorkSize_AllThreadInOneGrid,
+                localWorkSize_ThreadPerBlock,
+                0,
+                nullptr,
+                nullptr);
+
+        if (err != CL_SUCCESS) {
+            break;
+        }
+
+        err |= clEnqueueReadBuffer(commandQueue, memObjects[7], CL_FALSE, 0, count * sizeof(int),
+                                   chunkLengths[k].data(), 0, nullptr, nullptr);
+        if (withWeights && elements > 0) {
+            err |= clEnqueueReadBuffer(commandQueue, memObjects[2], CL_FALSE, 0, elements * sizeof(int),
+                                       chunkHors[k].data(), 0, nullptr, nullptr);
+        }
+    }
+
+    if (err == CL_SUCCESS) {
+        err = clFinish(commandQueue);
+    } else {
+        clFinish(commandQueue);
+    }
+
+    releaseMemObjects();
+
+    if (err != CL_SUCCESS) {
+        cerr << "Error running one-to-many kernel." << endl;
+        return false;
+    }
+
+    // 按原来的下标放回
+    for (int k = 0; k < chunkCount; k++) {
+        for (int i = chunkBegins[k]; i < chunkBegins[k + 1]; i++) {
+            int c = sorted[i];
+            int local = i - chunkBegins[k];
+            result.lengths[c] = chunkLengths[k][local];
+            if (withWeights) {
+                copy(chunkHors[k].begin() + chunkOffsets[k][local],
+                     chunkHors[k].begin() + chunkOffsets[k][local + 1],
+                     result.horWeights[c].begin());
+            }
+        }
+    }
+
+    return true;
+}
+
+MegaLCSOneToManyResult Mega::MegaLCS_OneToMany(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        const vector<int> &baseVals,
+        const vector<vector<int>> &candidates,
+        int step,
+        bool withWeights) {
+
+    ValidOneToMany(baseVals, candidates, step);
+
+    int candidateCount = (int) candidates.size();
+    MegaLCSOneToManyResult result;
+    result.lengths.assign(candidateCount, 0);
+    if (withWeights) {
+        result.horWeights.resize(candidateCount);
+        for (int c = 0; c < candidateCount; c++) {
+            result.horWeights[c].assign(candidates[c].size(), 0);
+        }
+    }
+
+    vector<int> allCandidates(candidateCount);
+    iota(allCandidates.begin(), allCandidates.end(), 0);
+
+    // 没有设备或者设备出错时，每个候选在CPU上和base计算
+    auto cpuOneToMany = [&] {
+        auto pairAt = [&](int c) {
+            return make_tuple(baseVals.data(), baseVals.size(), candidates[c].data(), candidates[c].size());
+        };
+        auto store = [&](int c, const vector<int> &, const vector<int> &horWeights) {
+            result.horWeights[c] = horWeights;
+        };
+        CpuLCS_Pairs(allCandidates, pairAt, result.lengths,
+                     withWeights ? function<void(int, const vector<int> &, const vector<int> &)>(store) : nullptr);
+        result.processByCpu = true;
+    };
+
+    shared_ptr<MegaLCSEngine> engine;
+    if (platformId != nullptr && deviceId != nullptr) {
+        engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    }
+
+    // 如果没有可用的设备，则全部使用CPU处理
+    if (engine == nullptr || !engine->IsReady()) {
+        cpuOneToMany();
+        return result;
+    }
+
+    // 一个block独占一个大候选会拖住整个启动时，大的候选改为单独跑整个矩阵的wavefront，规则和批量接口相同
+    vector<long long> candidateTiles(candidateCount);
+    long long baseTiles = ((long long) baseVals.size() + step - 1) / step;
+    for (int c = 0; c < candidateCount; c++) {
+        candidateTiles[c] = baseTiles * (((long long) candidates[c].size() + step - 1) / step);
+    }
+    vector<int> largeCandidates;
+    vector<int> smallCandidates;
+    tie(largeCandidates, smallCandidates) = SplitLargePairs(deviceId, candidateTiles);
+
+    // 没有大的候选时（常见情况）直接使用原来的候选，不复制
+    vector<vector<int>> smallCopies;
+    if (!largeCandidates.empty()) {
+        for (int c: smallCandidates) {
+            smallCopies.push_back(candidates[c]);
+        }
+    }
+    const auto &deviceCandidates = largeCandidates.empty() ? candidates : smallCopies;
+
+    MegaLCSOneToManyResult deviceResult;
+    if (!engine->HostLCS_OneToMany(baseVals, deviceCandidates, step, withWeights, deviceResult)) {
+        // 设备出错时全部改用CPU计算
+        cpuOneToMany();
+        return result;
+    }
+
+    if (largeCandidates.empty()) {
+        return deviceResult;
+    }
+
+    for (int i = 0; i < (int) smallCandidates.size(); i++) {
+        int c = smallCandidates[i];
+        result.lengths[c] = deviceResult.lengths[i];
+        if (withWeights) {
+            result.horWeights[c] = move(deviceResult.horWeights[i]);
+        }
+    }
+
+    for (int c: largeCandidates) {
+        auto candidateResult = MegaLCS_Fusion(platformId, deviceId, baseVals, candidates[c], step, false);
+        result.lengths[c] = get<2>(candidateResult).back();
+        if (withWeights) {
+            result.horWeights[c] = move(get<2>(candidateResult));
+        }
+    }
+
+    return result;
+}
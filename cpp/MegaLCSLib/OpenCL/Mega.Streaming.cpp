@@ -0,0 +1,365 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+#include "Mega.h"
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <random>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/*
+超过设备（或host）内存的序列
+HostLCS_WaveFront把bases、latests和两个权重数组整个放在设备上，下标都是int，1亿到10亿个元素时放不下
+这里两个输入都是内存映射的文件，按块流过设备：
+1. latest方向切成宽度为W的列条带，条带内的latests和hors一直留在设备上，hors从上到下传递
+2. 条带内base方向切成高度为H的块，每块上传bases和vers，计算完把vers读回host，作为下一个条带的左边界
+3. base块有两套缓冲区，下一块在另一个队列上上传，和当前块的wavefront重叠
+设备上只有latests/hors各W个int和两套bases/vers各H个int，W=H=memoryBudget/24（取step的倍数）
+host上的下标都是64位，设备上每一块的下标不超过W/H，仍然是int
+MinMax的结果和分块无关，所以和整个矩阵一次计算的结果相同
+ */
+
+// 设备上一块的行数（也是条带的列数）：4*(2W+4H)个字节不超过memoryBudget，单个缓冲区不超过maxAllocSize
+static long long StreamingBlockSize(size_t memoryBudget, int step, size_t maxAllocSize) {
+    size_t blockSize = min(memoryBudget / (6 * sizeof(int)), maxAllocSize / sizeof(int));
+    blockSize = min(blockSize, (size_t) 1 << 30);
+    blockSize -= blockSize % step;
+    if (blockSize == 0) {
+        throw runtime_error("memoryBudget is too small.");
+    }
+    return (long long) blockSize;
+}
+
+bool MegaLCSEngine::HostLCS_Streaming(
+        const int *baseVals,
+        long long baseLength,
+        const int *latestVals,
+        long long latestLength,
+        int *verWeights,
+        int step,
+        size_t memoryBudget,
+        long long &length) {
+
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+
+    length = 0;
+    if (baseLength == 0 || latestLength == 0) {
+        return true;
+    }
+
+    lock_guard<mutex> lock(engineMutex);
+
+    cl_ulong maxAllocSize = 0;
+    cl_int err = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &maxAllocSize, nullptr);
+    if (err != CL_SUCCESS || maxAllocSize == 0) {
+        cerr << "Failed to get device max mem alloc size." << endl;
+        return false;
+    }
+
+    long long blockSize = StreamingBlockSize(memoryBudget, step, (size_t) maxAllocSize);
+    long long stepUp = step;
+    int stripeWidth = (int) min(blockSize, (latestLength + stepUp - 1) / stepUp * stepUp);
+    int blockHeight = (int) min(blockSize, (baseLength + stepUp - 1) / stepUp * stepUp);
+
+    cl_kernel kernel = GetKernel(MegaLCSKernelVariant::Shared, true, 0, step, step, false);
+    if (kernel == nullptr) {
+        return false;
+    }
+
+    // 上传用单独的in-order队列，和计算队列之间用事件同步
+#if CL_VERSION_2_0
+    cl_command_queue transferQueue = clCreateCommandQueueWithProperties(context, deviceId, nullptr, &err);
+#else
+    cl_command_queue transferQueue = clCreateCommandQueue(context, deviceId, 0, &err);
+#endif
+    if (err != CL_SUCCESS || transferQueue == nullptr) {
+        cerr << "Failed to create transfer commandQueue." << endl;
+        return false;
+    }
+
+    // 0 latests, 1 hors, 2/3 两套bases, 4/5 两套vers
+    cl_mem memObjects[6] = {};
+    // 每套base缓冲区最后一次读回vers的事件，覆盖这套缓冲区之前要等它完成
+    cl_event readEvents[2] = {};
+    cl_event writeEvents[2] = {};
+    auto releaseAll = [&] {
+        clFinish(commandQueue);
+        clFinish(transferQueue);
+        for (auto &event: readEvents) {
+            if (event != nullptr) {
+                clReleaseEvent(event);
+                event = nullptr;
+            }
+        }
+        for (auto &event: writeEvents) {
+            if (event != nullptr) {
+                clReleaseEvent(event);
+                event = nullptr;
+            }
+        }
+        for (auto &memObject: memObjects) {
+            if (memObject != nullptr) {
+                clReleaseMemObject(memObject);
+                memObject = nullptr;
+            }
+        }
+        clReleaseCommandQueue(transferQueue);
+    };
+
+    cl_int errs[6];
+    memObjects[0] = clCreateBuffer(context, CL_MEM_READ_ONLY, stripeWidth * sizeof(int), nullptr, &errs[0]);
+    memObjects[1] = clCreateBuffer(context, CL_MEM_READ_WRITE, stripeWidth * sizeof(int), nullptr, &errs[1]);
+    for (int set = 0; set < 2; set++) {
+        memObjects[2 + set] = clCreateBuffer(context, CL_MEM_READ_ONLY, blockHeight * sizeof(int), nullptr,
+                                             &errs[2 + set]);
+        memObjects[4 + set] = clCreateBuffer(context, CL_MEM_READ_WRITE, blockHeight * sizeof(int), nullptr,
+                                             &errs[4 + set]);
+    }
+
+    for (cl_int createErr: errs) {
+        if (createErr != CL_SUCCESS) {
+            cerr << "Error creating streaming memory objects." << endl;
+            releaseAll();
+            return false;
+        }
+    }
+
+    vector<int> zeros(stripeWidth, 0);
+    long long blockCount = (baseLength + blockHeight - 1) / blockHeight;
+
+    // 在传输队列上把第block块的bases和vers上传到第block%2套缓冲区
+    auto uploadBlock = [&](long long block) {
+        int set = (int) (block % 2);
+        long long baseBegin = block * blockHeight;
+        size_t rows = (size_t) min((long long) blockHeight, baseLength - baseBegin);
+
+        cl_uint waitCount = readEvents[set] != nullptr ? 1 : 0;
+        cl_event lastWrite = nullptr;
+        cl_int uploadErr = clEnqueueWriteBuffer(transferQueue, memObjects[2 + set], CL_FALSE, 0, rows * sizeof(int),
+                                                baseVals + baseBegin, waitCount, &readEvents[set], nullptr);
+        uploadErr |= clEnqueueWriteBuffer(transferQueue, memObjects[4 + set], CL_FALSE, 0, rows * sizeof(int),
+                                          verWeights + baseBegin, waitCount, &readEvents[set], &lastWrite);
+        if (writeEvents[set] != nullptr) {
+            clReleaseEvent(writeEvents[set]);
+        }
+        writeEvents[set] = lastWrite;
+        clFlush(transferQueue);
+        return uploadErr;
+    };
+
+    for (long long latestBegin = 0; latestBegin < latestLength; latestBegin += stripeWidth) {
+        int cols = (int) min((long long) stripeWidth, latestLength - latestBegin);
+
+        // 条带的latests和初始为0的hors（上边界），计算队列上顺序执行
+        err = clEnqueueWriteBuffer(commandQueue, memObjects[0], CL_FALSE, 0, cols * sizeof(int),
+                                   latestVals + latestBegin, 0, nullptr, nullptr);
+        err |= clEnqueueWriteBuffer(commandQueue, memObjects[1], CL_FALSE, 0, cols * sizeof(int),
+                                    zeros.data(), 0, nullptr, nullptr);
+        err |= uploadBlock(0);
+        if (err != CL_SUCCESS) {
+            cerr << "Error writing stripe to device." << endl;
+            releaseAll();
+            return false;
+        }
+
+        for (long long block = 0; block < blockCount; block++) {
+            int set = (int) (block % 2);
+            long long baseBegin = block * blockHeight;
+            int rows = (int) min((long long) blockHeight, baseLength - baseBegin);
+
+            // 下一块先开始上传，和这一块的计算重叠
+            if (block + 1 < blockCount && uploadBlock(block + 1) != CL_SUCCESS) {
+                cerr << "Error writing block to device." << endl;
+                releaseAll();
+                return false;
+            }
+
+            err = clWaitForEvents(1, &writeEvents[set]);
+
+            int baseSliceSize = (rows + step - 1) / step;
+            int latestSliceSize = (cols + step - 1) / step;
+            err |= clSetKernelArg(kernel, 0, sizeof(cl_mem), &memObjects[2 + set]);
+            err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &memObjects[0]);
+            err |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &memObjects[4 + set]);
+            err |= clSetKernelArg(kernel, 3, sizeof(cl_mem), &memObjects[1]);
+            err |= clSetKernelArg(kernel, 4, sizeof(int), &baseSliceSize);
+            err |= clSetKernelArg(kernel, 5, sizeof(int), &latestSliceSize);
+            err |= clSetKernelArg(kernel, 8, sizeof(int), &rows);
+            err |= clSetKernelArg(kernel, 9, sizeof(int), &cols);
+            if (err != CL_SUCCESS) {
+                cerr << "Error setting kernel arguments." << endl;
+                releaseAll();
+                return false;
+            }
+
+            cl_mem blockMemObjects[4] = {memObjects[2 + set], memObjects[0], memObjects[4 + set], memObjects[1]};
+            if (!EnqueueWaveFrontBands(kernel, blockMemObjects, baseSliceSize, latestSliceSize, rows, cols,
+                                       step, step, false)) {
+                releaseAll();
+                return false;
+            }
+
+            // 这一块的右边界就是下一个条带的左边界
+            if (readEvents[set] != nullptr) {
+                clReleaseEvent(readEvents[set]);
+                readEvents[set] = nullptr;
+            }
+            err = clEnqueueReadBuffer(commandQueue, memObjects[4 + set], CL_FALSE, 0, rows * sizeof(int),
+                                      verWeights + baseBegin, 0, nullptr, &readEvents[set]);
+            if (err != CL_SUCCESS) {
+                cerr << "Error reading block from device." << endl;
+                releaseAll();
+                return false;
+            }
+        }
+
+        // 下一个条带上传vers之前，这个条带的读回都要完成
+        err = clFinish(commandQueue);
+        if (err != CL_SUCCESS) {
+            cerr << "Error finishing stripe." << endl;
+            releaseAll();
+            return false;
+        }
+
+        // 最后一个条带的hors的最后一个值就是LCS长度
+        if (latestBegin + cols == latestLength) {
+            int lastWeight = 0;
+            err = clEnqueueReadBuffer(commandQueue, memObjects[1], CL_TRUE, (cols - 1) * sizeof(int), sizeof(int),
+                                      &lastWeight, 0, nullptr, nullptr);
+            if (err != CL_SUCCESS) {
+                cerr << "Error reading result from device." << endl;
+                releaseAll();
+                return false;
+            }
+            length = lastWeight;
+        }
+    }
+
+    releaseAll();
+    return true;
+}
+
+// 没有设备时按同样的条带和块在CPU上计算，每块用多线程的CpuLCS_WaveFront
+static long long CpuStreaming(const int *baseVals, long long baseLength,
+                              const int *latestVals, long long latestLength,
+                              int *verWeights, int step, size_t memoryBudget) {
+    // host上只有一个条带的hors，块直接引用映射的内存
+    long long blockSize = StreamingBlockSize(memoryBudget, step, memoryBudget);
+    vector<int> horWeights;
+    long long length = 0;
+
+    for (long long latestBegin = 0; latestBegin < latestLength; latestBegin += blockSize) {
+        int cols = (int) min(blockSize, latestLength - latestBegin);
+        horWeights.assign(cols, 0);
+
+        for (long long baseBegin = 0; baseBegin < baseLength; baseBegin += blockSize) {
+            int rows = (int) min(blockSize, baseLength - baseBegin);
+            Mega::CpuLCS_WaveFront(const_cast<int *>(baseVals + baseBegin), rows,
+                                   const_cast<int *>(latestVals + latestBegin), cols,
+                                   verWeights + baseBegin, rows,
+                                   horWeights.data(), cols,
+                                   step);
+        }
+        length = horWeights.back();
+    }
+
+    return length;
+}
+
+long long Mega::MegaLCS_Streaming(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        const string &basePath,
+        const string &latestPath,
+        int step,
+        size_t memoryBudget) {
+
+    if (!(1 <= step && step <= 256)) {
+        throw runtime_error("step is invalid.");
+    }
+    StreamingBlockSize(memoryBudget, step, memoryBudget);
+
+    MegaLCSMappedFile baseFile(basePath);
+    MegaLCSMappedFile latestFile(latestPath);
+    if (baseFile.size % sizeof(int) != 0 || latestFile.size % sizeof(int) != 0) {
+        throw invalid_argument("file size is not a multiple of 4.");
+    }
+
+    long long baseLength = (long long) (baseFile.size / sizeof(int));
+    long long latestLength = (long long) (latestFile.size / sizeof(int));
+    if (baseLength == 0 || latestLength == 0) {
+        return 0;
+    }
+
+    // 权重是int，LCS长度不能超过INT_MAX
+    if (min(baseLength, latestLength) > INT_MAX) {
+        throw invalid_argument("sequences are too long.");
+    }
+
+    const int *baseVals = reinterpret_cast<const int *>(baseFile.data);
+    const int *latestVals = reinterpret_cast<const int *>(latestFile.data);
+
+    // 竖直边界放得进memoryBudget时放在内存里，否则放在临时文件里，由操作系统换页
+    vector<int> verVector;
+    unique_ptr<MegaLCSMappedFile> verFile;
+    fs::path verPath;
+    int *verWeights;
+    if ((size_t) baseLength * sizeof(int) <= memoryBudget) {
+        verVector.assign(baseLength, 0);
+        verWeights = verVector.data();
+    } else {
+        error_code ec;
+        verPath = fs::temp_directory_path(ec) / ("MegaLCS-streaming-" + to_string(random_device()()) + ".tmp");
+        verFile = make_unique<MegaLCSMappedFile>(verPath.string(), (size_t) baseLength * sizeof(int));
+        verWeights = reinterpret_cast<int *>(verFile->data);
+    }
+
+    // 临时文件在返回（或抛出异常）时删除
+    struct TempFileRemover {
+        unique_ptr<MegaLCSMappedFile> &file;
+        fs::path &path;
+
+        ~TempFileRemover() {
+            if (file != nullptr) {
+                file.reset();
+                error_code ec;
+                fs::remove(path, ec);
+            }
+        }
+    } remover{verFile, verPath};
+
+    shared_ptr<MegaLCSEngine> engine;
+    if (platformId != nullptr && deviceId != nullptr) {
+        engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    }
+
+    long long length = 0;
+    if (engine != nullptr && engine->IsReady() &&
+        engine->HostLCS_Streaming(baseVals, baseLength, latestVals, latestLength, verWeights, step, memoryBudget,
+                                  length)) {
+        return length;
+    }
+
+    // 没有设备，或者设备出错时从头在CPU上计算
+    fill(verWeights, verWeights + baseLength, 0);
+    return CpuStreaming(baseVals, baseLength, latestVals, latestLength, verWeights, step, memoryBudget);
+}
@@ -0,0 +1,305 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+/*
+基于检查点的回溯
+HostLCS_WaveFront在设备上原地覆盖verWeights/horWeights，结束后只剩最后的边界
+第d个对角带开始之前的(verWeights, horWeights)恰好是这个带上所有tile的输入：
+tile(b,l)的左边是vers第b段（tile(b,l-1)的输出），上边是hors第l段（tile(b-1,l)的输出）
+所以每k个带保存一次完整的边界权重就能恢复任意tile的输入
+
+回溯从右下角开始，路径只向左/上/左上移动，每个带最多经过一个tile
+路径进入第s个检查段（带[s*k, (s+1)*k)）时位于tile(bi,lj)，段内路径只会经过
+b<=bi、l<=lj、带号>=s*k的三角形区域（最多k(k+1)/2个tile），从检查点s在CPU上重算这个区域，
+再对路径经过的tile展开完整的矩阵按下面的规则回溯：
+相同元素走左上并记录匹配，否则走上值和左值中较大的一方（相等时走上）
+k越小检查点越多、重算越少，按memoryBudget选择能放下的最小k
+长度不是step的倍数时，最后一行/列的tile只有剩下的行/列，和设备端的边缘tile一致
+
+MinMax在匹配且左值==上值==对角+1时会多算1，按它的矩阵回溯得到的路径不一定最长，对数也可能和权重不同
+输入边界是合法的DP边界时改为计算精确DP：tile内用位并行，展开时匹配取对角+1，这时上面的规则得到一条最长路径
+精确DP的tile需要左上角的权重，和KernelLCS_BitParallel一样每个base slice传递一个corners，检查点里也保存它
+ */
+
+// 回溯使用的字节数：检查点+工作边界（精确时加上corners）、三角形区域内tile的输入、一个tile的完整矩阵
+static size_t TracebackMemory(int interval, int totalWave, long long totalTiles,
+                              size_t baseLength, size_t latestLength, size_t cornerLength, int step) {
+    size_t checkpointCount = (totalWave + interval - 1) / interval;
+    long long coneTiles = min((long long) interval * (interval + 1) / 2, totalTiles);
+    return (checkpointCount + 1) * (baseLength + latestLength + cornerLength) * sizeof(int)
+           + (size_t) coneTiles * (2 * step + 1) * sizeof(int)
+           + (size_t) step * step * sizeof(int);
+}
+
+// 第slice个tile在这个方向上的实际长度，只有最后一个可能不满step
+static int TileLength(size_t length, int slice, int step) {
+    return (int) min((size_t) step, length - (size_t) slice * step);
+}
+
+// tile(b,l)的左上角：tile(b,l-1)读入的hors最后一个值，或者tile(b-1,0)读入的vers最后一个值，和KernelLCS_BitParallel相同
+// 读出自己的左上角之后写入右边和下边tile的左上角
+static int TakeCorner(vector<int> &corners, int b, int l, int baseSliceSize,
+                      const int *tileVers, int rows, const int *tileHors, int cols) {
+    int corner = (b == 0 && l == 0) ? min(tileVers[0], tileHors[0]) : corners[b];
+    corners[b] = tileHors[cols - 1];
+    if (l == 0 && b + 1 < baseSliceSize) {
+        corners[b + 1] = tileVers[rows - 1];
+    }
+    return corner;
+}
+
+// 在CPU上按对角带计算[beginBand, endBand)中b<=maxB、l<=maxL的tile，原地更新vers/hors（和corners）
+// onTile在计算每个tile之前拿到它的输入和左上角（MinMax时是0）
+template<typename OnTile>
+static void ComputeTileBands(const vector<int> &baseVals, const vector<int> &latestVals, int step,
+                             int baseSliceSize, int beginBand, int endBand, int maxB, int maxL,
+                             bool isExact, vector<int> &vers, vector<int> &hors, vector<int> &corners,
+                             OnTile onTile) {
+    for (int band = beginBand; band < endBand; band++) {
+        for (int b = max(0, band - maxL); b <= min(maxB, band); b++) {
+            int l = band - b;
+            int rows = TileLength(baseVals.size(), b, step);
+            int cols = TileLength(latestVals.size(), l, step);
+            int *tileVers = vers.data() + (size_t) b * step;
+            int *tileHors = hors.data() + (size_t) l * step;
+            int *bases = const_cast<int *>(baseVals.data()) + (size_t) b * step;
+            int *latests = const_cast<int *>(latestVals.data()) + (size_t) l * step;
+
+            if (isExact) {
+                int corner = TakeCorner(corners, b, l, baseSliceSize, tileVers, rows, tileHors, cols);
+                onTile(b, l, tileVers, rows, tileHors, cols, corner);
+                Mega::CpuLCS_BitParallel(bases, rows, latests, cols, tileVers, rows, tileHors, cols, &corner);
+            } else {
+                onTile(b, l, tileVers, rows, tileHors, cols, 0);
+                Mega::CpuLCS_MinMax(bases, rows, latests, cols, tileVers, rows, tileHors, cols);
+            }
+        }
+    }
+}
+
+vector<pair<int, int>> Mega::HostLCS_WaveFrontTraceback(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int step,
+        size_t memoryBudget) {
+
+    Valid(baseVals, true, step);
+    Valid(latestVals, true, step);
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    if (!engine->IsReady()) {
+        return {};
+    }
+
+    return engine->HostLCS_WaveFrontTraceback(
+            baseVals,
+            latestVals,
+            verWeights,
+            horWeights,
+            step,
+            memoryBudget);
+}
+
+vector<pair<int, int>> MegaLCSEngine::HostLCS_WaveFrontTraceback(
+        vector<int> &baseVals,
+        vector<int> &latestVals,
+        vector<int> &verWeights,
+        vector<int> &horWeights,
+        int step,
+        size_t memoryBudget) {
+
+    int _baseSliceSize = Mega::Valid(baseVals, true, step);
+    int _latestSliceSize = Mega::Valid(latestVals, true, step);
+    int totalWave = _baseSliceSize + _latestSliceSize - 1;
+    long long totalTiles = (long long) _baseSliceSize * _latestSliceSize;
+
+    // 全0（经典LCS）等合法的DP边界可以精确回溯
+    bool isExact = Mega::IsBitParallelFrame(verWeights.data(), verWeights.size(),
+                                            horWeights.data(), horWeights.size());
+    size_t cornerLength = isExact ? _baseSliceSize : 0;
+
+    // 选择能放进预算的最小间隔
+    int interval = 0;
+    for (int k = 1; k <= totalWave; k++) {
+        if (TracebackMemory(k, totalWave, totalTiles, baseVals.size(), latestVals.size(), cornerLength, step)
+            <= memoryBudget) {
+            interval = k;
+            break;
+        }
+    }
+
+    if (interval == 0) {
+        throw runtime_error("memoryBudget is too small.");
+    }
+
+    // 检查点0就是输入的边界权重，第0个带只有tile(0,0)，它的左上角由边界计算
+    MegaLCSCheckpoints checkpoints;
+    checkpoints.interval = interval;
+    checkpoints.isExact = isExact;
+    int checkpointCount = (totalWave + interval - 1) / interval;
+    checkpoints.vers.resize(checkpointCount);
+    checkpoints.hors.resize(checkpointCount);
+    checkpoints.vers[0] = verWeights;
+    checkpoints.hors[0] = horWeights;
+    for (int c = 1; c < checkpointCount; c++) {
+        checkpoints.vers[c].resize(baseVals.size());
+        checkpoints.hors[c].resize(latestVals.size());
+    }
+    if (isExact) {
+        checkpoints.corners.assign(checkpointCount, vector<int>(_baseSliceSize, 0));
+    }
+
+    auto ignoreTile = [](int, int, const int *, int, const int *, int, int) {};
+
+    // 位并行内核按32位word处理tile，超过256的tile由Compact内核计算，这两种情况精确DP在CPU上按tile计算
+    if (isExact && (step % 32 != 0 || step > 256)) {
+        vector<int> corners(_baseSliceSize, 0);
+        for (int band = 0; band < totalWave; band++) {
+            if (band > 0 && band % interval == 0) {
+                checkpoints.vers[band / interval] = verWeights;
+                checkpoints.hors[band / interval] = horWeights;
+                checkpoints.corners[band / interval] = corners;
+            }
+            ComputeTileBands(baseVals, latestVals, step, _baseSliceSize, band, band + 1,
+                             _baseSliceSize - 1, _latestSliceSize - 1,
+                             true, verWeights, horWeights, corners, ignoreTile);
+        }
+    } else if (!RunWaveFront(baseVals, latestVals, verWeights, horWeights, _baseSliceSize, _latestSliceSize,
+                             true, 0, step, step, false, &checkpoints)) {
+        return {};
+    }
+
+    vector<pair<int, int>> pairs;
+    vector<int> workVers;
+    vector<int> workHors;
+    vector<int> workCorners;
+
+    // 三角形区域内每个tile的输入（左边vers段、上边hors段和左上角），key是tile编号
+    struct TileInput {
+        vector<int> leftIn;
+        vector<int> topIn;
+        int corner;
+    };
+    unordered_map<long long, TileInput> tileInputs;
+    vector<int> tileWeights((size_t) step * step);
+
+    auto saveTile = [&tileInputs, _latestSliceSize](int b, int l, const int *tileVers, int rows,
+                                                    const int *tileHors, int cols, int corner) {
+        tileInputs[(long long) b * _latestSliceSize + l] = TileInput{
+                vector<int>(tileVers, tileVers + rows),
+                vector<int>(tileHors, tileHors + cols),
+                corner};
+    };
+
+    int i = baseVals.size() - 1;
+    int j = latestVals.size() - 1;
+
+    while (i >= 0 && j >= 0) {
+        int bi = i / step;
+        int lj = j / step;
+        int segment = (bi + lj) / interval;
+        int segmentBegin = segment * interval;
+
+        // 从检查点重算三角形区域，保存每个tile的输入
+        workVers = checkpoints.vers[segment];
+        workHors = checkpoints.hors[segment];
+        if (isExact) {
+            workCorners = checkpoints.corners[segment];
+        }
+        tileInputs.clear();
+
+        ComputeTileBands(baseVals, latestVals, step, _baseSliceSize, segmentBegin, bi + lj, bi, lj,
+                         isExact, workVers, workHors, workCorners, saveTile);
+
+        // 路径所在的最后一个带只需要tile(bi,lj)的输入
+        int rows = TileLength(baseVals.size(), bi, step);
+        int cols = TileLength(latestVals.size(), lj, step);
+        int *tileVers = workVers.data() + (size_t) bi * step;
+        int *tileHors = workHors.data() + (size_t) lj * step;
+        int corner = isExact ? TakeCorner(workCorners, bi, lj, _baseSliceSize, tileVers, rows, tileHors, cols) : 0;
+        saveTile(bi, lj, tileVers, rows, tileHors, cols, corner);
+
+        // 在这个段内沿路径逐个tile回溯
+        while (i >= 0 && j >= 0 && i / step + j / step >= segmentBegin) {
+            int b = i / step;
+            int l = j / step;
+            const auto &inputs = tileInputs.at((long long) b * _latestSliceSize + l);
+            const vector<int> &leftIn = inputs.leftIn;
+            const vector<int> &topIn = inputs.topIn;
+            const int *bases = baseVals.data() + (size_t) b * step;
+            const int *latests = latestVals.data() + (size_t) l * step;
+            int tileRows = leftIn.size();
+            int tileCols = topIn.size();
+
+            // 展开tile的完整矩阵，行距仍然是step
+            for (int r = 0; r < tileRows; r++) {
+                int leftWeight = leftIn[r];
+                for (int c = 0; c < tileCols; c++) {
+                    int topWeight = r > 0 ? tileWeights[(size_t) (r - 1) * step + c] : topIn[c];
+                    int weight;
+                    if (bases[r] != latests[c]) {
+                        weight = max(leftWeight, topWeight);
+                    } else if (isExact) {
+                        int diagWeight = r > 0
+                                         ? (c > 0 ? tileWeights[(size_t) (r - 1) * step + c - 1] : leftIn[r - 1])
+                                         : (c > 0 ? topIn[c - 1] : inputs.corner);
+                        weight = diagWeight + 1;
+                    } else {
+                        weight = min(leftWeight, topWeight) + 1;
+                    }
+                    tileWeights[(size_t) r * step + c] = weight;
+                    leftWeight = weight;
+                }
+            }
+
+            int r = i - b * step;
+            int c = j - l * step;
+            while (r >= 0 && c >= 0) {
+                if (bases[r] == latests[c]) {
+                    pairs.emplace_back(i, j);
+                    r--;
+                    c--;
+                    i--;
+                    j--;
+                    continue;
+                }
+
+                int leftWeight = c > 0 ? tileWeights[(size_t) r * step + c - 1] : leftIn[r];
+                int topWeight = r > 0 ? tileWeights[(size_t) (r - 1) * step + c] : topIn[c];
+                if (topWeight >= leftWeight) {
+                    r--;
+                    i--;
+                } else {
+                    c--;
+                    j--;
+                }
+            }
+        }
+    }
+
+    reverse(pairs.begin(), pairs.end());
+    return pairs;
+}
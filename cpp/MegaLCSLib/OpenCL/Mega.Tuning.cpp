@@ -0,0 +1,364 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <random>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/*
+每个设备的自动调优结果
+MegaLCSLen原来固定使用在Tesla P40上调出的step=256，换成其他GPU或者CPU的OpenCL运行时不一定最好
+MegaLCS_Tune在合成数据上测试所有组合，结果按设备名和驱动版本保存，驱动升级后自动失效
+文件格式：第一行是完整的key，后面每行一个name=value
+ */
+
+static mutex tuningMutex;
+static bool tuningDirOverridden = false;
+static string tuningDirOverride;
+
+// key -> (是否有结果, 结果)，没有结果的也记下来，避免每次调用都读磁盘
+static map<string, pair<bool, MegaLCSTuning>> tunings;
+
+static const char *SubmitModeName(MegaLCSSubmitMode mode) {
+    return mode == MegaLCSSubmitMode::FinishPerBand ? "FinishPerBand" : "Pipelined";
+}
+
+static const char *KernelVariantName(MegaLCSKernelVariant variant) {
+    switch (variant) {
+        case MegaLCSKernelVariant::Persistent:
+            return "Persistent";
+        case MegaLCSKernelVariant::Compact:
+            return "Compact";
+        default:
+            return "Shared";
+    }
+}
+
+// 只接受调优会选出的值，其他的当作损坏的文件
+static bool ParseTuningLine(const string &line, MegaLCSTuning &tuning) {
+    size_t pos = line.find('=');
+    if (pos == string::npos) {
+        return false;
+    }
+
+    string name = line.substr(0, pos);
+    string value = line.substr(pos + 1);
+    try {
+        if (name == "step") {
+            tuning.step = stoi(value);
+        } else if (name == "threadPerBlock") {
+            tuning.threadPerBlock = stoi(value);
+        } else if (name == "submitMode") {
+            if (value == "FinishPerBand") {
+                tuning.submitMode = MegaLCSSubmitMode::FinishPerBand;
+            } else if (value == "Pipelined") {
+                tuning.submitMode = MegaLCSSubmitMode::Pipelined;
+            } else {
+                return false;
+            }
+        } else if (name == "kernelVariant") {
+            if (value == "Shared") {
+                tuning.kernelVariant = MegaLCSKernelVariant::Shared;
+            } else if (value == "Persistent") {
+                tuning.kernelVariant = MegaLCSKernelVariant::Persistent;
+            } else if (value == "Compact") {
+                tuning.kernelVariant = MegaLCSKernelVariant::Compact;
+            } else {
+                return false;
+            }
+        } else if (name == "cellsPerSecond") {
+            tuning.cellsPerSecond = stod(value);
+        } else {
+            return false;
+        }
+    } catch (const exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+// 只接受调优会选出的值，参数范围和MegaLCS_Fusion、线程粗化内核一致
+static bool IsValidTuning(const MegaLCSTuning &tuning) {
+    if (!(1 <= tuning.step && tuning.step <= 256)) {
+        return false;
+    }
+
+    // 位并行内核的结果是精确DP，批量和一对多内核只在内部使用
+    if (tuning.kernelVariant != MegaLCSKernelVariant::Shared &&
+        tuning.kernelVariant != MegaLCSKernelVariant::Persistent &&
+        tuning.kernelVariant != MegaLCSKernelVariant::Compact) {
+        return false;
+    }
+
+    return tuning.threadPerBlock == 0 ||
+           (1 <= tuning.threadPerBlock && tuning.threadPerBlock <= tuning.step &&
+            tuning.step % tuning.threadPerBlock == 0 && tuning.step / tuning.threadPerBlock <= 32);
+}
+
+static bool ReadTuningFile(const fs::path &file, const string &key, MegaLCSTuning &tuning) {
+    ifstream in(file);
+    if (!in) {
+        return false;
+    }
+
+    // 第一行必须和key完全一致
+    string storedKey;
+    getline(in, storedKey);
+    if (storedKey != key) {
+        return false;
+    }
+
+    MegaLCSTuning loaded;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && !ParseTuningLine(line, loaded)) {
+            return false;
+        }
+    }
+
+    if (!IsValidTuning(loaded)) {
+        return false;
+    }
+
+    tuning = loaded;
+    return true;
+}
+
+// 调优文件的内容：第一行是key，其余每行一个name=value
+static string FormatTuningFile(const string &key, const MegaLCSTuning &tuning) {
+    stringstream out;
+    out << key << "\n"
+        << "step=" << tuning.step << "\n"
+        << "threadPerBlock=" << tuning.threadPerBlock << "\n"
+        << "submitMode=" << SubmitModeName(tuning.submitMode) << "\n"
+        << "kernelVariant=" << KernelVariantName(tuning.kernelVariant) << "\n"
+        << "cellsPerSecond=" << tuning.cellsPerSecond << "\n";
+    return out.str();
+}
+
+void Mega::SetTuningDir(const string &dir) {
+    lock_guard<mutex> lock(tuningMutex);
+    tuningDirOverridden = true;
+    tuningDirOverride = dir;
+    tunings.clear();
+}
+
+string Mega::GetTuningDir() {
+    lock_guard<mutex> lock(tuningMutex);
+    if (tuningDirOverridden) {
+        return tuningDirOverride;
+    }
+
+    const char *env = getenv("MEGALCS_TUNING_DIR");
+    if (env != nullptr) {
+        return env;
+    }
+
+    error_code ec;
+    fs::path tempDir = fs::temp_directory_path(ec);
+    if (ec) {
+        return "";
+    }
+
+    return (tempDir / "MegaLCS" / "tuning").string();
+}
+
+string Mega::GetTuningKey(cl_device_id deviceId) {
+    return "device=" + GetDeviceInfoString(deviceId, CL_DEVICE_NAME) +
+           ";driver=" + GetDeviceInfoString(deviceId, CL_DRIVER_VERSION);
+}
+
+bool Mega::LoadTuning(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        MegaLCSTuning &tuning) {
+
+    if (platformId == nullptr || deviceId == nullptr) {
+        return false;
+    }
+
+    string key = GetTuningKey(deviceId);
+    string tuningDir = GetTuningDir();
+
+    lock_guard<mutex> lock(tuningMutex);
+    auto found = tunings.find(key);
+    if (found == tunings.end()) {
+        MegaLCSTuning loaded;
+        bool isLoaded = !tuningDir.empty() &&
+                        ReadTuningFile(fs::path(tuningDir) / (HashCacheKey(key) + ".txt"), key, loaded);
+        found = tunings.emplace(key, make_pair(isLoaded, loaded)).first;
+    }
+
+    if (!found->second.first) {
+        return false;
+    }
+
+    tuning = found->second.second;
+    return true;
+}
+
+void Mega::SaveTuning(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        const MegaLCSTuning &tuning) {
+
+    if (platformId == nullptr || deviceId == nullptr) {
+        throw runtime_error("device is invalid.");
+    }
+
+    if (!IsValidTuning(tuning)) {
+        throw runtime_error("tuning is invalid.");
+    }
+
+    // 写入磁盘，进程内直接使用新结果
+    string key = GetTuningKey(deviceId);
+    string tuningDir = GetTuningDir();
+    if (!tuningDir.empty()) {
+        // 多个进程同时调优同一个设备时不会读到半个文件
+        WriteFileAtomically((fs::path(tuningDir) / (HashCacheKey(key) + ".txt")).string(), FormatTuningFile(key, tuning));
+    }
+    {
+        lock_guard<mutex> lock(tuningMutex);
+        tunings[key] = make_pair(true, tuning);
+    }
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    if (engine->IsReady()) {
+        engine->SetSubmitMode(tuning.submitMode);
+        engine->SetKernelVariant(tuning.kernelVariant);
+    }
+}
+
+MegaLCSTuning Mega::MegaLCS_Tune(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        int size) {
+
+    // 高和宽两种形状的短边是size/4，也要是最大step的倍数，每个候选的tile都是满的，计时可以直接比较
+    if (!(size >= 1024 && size % 1024 == 0)) {
+        throw runtime_error("size is invalid.");
+    }
+
+    if (platformId == nullptr || deviceId == nullptr) {
+        throw runtime_error("device is invalid.");
+    }
+
+    // 独立的引擎，调优过程中不改变默认引擎的设置
+    MegaLCSEngine engine(platformId, deviceId);
+    if (!engine.IsReady()) {
+        throw runtime_error("Failed to create OpenCL engine for device.");
+    }
+
+    // 单元数相同的三种形状，期望结果由CPU的多线程wavefront计算
+    struct Workload {
+        vector<int> baseVals;
+        vector<int> latestVals;
+        vector<int> expectVers;
+        vector<int> expectHors;
+    };
+
+    vector<pair<int, int>> shapes = {{size,     size},
+                                     {size * 4, size / 4},
+                                     {size / 4, size * 4}};
+    mt19937 random(size);
+    vector<Workload> workloads(shapes.size());
+    for (size_t w = 0; w < shapes.size(); w++) {
+        auto &workload = workloads[w];
+        workload.baseVals.resize(shapes[w].first);
+        workload.latestVals.resize(shapes[w].second);
+        for (auto &val: workload.baseVals) val = (int) (random() % 4);
+        for (auto &val: workload.latestVals) val = (int) (random() % 4);
+
+        workload.expectVers.assign(workload.baseVals.size(), 0);
+        workload.expectHors.assign(workload.latestVals.size(), 0);
+        CpuLCS_WaveFront(workload.baseVals.data(), workload.baseVals.size(),
+                         workload.latestVals.data(), workload.latestVals.size(),
+                         workload.expectVers.data(), workload.expectVers.size(),
+                         workload.expectHors.data(), workload.expectHors.size(),
+                         256);
+    }
+
+    // 线程粗化只用于逐带调度的Shared，常驻内核只启动一次，和提交方式无关
+    vector<MegaLCSTuning> candidates;
+    for (int step: {32, 64, 128, 256}) {
+        for (auto mode: {MegaLCSSubmitMode::FinishPerBand, MegaLCSSubmitMode::Pipelined}) {
+            candidates.push_back({step, 0, mode, MegaLCSKernelVariant::Shared});
+            candidates.push_back({step, step / 4, mode, MegaLCSKernelVariant::Shared});
+            candidates.push_back({step, 0, mode, MegaLCSKernelVariant::Compact});
+        }
+        candidates.push_back({step, 0, MegaLCSSubmitMode::Pipelined, MegaLCSKernelVariant::Persistent});
+    }
+
+    // 结果不对（设备不支持这个组合）时返回false
+    auto runWorkload = [&engine](const MegaLCSTuning &candidate, Workload &workload) {
+        vector<int> verWeights(workload.baseVals.size(), 0);
+        vector<int> horWeights(workload.latestVals.size(), 0);
+        try {
+            if (candidate.threadPerBlock == 0) {
+                engine.HostLCS_WaveFront(workload.baseVals, workload.latestVals, verWeights, horWeights,
+                                         true, candidate.step);
+            } else {
+                engine.HostLCS_WaveFront(workload.baseVals, workload.latestVals, verWeights, horWeights,
+                                         candidate.threadPerBlock, candidate.step);
+            }
+        } catch (const exception &) {
+            return false;
+        }
+        return verWeights == workload.expectVers && horWeights == workload.expectHors;
+    };
+
+    MegaLCSTuning best;
+    double bestSeconds = 0;
+    for (auto &candidate: candidates) {
+        engine.SetSubmitMode(candidate.submitMode);
+        engine.SetKernelVariant(candidate.kernelVariant);
+
+        // 先跑一次编译内核，不计时
+        if (!runWorkload(candidate, workloads[0])) {
+            continue;
+        }
+
+        bool isCorrect = true;
+        auto start = chrono::high_resolution_clock::now();
+        for (auto &workload: workloads) {
+            if (!runWorkload(candidate, workload)) {
+                isCorrect = false;
+                break;
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+        if (isCorrect && (bestSeconds == 0 || seconds < bestSeconds)) {
+            best = candidate;
+            bestSeconds = max(seconds, 1e-9);
+        }
+    }
+
+    if (bestSeconds == 0) {
+        throw runtime_error("No configuration ran correctly on the device.");
+    }
+
+    best.cellsPerSecond = (double) shapes.size() * size * size / bestSeconds;
+    SaveTuning(platformId, deviceId, best);
+    return best;
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2025 Pete Zhang, rivxer@gmail.com, https://github.com/orunco
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "Mega.h"
+
+using namespace std;
+
+/*
+边界权重的打包格式，和KernelLCS_MinMax的PACKED_WEIGHTS版本一致
+MinMax的边界（包括全0的初始边界）相邻差值总是0或1，所以每个位置只需要1位，
+每step个位置再保存一个完整的基准值，tile之间互不依赖，设备端每个tile只读写自己的一条记录
+step=256时一条记录9个word，原始格式是256个int
+ */
+size_t Mega::GetPackedWords(int step) {
+    return 1 + (step + 31) / 32;
+}
+
+bool Mega::PackWeights(const vector<int> &weights, int step, vector<uint32_t> &records) {
+    if (step <= 0 || weights.size() % step != 0) {
+        return false;
+    }
+
+    size_t tileWords = GetPackedWords(step);
+    size_t tileCount = weights.size() / step;
+    records.assign(tileCount * tileWords, 0);
+
+    for (size_t t = 0; t < tileCount; t++) {
+        const int *tile = weights.data() + t * step;
+        uint32_t *record = records.data() + t * tileWords;
+
+        record[0] = (uint32_t) tile[0];
+        for (int i = 1; i < step; i++) {
+            int delta = tile[i] - tile[i - 1];
+            if (delta != 0 && delta != 1) {
+                return false;
+            }
+            record[1 + i / 32] |= (uint32_t) delta << (i % 32);
+        }
+    }
+
+    return true;
+}
+
+void Mega::UnpackWeights(const vector<uint32_t> &records, int step, vector<int> &weights) {
+    size_t tileWords = GetPackedWords(step);
+
+    for (size_t i = 0; i < weights.size(); i++) {
+        const uint32_t *record = records.data() + (i / step) * tileWords;
+        int position = (int) (i % step);
+
+        if (position == 0) {
+            weights[i] = (int) record[0];
+        } else {
+            weights[i] = weights[i - 1] + (int) ((record[1 + position / 32] >> (position % 32)) & 1u);
+        }
+    }
+}
@@ -27,6 +27,11 @@ limitations under the License.
 #include <cstring>
 #include <memory>
 #include <tuple>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <cstdint>
 
 // OpenCL includes
 #ifdef __APPLE__
@@ -37,10 +42,171 @@ limitations under the License.
 
 using namespace std;
 
+class MegaLCSEngine;
+
+// wavefront各个对角带的提交方式
+enum class MegaLCSSubmitMode {
+    // 每个对角带启动内核后都clFinish等待，原始实现
+    FinishPerBand,
+    // 所有对角带连续入队，依靠in-order队列保证先后顺序，只在最后同步一次
+    Pipelined
+};
+
+// Fusion中CPU部分（没有GPU时的全部计算，以及序列不超过step时）使用的实现
+// 没有GPU时MinMax和MinMaxSimd都用多线程的CpuLCS_WaveFront计算整个矩阵
+enum class MegaLCSCpuEngine {
+    // 逐单元的MinMax（CpuLCS_MinMaxBlocked），和GPU内核逐元素等价
+    MinMax,
+    // 位并行的CpuLCS_BitParallel，结果是精确DP，边界不合法时自动回退到MinMax
+    BitParallel,
+    // 反对角线SIMD的CpuLCS_MinMaxSimd，和MinMax逐元素一致
+    MinMaxSimd
+};
+
+// CpuLCS_MinMaxSimd使用的指令集，Auto按运行时检测到的CPU选择最宽的一种
+enum class MegaLCSCpuIsa {
+    Auto,
+    Scalar,
+    AVX2,
+    AVX512,
+    NEON
+};
+
+// tile的调度方式，Shared和Persistent的tile内计算完全相同，结果逐位一致
+enum class MegaLCSKernelVariant {
+    // host逐个对角带启动KernelLCS_MinMax
+    Shared,
+    // 只启动一次KernelLCS_Persistent，常驻的block在设备端按行领取tile
+    Persistent,
+    // host逐个对角带启动KernelLCS_BitParallel，tile内按32位word位并行推进，每个tile只用32个work-item
+    // 匹配掩码按符号散列构建，每个word通道每步推进8行，STEP=256时一个tile只有39次barrier
+    // 结果是精确DP（和CpuLCS_BitParallel一致），不是上面两种的逐位结果
+    // step不是32的倍数或者输入边界不合法时自动使用Shared
+    BitParallel,
+    // 和Shared逐位一致，共享内存里的vers/hors是相对tile最小值的16位数，占用减半
+    // step可以到1024（受设备work-group上限约束），step超过256时总是使用；输入边界不合法时自动使用Shared
+    Compact
+};
+
+// 上传到设备的base/latest的元素类型，内核源码按类型生成
+// 内核只对元素做相等比较，结果和元素宽度无关；窄类型减少上传的字节数和tile的共享内存
+enum class MegaLCSElementType {
+    // uchar，不同值不超过256个
+    UInt8,
+    // ushort，不同值不超过65536个
+    UInt16,
+    // int，原始实现
+    Int32,
+    // long，64位hash等不能缩小的值
+    Int64
+};
+
+// traceback时wavefront的检查点，vers[c]/hors[c]是第c*interval个对角带开始之前完整的边界权重
+// isExact时wavefront使用位并行内核（精确DP），corners[c][b]是同一时刻base第b个slice上待计算tile的左上角权重
+struct MegaLCSCheckpoints {
+    int interval = 0;
+    bool isExact = false;
+    vector<vector<int>> vers;
+    vector<vector<int>> hors;
+    vector<vector<int>> corners;
+};
+
+// 文本文件切分成token的选项，归一化在hash和比较时进行，不修改原文
+struct MegaLCSTokenizeOptions {
+    // token的分隔符，默认按行
+    char delimiter = '\n';
+    // 忽略空白字符（空格、\t、\r、\v、\f）
+    bool ignoreWhitespace = false;
+    // 忽略ASCII大小写
+    bool ignoreCase = false;
+    // <=0时使用全部核心
+    int threadCount = 0;
+};
+
+// 两个文件的token ID，相同（归一化后）的token有相同的ID，ID在[0, alphabetSize)内
+struct MegaLCSTokenizedFiles {
+    vector<int> baseVals;
+    vector<int> latestVals;
+    int alphabetSize = 0;
+};
+
+// 内存映射的文件，空文件不映射，打不开时抛出runtime_error
+// 只传路径时只读打开已有的文件，同时传size时创建（或截断）一个该大小的可写文件
+class MegaLCSMappedFile {
+public:
+    explicit MegaLCSMappedFile(const string &path);
+    MegaLCSMappedFile(const string &path, size_t size);
+    ~MegaLCSMappedFile();
+
+    MegaLCSMappedFile(const MegaLCSMappedFile &) = delete;
+    MegaLCSMappedFile &operator=(const MegaLCSMappedFile &) = delete;
+
+    char *data = nullptr;
+    size_t size = 0;
+
+private:
+    void Open(const string &path, bool writable, size_t size);
+
+    // Windows下的文件和映射句柄
+    void *file = nullptr;
+    void *mapping = nullptr;
+};
+
+// 打包在一起的多对互不相关的序列，整体只上传一次
+// 第p对的base是baseVals[baseOffsets[p], baseOffsets[p+1])，latest同理
+// 两个offsets的长度都是对数+1，第一个是0，最后一个是values的长度
+struct MegaLCSBatch {
+    vector<int> baseVals;
+    vector<int> baseOffsets = {0};
+    vector<int> latestVals;
+    vector<int> latestOffsets = {0};
+};
+
+// 批量计算的结果，第p对的权重按输入的offsets存放
+struct MegaLCSBatchResult {
+    // 是否全部由CPU计算（没有可用的设备）
+    bool processByCpu = false;
+    // 每一对的LCS长度（horWeights的最后一个值），空序列是0
+    vector<int> lengths;
+    // withWeights为true时是每一对的边界权重，否则为空
+    vector<int> verWeights;
+    vector<int> horWeights;
+};
+
+// 一对多比较的结果，下标和输入的candidates一致
+struct MegaLCSOneToManyResult {
+    // 是否全部由CPU计算（没有可用的设备）
+    bool processByCpu = false;
+    // 每个候选和base的LCS长度，任意一边为空时是0
+    vector<int> lengths;
+    // withWeights为true时是每个候选的horWeights，否则为空
+    vector<vector<int>> horWeights;
+};
+
+// 自动调优选出的设备参数，按设备名和驱动版本保存在磁盘上
+// 只在逐位结果相同的内核之间选择，位并行内核（精确DP）不参与
+struct MegaLCSTuning {
+    int step = 256;
+    // 0表示每列一个thread的原始内核，否则是线程粗化内核每个block的thread数
+    int threadPerBlock = 0;
+    MegaLCSSubmitMode submitMode = MegaLCSSubmitMode::Pipelined;
+    MegaLCSKernelVariant kernelVariant = MegaLCSKernelVariant::Shared;
+    // 调优时在合成数据上测得的吞吐（单元/秒）
+    double cellsPerSecond = 0;
+};
+
 class Mega {
+    // 引擎复用下面的私有工具函数（创建队列、程序、内存对象等）
+    friend class MegaLCSEngine;
+
 public:
 
     static const string KernelLCS_Shared;
+    static const string KernelLCS_Persistent;
+    static const string KernelLCS_Coarsened;
+    static const string KernelLCS_BitParallel;
+    static const string KernelLCS_Compact;
+    static const string KernelLCS_Batch;
 
     // 主要的LCS计算函数
     static void HostLCS_WaveFront(
@@ -54,6 +220,48 @@ public:
             int step,
             bool isDebug = false);
 
+    // 元素为uint8_t/uint16_t/int64_t的版本，语义和上面的int版本相同
+    template<typename T>
+    static void HostLCS_WaveFront(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            vector<T>& baseVals,
+            vector<T>& latestVals,
+            vector<int>& verWeights,
+            vector<int>& horWeights,
+            bool isSharedVersion,
+            int step,
+            bool isDebug = false);
+
+    // 线程粗化版本：每个block有threadPerBlock个thread，处理step*step的tile
+    // 每个thread负责step/threadPerBlock列，例如128个thread处理1024宽的tile
+    // 长度不需要是step的倍数，边缘不满的tile由内核按实际长度屏蔽
+    static void HostLCS_WaveFront(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            vector<int>& baseVals,
+            vector<int>& latestVals,
+            vector<int>& verWeights,
+            vector<int>& horWeights,
+            int threadPerBlock,
+            int step,
+            bool isDebug = false);
+
+    // 矩形tile的线程粗化版本：tile是stepBase行*stepLatest列，两个方向的slice数分别计算
+    // 两个序列长度相差很大时，长的方向用更大的tile可以减少对角带（内核启动）的个数
+    // 例如4M*50K的输入，stepBase=2048/stepLatest=256时是2048+196-1个对角带，256*256时是16384+196-1个
+    static void HostLCS_WaveFront(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            vector<int>& baseVals,
+            vector<int>& latestVals,
+            vector<int>& verWeights,
+            vector<int>& horWeights,
+            int threadPerBlock,
+            int stepBase,
+            int stepLatest,
+            bool isDebug = false);
+
     // CPU版本的LCS计算函数
     static void CpuLCS_MinMax(
             int* baseVals, int baseValsLength,
@@ -61,19 +269,152 @@ public:
             int* verWeights, int verWeightsLength,
             int* horWeights, int horWeightsLength);
 
+    // 元素为uint8_t/uint16_t/int64_t的版本，权重仍然是int
+    template<typename T>
+    static void CpuLCS_MinMax(
+            T* baseVals, int baseValsLength,
+            T* latestVals, int latestValsLength,
+            int* verWeights, int verWeightsLength,
+            int* horWeights, int horWeightsLength);
+
+    // cache分块版本，输入输出和CpuLCS_MinMax相同，结果逐元素一致
+    // 按step*step的tile推进，工作集留在L1/L2，step只能是64/128/256/512（编译期特化）
+    static void CpuLCS_MinMaxBlocked(
+            int* baseVals, int baseValsLength,
+            int* latestVals, int latestValsLength,
+            int* verWeights, int verWeightsLength,
+            int* horWeights, int horWeightsLength,
+            int step = 256);
+
     static void CpuLCS_RollLeftTop(
             int* baseVals, int baseValsLength,
             int* latestVals, int latestValsLength,
             int* verWeights, int verWeightsLength,
             int* horWeights, int horWeightsLength);
 
+    // 反对角线SIMD版本，输入输出和CpuLCS_MinMax相同，结果逐元素一致
+    // 指定的指令集当前CPU不支持时抛出runtime_error
+    static void CpuLCS_MinMaxSimd(
+            int* baseVals, int baseValsLength,
+            int* latestVals, int latestValsLength,
+            int* verWeights, int verWeightsLength,
+            int* horWeights, int horWeightsLength,
+            MegaLCSCpuIsa isa = MegaLCSCpuIsa::Auto);
+
+    static bool IsCpuIsaSupported(MegaLCSCpuIsa isa);
+    static MegaLCSCpuIsa GetBestCpuIsa();
+
+    // 公共前缀/后缀的长度（SIMD比较），后缀版本的指针指向最后一个元素之后
+    static size_t CommonPrefixLength(const int* a, const int* b, size_t length);
+    static size_t CommonSuffixLength(const int* aEnd, const int* bEnd, size_t length);
+    // 第一个等于value的字节的位置（SIMD扫描），没有时返回length
+    static size_t FindByte(const char* data, size_t length, char value);
+
+    // 多线程tile wavefront版本，输入输出和CpuLCS_MinMax相同，结果逐元素一致
+    // 按step*step分块，tile的左边和上边完成后即可执行，threadCount<=0时使用全部核心
+    static void CpuLCS_WaveFront(
+            int* baseVals, int baseValsLength,
+            int* latestVals, int latestValsLength,
+            int* verWeights, int verWeightsLength,
+            int* horWeights, int horWeightsLength,
+            int step,
+            int threadCount = 0);
+
+    // 位并行版本，输入输出和CpuLCS_MinMax相同，结果和CpuLCS_DPMatrix一致
+    // 边界不是合法DP边界时回退到CpuLCS_MinMax
+    // leftTopWeight是左上角（vers[-1]/hors[-1]）的权重，不传时取min(verWeights[0], horWeights[0])
+    static void CpuLCS_BitParallel(
+            int* baseVals, int baseValsLength,
+            int* latestVals, int latestValsLength,
+            int* verWeights, int verWeightsLength,
+            int* horWeights, int horWeightsLength,
+            const int* leftTopWeight = nullptr);
+
+    template<typename T>
+    static void CpuLCS_BitParallel(
+            T* baseVals, int baseValsLength,
+            T* latestVals, int latestValsLength,
+            int* verWeights, int verWeightsLength,
+            int* horWeights, int horWeightsLength,
+            const int* leftTopWeight = nullptr);
+
     static pair<vector<int>, vector<int>> CpuLCS_DPMatrix(
             const vector<int>& baseVals,
             const vector<int>& latestVals);
 
+    // wavefront计算边界权重，额外返回一条回溯路径上的匹配对(base下标, latest下标)
+    // 输入边界是合法的DP边界时（例如全0）权重是精确DP（和CpuLCS_BitParallel一致），路径是一条最长公共子序列，
+    // 匹配对数等于horWeights.back()-horWeights在输入时的最后一个值；step是32的倍数时在设备上用位并行内核，否则在CPU上计算
+    // 其他边界只能按MinMax的规则（和共享内存版本的HostLCS_WaveFront相同）回溯，路径是启发式的，不保证最长，对数也不一定等于权重
+    // wavefront每隔k个对角带把边界权重保存到host，回溯时从检查点只重算路径经过的tile
+    // memoryBudget是检查点和重算使用的字节数上限，引擎据此选择k，放不下时抛出runtime_error
+    static vector<pair<int, int>> HostLCS_WaveFrontTraceback(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            vector<int>& baseVals,
+            vector<int>& latestVals,
+            vector<int>& verWeights,
+            vector<int>& horWeights,
+            int step,
+            size_t memoryBudget);
+
+    // 编译后内核的磁盘缓存目录，空字符串表示关闭缓存
+    // 默认取环境变量MEGALCS_KERNEL_CACHE_DIR，未设置时使用系统临时目录下的MegaLCS/kernels
+    static void SetKernelCacheDir(const string &dir);
+    static string GetKernelCacheDir();
+
+    // 在方形、高、宽三种形状的合成数据上逐个测试step、threadPerBlock、提交方式和内核变体的组合，
+    // 返回总时间最短的一组，写入调优目录并应用到这个设备的默认引擎
+    // size是方形的边长，必须是1024的倍数；设备不可用时抛出runtime_error
+    static MegaLCSTuning MegaLCS_Tune(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            int size = 4096);
+
+    // 保存设备的调优结果：写入调优目录、替换进程内的结果并应用到默认引擎，MegaLCS_Tune结束时调用
+    // 也可以用来直接指定参数，例如部署时复制另一台同型号机器的结果
+    static void SaveTuning(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            const MegaLCSTuning &tuning);
+
+    // 读取设备的调优结果（进程内只读一次磁盘），设备名或驱动版本不同、文件不存在或损坏时返回false
+    // 默认引擎创建时、MegaLCS_Fusion和MegaLCSLen都会自动使用
+    static bool LoadTuning(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            MegaLCSTuning &tuning);
+
+    // 调优结果的目录，空字符串表示不读写磁盘，修改时清空进程内已经读到的结果
+    // 默认取环境变量MEGALCS_TUNING_DIR，未设置时使用系统临时目录下的MegaLCS/tuning
+    static void SetTuningDir(const string &dir);
+    static string GetTuningDir();
+
     // OpenCL设备管理函数
     static vector<tuple<cl_platform_id, cl_device_id, string, cl_device_type>> GetAllDevices();
     static pair<cl_platform_id, cl_device_id> GetFirstGpuDevice();
+    // 把一个CPU OpenCL设备按计算单元平均切成count个子设备（clCreateSubDevices），不支持时返回空
+    // 子设备和默认引擎一样在进程内一直有效，不需要释放
+    static vector<pair<cl_platform_id, cl_device_id>> CreateSubDevices(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            int count);
+
+    // 多设备：latest方向按列分给各个设备，base方向切成行带，设备之间按行带流水线传递右边界
+    // 设备d算完第k个行带就把右边界交给设备d+1，同时开始第k+1个行带
+    // throughputs为空时用MeasureDeviceThroughput测出每个设备的吞吐，列数按吞吐的比例分配
+    // 初始权重都是0，结果和CpuLCS_MinMax相同，引擎设置成位并行内核时也用MinMax的内核；某一块在设备上出错时改在CPU上计算
+    static pair<vector<int>, vector<int>> MegaLCS_MultiDevice(
+            const vector<pair<cl_platform_id, cl_device_id>>& devices,
+            const vector<int>& baseVals,
+            const vector<int>& latestVals,
+            int step,
+            vector<double> throughputs = {});
+
+    // 每个设备在合成数据上的吞吐（单元/秒），设备不可用时是0
+    static vector<double> MeasureDeviceThroughput(
+            const vector<pair<cl_platform_id, cl_device_id>>& devices,
+            int step);
 
     // Fusion函数
     static int MegaLCSLen(const vector<int>& baseVals, const vector<int>& latestVals);
@@ -83,32 +424,260 @@ public:
             const vector<int>& baseVals,
             const vector<int>& latestVals,
             int step,
-            bool isDebug = false);
+            bool isDebug = false,
+            MegaLCSCpuEngine cpuEngine = MegaLCSCpuEngine::MinMax);
+
+    // 批量计算多对互不相关的序列，初始权重都是0，结果和逐对调用MegaLCS_Fusion相同
+    // 所有对只上传一次、启动一次内核，常驻的block按单元数从大到小领取，每对由一个block计算
+    // tile数超过BatchMaxTilesPerPair的大对单独走HostLCS_WaveFront；没有设备时多线程在CPU上计算
+    static MegaLCSBatchResult MegaLCS_Batch(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            const MegaLCSBatch& batch,
+            int step,
+            bool withWeights = false);
+
+    // 同一个base和很多个候选比较，初始权重都是0，结果和逐个调用MegaLCS_Fusion相同
+    // base只上传一次并常驻在设备上，候选分块上传，同一块的所有候选在一次启动里并排计算
+    // 候选个数不足以占满设备时，大的候选单独走HostLCS_WaveFront；没有设备时多线程在CPU上计算
+    static MegaLCSOneToManyResult MegaLCS_OneToMany(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            const vector<int>& baseVals,
+            const vector<vector<int>>& candidates,
+            int step,
+            bool withWeights = false);
+
+    // 超过设备（或host）内存的序列，两个文件都是原始的int32数组（例如MegaLCS_LoadFiles的结果写到磁盘）
+    // 内存映射后流式计算，初始权重都是0，返回LCS长度，和MegaLCS_Fusion的结果相同
+    // latest方向按列条带处理，条带内base方向逐块上传，下一块的上传和当前块的计算重叠
+    // 竖直边界（base长度）在条带之间传递，host上放不进memoryBudget时放在临时的内存映射文件里
+    // memoryBudget是设备缓冲区使用的字节数上限，放不下一个step*step的tile时抛出runtime_error
+    static long long MegaLCS_Streaming(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            const string& basePath,
+            const string& latestPath,
+            int step,
+            size_t memoryBudget);
+
+    // 把逐对的序列打包成MegaLCSBatch
+    static MegaLCSBatch PackBatch(const vector<pair<vector<int>, vector<int>>>& pairs);
+
+    // 内存映射两个文本文件，并行切分、hash并在共享的表里驻留成稠密的ID
+    // 结果可以直接作为HostLCS_WaveFront/MegaLCS_Fusion的输入，文件打不开时抛出runtime_error
+    static MegaLCSTokenizedFiles MegaLCS_LoadFiles(
+            const string& basePath,
+            const string& latestPath,
+            const MegaLCSTokenizeOptions& options = MegaLCSTokenizeOptions());
+
+    // 把两个序列里出现的值按大小映射成稠密的名次[0, 不同值的个数)，返回不同值的个数
+    // 相同的值名次相同，所以LCS和所有权重都不变；T可以是uint8_t/uint16_t/int/int64_t
+    template<typename T>
+    static int RemapDense(
+            const vector<T>& baseVals,
+            const vector<T>& latestVals,
+            vector<int>& baseRanks,
+            vector<int>& latestRanks);
+
+    // 能容纳[0, alphabetSize)的最窄元素类型
+    static MegaLCSElementType GetNarrowestElementType(int alphabetSize);
+
+    // 边界权重的打包格式（KernelLCS_MinMax的PACKED_WEIGHTS版本使用）：每step个位置一条GetPackedWords(step)个word的记录
+    // 第0个word是记录第一个位置的权重，之后每个位置1位，表示和前一个位置的差值
+    static size_t GetPackedWords(int step);
+
+    // weights.size()必须是step的倍数，记录内相邻差值不是0或1时返回false
+    static bool PackWeights(const vector<int>& weights, int step, vector<uint32_t>& records);
+
+    // weights.size()决定解码的位置数
+    static void UnpackWeights(const vector<uint32_t>& records, int step, vector<int>& weights);
+
+    // LCS的对齐结果：按下标递增的匹配对(base下标, latest下标)
+    // Hirschberg分治，分割点由正向/反向两次精确DP的horWeights决定，内存O(m+n)，结果是一条最长公共子序列
+    // step是32的倍数时分割在设备上用位并行内核计算（不改变默认引擎的设置），否则用CpuLCS_BitParallel
+    static vector<pair<int, int>> MegaLCS_Alignment(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            const vector<int>& baseVals,
+            const vector<int>& latestVals,
+            int step);
+    static vector<pair<int, int>> MegaLCSAlign(const vector<int>& baseVals, const vector<int>& latestVals);
+
+    // 先裁掉公共前缀/后缀，再用两边都唯一的元素做锚点（patience diff）把剩下的部分切成独立的空隙并行计算
+    // 返回(LCS长度, 是否精确)：没有用到锚点、并且每个空隙都由精确的位并行引擎计算（CPU的BitParallel引擎，
+    // 或者设备上step是32倍数的BitParallel内核变体）时是精确的；其他情况是近似值（空隙的引擎精确时不超过真实的LCS）
+    static pair<int, bool> MegaLCS_Anchored(
+            cl_platform_id platformId,
+            cl_device_id deviceId,
+            const vector<int>& baseVals,
+            const vector<int>& latestVals,
+            int step,
+            bool useAnchors = true,
+            MegaLCSCpuEngine cpuEngine = MegaLCSCpuEngine::BitParallel);
 
 private:
-    // 验证输入参数
+    // 一次计算几对序列，决定内核源码；和调度方式无关，不放进公开的MegaLCSKernelVariant
+    enum class PairLayout {
+        // HostLCS_WaveFront：一对序列，由MegaLCSKernelVariant选择内核
+        Single,
+        // HostLCS_Batch使用的KernelLCS_Batch，一个block独占一对序列
+        Batch,
+        // HostLCS_OneToMany使用定义了SHARED_BASE的KernelLCS_Batch，所有候选共用一个base
+        OneToMany
+    };
+
+    // MegaLCSLen/MegaLCSAlign使用的设备，只枚举一次
+    static pair<cl_platform_id, cl_device_id> GetDefaultGpuDevice();
+
+    // MegaLCSLen/MegaLCSAlign使用的step：有调优结果时用调优的step，否则是256
+    static int GetDefaultStep(cl_platform_id platformId, cl_device_id deviceId);
+
+    // 列块流水线，MegaLCS_MultiDevice和Fusion的CPU/GPU同时计算共用
+    // 第b个列块是latest的[columnBegins[b], columnBegins[b+1])，由engines[b]计算，engines[b]为空时用CPU的多线程wavefront
+    // base方向切成bandCount个行带，每个列块一个线程，算完一个行带就把右边界交给下一个列块
+    // 设备上固定用MinMax的内核，设备出错的块改在CPU上计算，返回(verWeights, horWeights)
+    static pair<vector<int>, vector<int>> RunColumnPipeline(
+            const vector<shared_ptr<MegaLCSEngine>>& engines,
+            const vector<int>& columnBegins,
+            const vector<int>& baseVals,
+            const vector<int>& latestVals,
+            int step,
+            int bandCount);
+
+    // 批量和一对多接口共用：设备上常驻的block个数，每个计算单元放几个block
+    static size_t ResidentPairBlocks(cl_device_id deviceId);
+
+    // 批量和一对多接口共用的分流：tile数超过单个block独占的上限、并且超过一个常驻block平均分到的tile数的对
+    // 会拖住整个启动，改为单独走整个矩阵的wavefront；返回(这些大对, 其余的对)的下标
+    static pair<vector<int>, vector<int>> SplitLargePairs(
+            cl_device_id deviceId,
+            const vector<long long>& pairTiles);
+
+    // 批量和一对多接口没有设备时共用：多个线程按顺序领取pairIds里的对，每一对用分块的CpuLCS_MinMaxBlocked计算
+    // pairAt(id)返回这一对的(base, baseLength, latest, latestLength)，LCS长度写到lengths[id]
+    // store不为空时由各个线程调用store(id, verWeights, horWeights)，任意一边为空的对不调用
+    static void CpuLCS_Pairs(
+            const vector<int>& pairIds,
+            const function<tuple<const int *, size_t, const int *, size_t>(int)>& pairAt,
+            vector<int>& lengths,
+            const function<void(int, const vector<int>&, const vector<int>&)>& store);
+
+    // 验证输入参数，返回slice数，最后一个slice可以不满step
     static int Valid(
             const vector<int>& originalValues,
             bool IsSharedVersion,
             int step);
 
-    // 创建内存对象
+    static int Valid(
+            size_t length,
+            bool IsSharedVersion,
+            int step);
+
+    // 验证线程粗化版本的参数
+    static int ValidCoarsened(
+            const vector<int>& originalValues,
+            int threadPerBlock,
+            int step);
+
+    // 验证矩形tile的行数（base方向），列数（latest方向）仍由ValidCoarsened验证
+    static int ValidStepBase(
+            const vector<int>& originalValues,
+            int stepBase);
+
+    // 边界权重是否满足位并行的要求：相邻差值∈{0,1}，|vers[0]-hors[0]|<=1
+    static bool IsBitParallelFrame(
+            const int* verWeights, int verWeightsLength,
+            const int* horWeights, int horWeightsLength,
+            const int* leftTopWeight = nullptr);
+
+    // 创建内存对象，base/latest按元素类型T上传
+    template<typename T>
     static bool CreateMemObjects(
             cl_context context,
             cl_mem memObjects[4],
             cl_command_queue commandQueue,
-            const vector<int>& bases,
-            const vector<int>& latests,
+            const vector<T>& bases,
+            const vector<T>& latests,
             vector<int>& verWeights,
             vector<int>& horWeights);
 
+    // 权重按给定的字节上传，打包的边界使用
+    template<typename T>
+    static bool CreateMemObjects(
+            cl_context context,
+            cl_mem memObjects[4],
+            cl_command_queue commandQueue,
+            const vector<T>& bases,
+            const vector<T>& latests,
+            const void* verData,
+            size_t verBytes,
+            const void* horData,
+            size_t horBytes);
+
     // 创建程序
     static cl_program CreateProgram(
             cl_context context,
             cl_device_id device,
             bool IsSharedVersion,
             int _step,
-            bool isDebug);
+            bool isDebug,
+            MegaLCSKernelVariant variant = MegaLCSKernelVariant::Shared,
+            int threadPerBlock = 0,
+            MegaLCSElementType elementType = MegaLCSElementType::Int32,
+            bool isPackedWeights = false,
+            int _stepBase = 0,
+            PairLayout layout = PairLayout::Single);
+
+    // 设备信息字符串，查询失败时为空
+    static string GetDeviceInfoString(cl_device_id device, cl_device_info param);
+
+    // FNV-1a 64位hash的16位十六进制，用作缓存文件名
+    static string HashCacheKey(const string &text);
+
+    // 调优结果的key：设备名和驱动版本
+    static string GetTuningKey(cl_device_id deviceId);
+
+    // 内核二进制缓存的key：设备名、驱动版本、step、编译选项和源码hash
+    static string GetProgramCacheKey(
+            cl_device_id device,
+            const string &code,
+            int _step,
+            const string &compileOptions);
+
+    // 从磁盘缓存加载并构建程序，没有命中返回nullptr
+    static cl_program LoadProgramBinary(
+            cl_context context,
+            cl_device_id device,
+            const string &cacheKey,
+            const string &compileOptions);
+
+    // 先写同一目录下的临时文件再改名，读的一方只会看到旧文件或者完整的新文件；失败时返回false
+    // 内核缓存和调优结果共用，父目录不存在时创建
+    static bool WriteFileAtomically(const string &path, const string &contents);
+
+    // 把已经构建好的程序二进制写入磁盘缓存
+    static void SaveProgramBinary(
+            cl_program program,
+            const string &cacheKey);
+
+    // 使用构建时预编译并内嵌到库里的SPIR-V创建程序，没有对应step时返回nullptr
+    static cl_program CreateProgramFromEmbeddedIL(
+            cl_context context,
+            cl_device_id device,
+            int _step);
+
+    // 内嵌的SPIR-V（MEGALCS_EMBED_KERNEL_IL构建选项），没有时返回false
+    static bool GetEmbeddedKernelIL(
+            int _step,
+            const unsigned char **data,
+            size_t *size);
+
+    // 构建程序，失败时打印编译日志
+    static bool BuildProgram(
+            cl_program program,
+            cl_device_id device,
+            const string &compileOptions);
 
     // 清理资源
     static void Cleanup(
@@ -124,4 +693,250 @@ private:
             cl_device_id* device);
 };
 
+/*
+常驻的LCS计算引擎，绑定到一个OpenCL设备
+context/commandQueue在构造时创建一次，每个step的program/kernel在第一次使用时编译并缓存，
+之后的调用只需要创建内存对象和启动内核，不再重复 clCreateContext/clBuildProgram
+所有公开函数都持有内部互斥锁，可以在多个host线程间共享同一个实例
+ */
+class MegaLCSEngine {
+public:
+    MegaLCSEngine(cl_platform_id platformId, cl_device_id deviceId);
+
+    ~MegaLCSEngine();
+
+    MegaLCSEngine(const MegaLCSEngine &) = delete;
+
+    MegaLCSEngine &operator=(const MegaLCSEngine &) = delete;
+
+    // context和commandQueue是否创建成功
+    bool IsReady() const;
+
+    cl_platform_id GetPlatformId() const;
+
+    cl_device_id GetDeviceId() const;
+
+    // 默认Pipelined，isDebug时总是逐带同步以便打印中间结果
+    void SetSubmitMode(MegaLCSSubmitMode mode);
+
+    MegaLCSSubmitMode GetSubmitMode();
+
+    // 默认Shared
+    void SetKernelVariant(MegaLCSKernelVariant variant);
+
+    MegaLCSKernelVariant GetKernelVariant();
+
+    // 默认关闭；打开后先把输入映射成稠密的名次（RemapDense），再用最窄的元素类型上传
+    // 映射是一次排序，输入已经是稠密ID（例如MegaLCS_LoadFiles的结果）时直接使用对应的模板版本更快
+    void SetElementNarrowing(bool isNarrowing);
+
+    bool GetElementNarrowing();
+
+    // 默认关闭；打开后MegaLCS_Fusion在设备上计算时，latest方向右边的一部分列同时交给CPU的多线程wavefront，
+    // 按行带流水线接收设备算完的左边界，列数按第一次测出的CPU/设备吞吐比分配
+    // 只用于tile内是MinMax的内核（位并行内核的结果是精确DP，不和CPU的MinMax混用）
+    void SetCpuCoExecution(bool isCoExecution);
+
+    bool GetCpuCoExecution();
+
+    // 默认关闭；打开后共享内存内核的边界权重在设备上按位打包（Mega::PackWeights的格式），
+    // 设备内存和每个tile读写边界的流量降到约1/28（step=256），host直接读回打包的结果再解码
+    // 只用于逐带调度的KernelLCS_MinMax，输入边界不是合法的DP边界（Mega::IsBitParallelFrame）、
+    // 在tile内的差值不是0或1、调试或者traceback时使用原始格式
+    void SetPackedWeights(bool isPacked);
+
+    bool GetPackedWeights();
+
+    // 和 Mega::HostLCS_WaveFront 的语义完全一致，只是复用了引擎内的OpenCL对象
+    void HostLCS_WaveFront(
+            vector<int> &baseVals,
+            vector<int> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            bool isSharedVersion,
+            int step,
+            bool isDebug = false);
+
+    // 元素为uint8_t/uint16_t/int64_t的版本
+    template<typename T>
+    void HostLCS_WaveFront(
+            vector<T> &baseVals,
+            vector<T> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            bool isSharedVersion,
+            int step,
+            bool isDebug = false);
+
+    // 和 Mega::HostLCS_WaveFront 的线程粗化版本语义一致
+    void HostLCS_WaveFront(
+            vector<int> &baseVals,
+            vector<int> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int threadPerBlock,
+            int step,
+            bool isDebug = false);
+
+    // 和 Mega::HostLCS_WaveFront 的矩形tile版本语义一致
+    void HostLCS_WaveFront(
+            vector<int> &baseVals,
+            vector<int> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int threadPerBlock,
+            int stepBase,
+            int stepLatest,
+            bool isDebug = false);
+
+    // 和共享内存版本的HostLCS_WaveFront相同，OpenCL出错时返回false，权重保持不变
+    bool TryHostLCS_WaveFront(
+            vector<int> &baseVals,
+            vector<int> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int step);
+
+    // 同上，这一次使用指定的内核变体，不改变引擎的设置；step或边界不满足要求时和设置的变体一样回退
+    bool TryHostLCS_WaveFront(
+            vector<int> &baseVals,
+            vector<int> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int step,
+            MegaLCSKernelVariant variant);
+
+    // 和 Mega::HostLCS_WaveFrontTraceback 语义一致，逐带调度KernelLCS_BitParallel（精确）或KernelLCS_MinMax
+    vector<pair<int, int>> HostLCS_WaveFrontTraceback(
+            vector<int> &baseVals,
+            vector<int> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int step,
+            size_t memoryBudget);
+
+    // 和 Mega::MegaLCS_Batch 的设备部分一致：所有对都在设备上计算，不拆分大对
+    // OpenCL出错时打印错误并返回false
+    bool HostLCS_Batch(
+            const MegaLCSBatch &batch,
+            int step,
+            bool withWeights,
+            MegaLCSBatchResult &result);
+
+    // 和 Mega::MegaLCS_OneToMany 的设备部分一致：所有候选都在设备上计算，不拆分大的候选
+    // OpenCL出错时打印错误并返回false
+    bool HostLCS_OneToMany(
+            const vector<int> &baseVals,
+            const vector<vector<int>> &candidates,
+            int step,
+            bool withWeights,
+            MegaLCSOneToManyResult &result);
+
+    // 和 Mega::MegaLCS_Streaming 的设备部分一致，输入可以是内存映射的区域，下标都是64位
+    // verWeights（base长度）既是输入也是输出，length是最后的LCS长度
+    // OpenCL出错时打印错误并返回false
+    bool HostLCS_Streaming(
+            const int *baseVals,
+            long long baseLength,
+            const int *latestVals,
+            long long latestLength,
+            int *verWeights,
+            int step,
+            size_t memoryBudget,
+            long long &length);
+
+    // 每个设备一个默认实例，Mega的静态函数都通过它执行
+    static shared_ptr<MegaLCSEngine> GetDefault(cl_platform_id platformId, cl_device_id deviceId);
+
+private:
+    // 参数已经校验过，threadPerBlock为0表示每列一个thread的原始内核
+    // step是tile的列数（latest方向），stepBase是行数（base方向），只有线程粗化的内核支持两者不同
+    // OpenCL出错时打印错误并返回false，权重保持不变
+    template<typename T>
+    bool RunWaveFront(
+            vector<T> &baseVals,
+            vector<T> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int _baseSliceSize,
+            int _latestSliceSize,
+            bool isSharedVersion,
+            int threadPerBlock,
+            int step,
+            int stepBase,
+            bool isDebug,
+            MegaLCSCheckpoints *checkpoints = nullptr,
+            optional<MegaLCSKernelVariant> callVariant = nullopt);
+
+    // 打开了元素缩小时先映射再按最窄的类型调用RunWaveFront，否则直接调用
+    template<typename T>
+    bool RunWaveFrontNarrowed(
+            vector<T> &baseVals,
+            vector<T> &latestVals,
+            vector<int> &verWeights,
+            vector<int> &horWeights,
+            int _baseSliceSize,
+            int _latestSliceSize,
+            bool isSharedVersion,
+            int threadPerBlock,
+            int step,
+            int stepBase,
+            bool isDebug,
+            optional<MegaLCSKernelVariant> callVariant = nullopt);
+
+    // 获取（必要时编译）指定step的内核，调用方必须持有engineMutex
+    cl_kernel GetKernel(
+            MegaLCSKernelVariant variant,
+            bool isSharedVersion,
+            int threadPerBlock,
+            int step,
+            int stepBase,
+            bool isDebug,
+            MegaLCSElementType elementType = MegaLCSElementType::Int32,
+            bool isPackedWeights = false,
+            Mega::PairLayout layout = Mega::PairLayout::Single);
+
+    // host逐个对角带启动内核，参数0-5已经设置好
+    // checkpoints不为空时每interval个对角带把边界权重异步读回host，cornerMem不为空时同时读回tile左上角
+    bool EnqueueWaveFrontBands(
+            cl_kernel kernel,
+            cl_mem deviceMemObjects[4],
+            int _baseSliceSize,
+            int _latestSliceSize,
+            size_t baseLength,
+            size_t latestLength,
+            int threadPerBlock,
+            int step,
+            bool isDebug,
+            MegaLCSCheckpoints *checkpoints = nullptr,
+            cl_mem cornerMem = nullptr);
+
+    // 一次启动常驻内核完成全部tile，参数0-5已经设置好
+    bool EnqueuePersistent(
+            cl_kernel kernel,
+            int _baseSliceSize,
+            int step);
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+    cl_context context = nullptr;
+    cl_command_queue commandQueue = nullptr;
+
+    mutex engineMutex;
+
+    MegaLCSSubmitMode submitMode = MegaLCSSubmitMode::Pipelined;
+
+    MegaLCSKernelVariant kernelVariant = MegaLCSKernelVariant::Shared;
+
+    bool elementNarrowing = false;
+
+    bool packedWeights = false;
+
+    bool cpuCoExecution = false;
+
+    // key: (variant, isSharedVersion, threadPerBlock, step, stepBase, isDebug, elementType, isPackedWeights, layout)
+    map<tuple<MegaLCSKernelVariant, bool, int, int, int, bool, MegaLCSElementType, bool, Mega::PairLayout>,
+            pair<cl_program, cl_kernel>> kernelCache;
+};
+
 #endif //CPP_MEGA_H
@@ -11,6 +11,23 @@ using namespace std::chrono;
 MegaLCS Performance Test
 ========================
 
+下面是逐带clFinish（MegaLCSSubmitMode::FinishPerBand，原始实现）的结果
+现在每个size会依次跑FinishPerBand、Pipelined两种提交方式、Pipelined下的位并行内核和Compact内核（step=256/1024），输出每一行时间以便对比
+每种方式计时前先在4*step的数据上不计时跑一次，编译内核的时间不算在先跑的FinishPerBand里
+注意位并行内核的结果是精确DP，输入是0..MAX-1时和其他内核相同
+
+Compact内核每个work-group的共享内存（每列：bases+latests+vers+hors）：
+              int元素            uchar元素
+  Shared      16*STEP  (256: 4KB)  10*STEP (256: 2.5KB)
+  Compact     12*STEP  (256: 3KB)   6*STEP (256: 1.5KB, 1024: 6KB)
+按公开的规格估算的每个计算单元常驻work-group数（STEP=256 / STEP=1024）：
+  NVIDIA Pascal SM（96KB, 2048线程）：Shared 8/-  Compact 8/2，都受线程数限制
+  AMD GCN CU（64KB LDS, 2560线程）：  Shared 10/- Compact 10/2，受线程数限制
+  Intel Gen9 子片（64KB SLM, 1792线程）：Shared 7/-  Compact 7/1，受线程数限制
+这几类设备上常驻数都受线程数限制，压缩本身不改变占用率，主要的收益是step可以到1024：
+对角带数从2N/256-1减少到2N/1024-1，内核启动次数减少到1/4，每个tile的全局内存读写摊到4倍的单元上
+上面的执行时间是Tesla P40上的Shared结果，Compact的数据需要在GPU上重新运行本程序
+
 Testing size: 65536
 Found GPU device: Tesla P40
   Execution time: 204 ms
@@ -60,30 +77,57 @@ int main() {
             continue;
         }
 
-        // 准备权重数组
-        vector<int> verWeights = inputArray;
-        vector<int> horWeights = inputArray;
-
-        // 执行性能测试
-        auto start = high_resolution_clock::now();
-
-        Mega::HostLCS_WaveFront(
-                platformId,
-                deviceId,
-                inputArray,
-                inputArray,
-                verWeights,
-                horWeights,
-                true,
-                STEP,
-                false
-        );
-
-        auto end = high_resolution_clock::now();
-        auto duration = duration_cast<milliseconds>(end - start);
-
-        cout << "  Execution time: " << duration.count() << " ms" << endl;
-        cout << "  Result: " << horWeights.back() << endl;
+        auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+
+        // 提交方式对比，以及Pipelined下位并行内核和Compact内核的对比
+        vector<tuple<MegaLCSSubmitMode, MegaLCSKernelVariant, int>> runs = {
+                {MegaLCSSubmitMode::FinishPerBand, MegaLCSKernelVariant::Shared,      STEP},
+                {MegaLCSSubmitMode::Pipelined,     MegaLCSKernelVariant::Shared,      STEP},
+                {MegaLCSSubmitMode::Pipelined,     MegaLCSKernelVariant::BitParallel, STEP},
+                {MegaLCSSubmitMode::Pipelined,     MegaLCSKernelVariant::Compact,     STEP},
+                {MegaLCSSubmitMode::Pipelined,     MegaLCSKernelVariant::Compact,     1024}
+        };
+
+        for (auto &run: runs) {
+            engine->SetSubmitMode(get<0>(run));
+            engine->SetKernelVariant(get<1>(run));
+
+            // 先在一小段数据上不计时跑一次，内核编译不算在第一种方式的时间里
+            vector<int> warmUpArray(inputArray.begin(), inputArray.begin() + 4 * get<2>(run));
+            vector<int> warmUpVers = warmUpArray;
+            vector<int> warmUpHors = warmUpArray;
+            Mega::HostLCS_WaveFront(platformId, deviceId, warmUpArray, warmUpArray,
+                                    warmUpVers, warmUpHors, true, get<2>(run), false);
+
+            // 准备权重数组
+            vector<int> verWeights = inputArray;
+            vector<int> horWeights = inputArray;
+
+            // 执行性能测试
+            auto start = high_resolution_clock::now();
+
+            Mega::HostLCS_WaveFront(
+                    platformId,
+                    deviceId,
+                    inputArray,
+                    inputArray,
+                    verWeights,
+                    horWeights,
+                    true,
+                    get<2>(run),
+                    false
+            );
+
+            auto end = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end - start);
+
+            cout << (get<0>(run) == MegaLCSSubmitMode::Pipelined ? "  [Pipelined]" : "  [FinishPerBand]")
+                 << (get<1>(run) == MegaLCSKernelVariant::BitParallel ? "[BitParallel]" : "")
+                 << (get<1>(run) == MegaLCSKernelVariant::Compact ? "[Compact " + to_string(get<2>(run)) + "]" : "")
+                 << endl;
+            cout << "  Execution time: " << duration.count() << " ms" << endl;
+            cout << "  Result: " << horWeights.back() << endl;
+        }
     }
 
     return 0;
@@ -0,0 +1,88 @@
+// MegaLCSPerfBatch.cpp
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "Mega.h"
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+MegaLCS Batch Performance Test
+==============================
+
+模拟一个大changeset里逐文件的diff：每一对的长度在[64, 1024)内随机，80%的元素相同
+每个批次比较三种方式的pairs/s：
+  [PerPair]  逐对调用MegaLCS_Fusion（只跑到10000对，更多时太慢）
+  [Batch]    MegaLCS_Batch，所有对一次上传、一次启动
+  [Cpu]      MegaLCS_Batch不传设备，多线程逐对计算
+GPU上的数据需要在有GPU的机器上运行本程序得到，这里没有记录
+*/
+int main() {
+    vector<int> pairCounts = {1000, 10000, 100000};
+    int STEP = 256;
+
+    cout << "MegaLCS Batch Performance Test" << endl;
+    cout << "==============================" << endl;
+
+    auto devicePair = Mega::GetFirstGpuDevice();
+    cl_platform_id platformId = devicePair.first;
+    cl_device_id deviceId = devicePair.second;
+
+    for (int pairCount: pairCounts) {
+        cout << "\nTesting pairs: " << pairCount << endl;
+
+        // 准备测试数据
+        mt19937 rand(pairCount);
+        vector<pair<vector<int>, vector<int>>> pairs(pairCount);
+        for (auto &p: pairs) {
+            int length = 64 + rand() % 960;
+            p.first.resize(length);
+            for (auto &val: p.first) {
+                val = rand() % 1000;
+            }
+            p.second = p.first;
+            for (auto &val: p.second) {
+                if (rand() % 5 == 0) {
+                    val = rand() % 1000;
+                }
+            }
+        }
+        auto batch = Mega::PackBatch(pairs);
+
+        auto report = [&](const string &name, const vector<int> &lengths, microseconds duration) {
+            long long total = 0;
+            for (int length: lengths) {
+                total += length;
+            }
+            double seconds = max((double) duration.count(), 1.0) / 1e6;
+            cout << "  [" << name << "] Execution time: " << duration.count() / 1000 << " ms, "
+                 << (long long) (lengths.size() / seconds) << " pairs/s, total LCS " << total << endl;
+        };
+
+        if (platformId == nullptr || deviceId == nullptr) {
+            cout << "  No GPU device found, CPU only" << endl;
+        } else {
+            if (pairCount <= 10000) {
+                auto start = high_resolution_clock::now();
+                vector<int> lengths(pairCount);
+                for (int p = 0; p < pairCount; p++) {
+                    auto result = Mega::MegaLCS_Fusion(platformId, deviceId, pairs[p].first, pairs[p].second, STEP);
+                    lengths[p] = get<2>(result).back();
+                }
+                report("PerPair", lengths, duration_cast<microseconds>(high_resolution_clock::now() - start));
+            }
+
+            auto start = high_resolution_clock::now();
+            auto result = Mega::MegaLCS_Batch(platformId, deviceId, batch, STEP);
+            report("Batch", result.lengths, duration_cast<microseconds>(high_resolution_clock::now() - start));
+        }
+
+        auto start = high_resolution_clock::now();
+        auto result = Mega::MegaLCS_Batch(nullptr, nullptr, batch, STEP);
+        report("Cpu", result.lengths, duration_cast<microseconds>(high_resolution_clock::now() - start));
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+// MegaLCSPerfOneToMany.cpp
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "Mega.h"
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+MegaLCS One-To-Many Performance Test
+====================================
+
+一个base和500个候选修订比较，候选是base随机修改5%的版本
+每个base长度比较两种方式的吞吐（candidates/s）：
+  [PerCall]    逐个调用MegaLCS_Fusion，每次重新上传base
+  [OneToMany]  MegaLCS_OneToMany，base只上传一次，候选分块并排计算
+GPU上的数据需要在有GPU的机器上运行本程序得到，这里没有记录
+*/
+int main() {
+    vector<int> baseSizes = {4096, 16384, 65536};
+    int candidateCount = 500;
+    int STEP = 256;
+
+    cout << "MegaLCS One-To-Many Performance Test" << endl;
+    cout << "====================================" << endl;
+
+    auto devicePair = Mega::GetFirstGpuDevice();
+    cl_platform_id platformId = devicePair.first;
+    cl_device_id deviceId = devicePair.second;
+
+    if (platformId == nullptr || deviceId == nullptr) {
+        cout << "No GPU device found, skipping..." << endl;
+        return 0;
+    }
+
+    for (int MAX: baseSizes) {
+        cout << "\nTesting base size: " << MAX << ", candidates: " << candidateCount << endl;
+
+        // 准备测试数据
+        mt19937 rand(MAX);
+        vector<int> baseVals(MAX);
+        for (auto &val: baseVals) {
+            val = rand() % 1000;
+        }
+        vector<vector<int>> candidates(candidateCount, baseVals);
+        for (auto &candidate: candidates) {
+            for (auto &val: candidate) {
+                if (rand() % 20 == 0) {
+                    val = rand() % 1000;
+                }
+            }
+        }
+
+        auto report = [&](const string &name, const vector<int> &lengths, microseconds duration) {
+            long long total = 0;
+            for (int length: lengths) {
+                total += length;
+            }
+            double seconds = max((double) duration.count(), 1.0) / 1e6;
+            cout << "  [" << name << "] Execution time: " << duration.count() / 1000 << " ms, "
+                 << (long long) (lengths.size() / seconds) << " candidates/s, total LCS " << total << endl;
+        };
+
+        auto start = high_resolution_clock::now();
+        vector<int> lengths(candidateCount);
+        for (int c = 0; c < candidateCount; c++) {
+            auto result = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, candidates[c], STEP);
+            lengths[c] = get<2>(result).back();
+        }
+        report("PerCall", lengths, duration_cast<microseconds>(high_resolution_clock::now() - start));
+
+        start = high_resolution_clock::now();
+        auto result = Mega::MegaLCS_OneToMany(platformId, deviceId, baseVals, candidates, STEP);
+        report("OneToMany", result.lengths, duration_cast<microseconds>(high_resolution_clock::now() - start));
+    }
+
+    return 0;
+}
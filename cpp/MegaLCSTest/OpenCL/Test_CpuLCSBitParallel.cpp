@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_CpuLCSBitParallel : public ::testing::Test {
+protected:
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 带边界的经典DP，左上角取min(vers[0], hors[0])，作为位并行的参考结果
+    static void FramedDP(const vector<int> &baseVals, const vector<int> &latestVals,
+                         vector<int> &verWeights, vector<int> &horWeights) {
+        size_t m = baseVals.size();
+        size_t n = latestVals.size();
+        vector<vector<int>> dp(m + 1, vector<int>(n + 1));
+
+        dp[0][0] = min(verWeights[0], horWeights[0]);
+        for (size_t j = 0; j < n; j++) dp[0][j + 1] = horWeights[j];
+        for (size_t i = 0; i < m; i++) dp[i + 1][0] = verWeights[i];
+
+        for (size_t i = 1; i <= m; i++) {
+            for (size_t j = 1; j <= n; j++) {
+                dp[i][j] = baseVals[i - 1] == latestVals[j - 1]
+                           ? dp[i - 1][j - 1] + 1
+                           : max(dp[i - 1][j], dp[i][j - 1]);
+            }
+        }
+
+        for (size_t j = 0; j < n; j++) horWeights[j] = dp[m][j + 1];
+        for (size_t i = 0; i < m; i++) verWeights[i] = dp[i + 1][n];
+    }
+
+    // 相邻差值∈{0,1}的随机边界
+    static vector<int> RandomFrame(mt19937 &rand, int length, int first) {
+        vector<int> weights(length);
+        weights[0] = first;
+        for (int i = 1; i < length; i++) {
+            weights[i] = weights[i - 1] + (int) (rand() % 2);
+        }
+        return weights;
+    }
+};
+
+TEST_F(Test_CpuLCSBitParallel, test_ex) {
+    EXPECT_THROW({
+                     vector<int> empty;
+                     Mega::CpuLCS_BitParallel(empty.data(), 0, empty.data(), 0,
+                                              empty.data(), 0, empty.data(), 0);
+                 }, runtime_error);
+
+    EXPECT_THROW(({
+        int base[] = {5, 6};
+        int latest[] = {5};
+        int ver[] = {5};
+        int hor[] = {5, 6};
+        Mega::CpuLCS_BitParallel(base, 2, latest, 1, ver, 1, hor, 2);
+    }), runtime_error);
+}
+
+TEST_F(Test_CpuLCSBitParallel, test_SameAsDPMatrix) {
+    mt19937 rand(1);
+    for (int j = 0; j < 200; j++) {
+        // 小字母表时CpuLCS_MinMax和DP不一致，位并行必须和DP一致
+        int maxVal = 1 + j % 6;
+        auto baseVals = RandomVals(rand, 1 + rand() % 150, maxVal);
+        auto latestVals = RandomVals(rand, 1 + rand() % 150, maxVal);
+
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_BitParallel(baseVals.data(), baseVals.size(),
+                                 latestVals.data(), latestVals.size(),
+                                 verWeights.data(), verWeights.size(),
+                                 horWeights.data(), horWeights.size());
+
+        auto expectResult = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+        ASSERT_EQ(verWeights, expectResult.first) << "case " << j;
+        ASSERT_EQ(horWeights, expectResult.second) << "case " << j;
+    }
+}
+
+TEST_F(Test_CpuLCSBitParallel, test_WithFrame) {
+    mt19937 rand(2);
+    for (int j = 0; j < 200; j++) {
+        auto baseVals = RandomVals(rand, 1 + rand() % 100, 4);
+        auto latestVals = RandomVals(rand, 1 + rand() % 100, 4);
+
+        int corner = rand() % 10;
+        auto verWeights = RandomFrame(rand, baseVals.size(), corner + (int) (rand() % 2));
+        auto horWeights = RandomFrame(rand, latestVals.size(), corner + (int) (rand() % 2));
+        auto expectVers = verWeights;
+        auto expectHors = horWeights;
+
+        Mega::CpuLCS_BitParallel(baseVals.data(), baseVals.size(),
+                                 latestVals.data(), latestVals.size(),
+                                 verWeights.data(), verWeights.size(),
+                                 horWeights.data(), horWeights.size());
+        FramedDP(baseVals, latestVals, expectVers, expectHors);
+
+        ASSERT_EQ(verWeights, expectVers) << "case " << j;
+        ASSERT_EQ(horWeights, expectHors) << "case " << j;
+    }
+}
+
+TEST_F(Test_CpuLCSBitParallel, test_MultipleColumnBlocks) {
+    // latest超过一个列块（4096列），块之间依靠每一行的进位衔接
+    mt19937 rand(3);
+    auto baseVals = RandomVals(rand, 300, 5);
+    auto latestVals = RandomVals(rand, 9000, 5);
+
+    auto verWeights = RandomFrame(rand, baseVals.size(), 3);
+    auto horWeights = RandomFrame(rand, latestVals.size(), 3);
+    auto expectVers = verWeights;
+    auto expectHors = horWeights;
+
+    Mega::CpuLCS_BitParallel(baseVals.data(), baseVals.size(),
+                             latestVals.data(), latestVals.size(),
+                             verWeights.data(), verWeights.size(),
+                             horWeights.data(), horWeights.size());
+    FramedDP(baseVals, latestVals, expectVers, expectHors);
+
+    EXPECT_EQ(verWeights, expectVers);
+    EXPECT_EQ(horWeights, expectHors);
+}
+
+TEST_F(Test_CpuLCSBitParallel, test_InvalidFrameFallsBackToMinMax) {
+    // 相邻差值为2，不是合法DP边界
+    int base[] = {1, 2, 3};
+    int latest[] = {2, 3, 1};
+    int ver[] = {0, 2, 2};
+    int hor[] = {0, 0, 1};
+
+    int expectVer[] = {0, 2, 2};
+    int expectHor[] = {0, 0, 1};
+    Mega::CpuLCS_MinMax(base, 3, latest, 3, expectVer, 3, expectHor, 3);
+    Mega::CpuLCS_BitParallel(base, 3, latest, 3, ver, 3, hor, 3);
+
+    EXPECT_EQ(vector<int>(ver, ver + 3), vector<int>(expectVer, expectVer + 3));
+    EXPECT_EQ(vector<int>(hor, hor + 3), vector<int>(expectHor, expectHor + 3));
+}
+
+TEST_F(Test_CpuLCSBitParallel, test_FusionCpuOnly) {
+    mt19937 rand(4);
+    auto baseVals = RandomVals(rand, 700, 4);
+    auto latestVals = RandomVals(rand, 500, 4);
+
+    auto result = Mega::MegaLCS_Fusion(nullptr, nullptr, baseVals, latestVals, 256, false,
+                                       MegaLCSCpuEngine::BitParallel);
+    auto expectResult = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+
+    EXPECT_TRUE(get<0>(result));
+    EXPECT_EQ(get<1>(result), expectResult.first);
+    EXPECT_EQ(get<2>(result), expectResult.second);
+}
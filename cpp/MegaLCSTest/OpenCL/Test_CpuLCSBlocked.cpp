@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_CpuLCSBlocked : public ::testing::Test {
+protected:
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+};
+
+TEST_F(Test_CpuLCSBlocked, Test_SameAsMinMax) {
+    // 小于一个tile、刚好整tile、带不满的最后一行/列
+    vector<pair<int, int>> shapes = {{1, 1}, {3, 700}, {700, 3}, {64, 64}, {128, 512}, {300, 1100}, {1025, 257}};
+    for (size_t j = 0; j < shapes.size(); j++) {
+        mt19937 rand(j);
+        auto baseVals = RandomVals(rand, shapes[j].first, 4);
+        auto latestVals = RandomVals(rand, shapes[j].second, 4);
+        auto initVers = RandomVals(rand, baseVals.size(), j % 2 == 0 ? 1 : 40);
+        auto initHors = RandomVals(rand, latestVals.size(), j % 2 == 0 ? 1 : 40);
+
+        vector<int> expectVers = initVers;
+        vector<int> expectHors = initHors;
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+
+        for (int step: {64, 128, 256, 512}) {
+            vector<int> verWeights = initVers;
+            vector<int> horWeights = initHors;
+            Mega::CpuLCS_MinMaxBlocked(baseVals.data(), baseVals.size(),
+                                       latestVals.data(), latestVals.size(),
+                                       verWeights.data(), verWeights.size(),
+                                       horWeights.data(), horWeights.size(),
+                                       step);
+
+            EXPECT_EQ(verWeights, expectVers) << "case " << j << " step " << step;
+            EXPECT_EQ(horWeights, expectHors) << "case " << j << " step " << step;
+        }
+    }
+}
+
+TEST_F(Test_CpuLCSBlocked, Test_InvalidStep) {
+    vector<int> vals = {1, 2, 3};
+    vector<int> verWeights(3, 0);
+    vector<int> horWeights(3, 0);
+    EXPECT_THROW(Mega::CpuLCS_MinMaxBlocked(vals.data(), 3, vals.data(), 3,
+                                            verWeights.data(), 3, horWeights.data(), 3, 100),
+                 runtime_error);
+    EXPECT_THROW(Mega::CpuLCS_MinMaxBlocked(vals.data(), 3, vals.data(), 3,
+                                            verWeights.data(), 2, horWeights.data(), 3),
+                 runtime_error);
+}
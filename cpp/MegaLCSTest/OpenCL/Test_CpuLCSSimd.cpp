@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_CpuLCSSimd : public ::testing::Test {
+protected:
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 当前CPU上可用的全部指令集，每种都必须和CpuLCS_MinMax逐元素一致
+    static vector<MegaLCSCpuIsa> SupportedIsas() {
+        vector<MegaLCSCpuIsa> isas;
+        for (auto isa: {MegaLCSCpuIsa::Scalar, MegaLCSCpuIsa::AVX2, MegaLCSCpuIsa::AVX512, MegaLCSCpuIsa::NEON}) {
+            if (Mega::IsCpuIsaSupported(isa)) {
+                isas.push_back(isa);
+            }
+        }
+        return isas;
+    }
+
+    static void CheckSameAsMinMax(const vector<int> &baseVals, const vector<int> &latestVals,
+                                  const vector<int> &initVers, const vector<int> &initHors) {
+        vector<int> expectBases = baseVals;
+        vector<int> expectLatests = latestVals;
+        vector<int> expectVers = initVers;
+        vector<int> expectHors = initHors;
+        Mega::CpuLCS_MinMax(expectBases.data(), expectBases.size(),
+                            expectLatests.data(), expectLatests.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+
+        for (auto isa: SupportedIsas()) {
+            vector<int> bases = baseVals;
+            vector<int> latests = latestVals;
+            vector<int> verWeights = initVers;
+            vector<int> horWeights = initHors;
+            Mega::CpuLCS_MinMaxSimd(bases.data(), bases.size(),
+                                    latests.data(), latests.size(),
+                                    verWeights.data(), verWeights.size(),
+                                    horWeights.data(), horWeights.size(),
+                                    isa);
+
+            EXPECT_EQ(verWeights, expectVers) << "isa " << (int) isa;
+            EXPECT_EQ(horWeights, expectHors) << "isa " << (int) isa;
+            EXPECT_EQ(bases, baseVals);
+            EXPECT_EQ(latests, latestVals);
+        }
+    }
+};
+
+TEST_F(Test_CpuLCSSimd, Test_ZeroFrame) {
+    // 覆盖比向量宽度短、刚好整除、带尾部等各种对角线长度
+    vector<pair<int, int>> shapes = {{1, 1}, {1, 40}, {40, 1}, {7, 9}, {16, 16}, {17, 33}, {100, 37}, {255, 256}};
+    for (size_t j = 0; j < shapes.size(); j++) {
+        mt19937 rand(j);
+        auto baseVals = RandomVals(rand, shapes[j].first, 4);
+        auto latestVals = RandomVals(rand, shapes[j].second, 4);
+
+        CheckSameAsMinMax(baseVals, latestVals,
+                          vector<int>(baseVals.size(), 0),
+                          vector<int>(latestVals.size(), 0));
+    }
+}
+
+TEST_F(Test_CpuLCSSimd, Test_NonZeroFrame) {
+    // Fusion的象限传入的是上一块的结果，边界不一定合法，MinMax也照常计算
+    for (int j = 0; j < 20; j++) {
+        mt19937 rand(100 + j);
+        auto baseVals = RandomVals(rand, 1 + rand() % 80, 3 + j % 5);
+        auto latestVals = RandomVals(rand, 1 + rand() % 80, 3 + j % 5);
+        auto initVers = RandomVals(rand, baseVals.size(), 50);
+        auto initHors = RandomVals(rand, latestVals.size(), 50);
+
+        CheckSameAsMinMax(baseVals, latestVals, initVers, initHors);
+    }
+}
+
+TEST_F(Test_CpuLCSSimd, Test_AutoIsaAndValidation) {
+    EXPECT_TRUE(Mega::IsCpuIsaSupported(Mega::GetBestCpuIsa()));
+
+    vector<int> baseVals = {1, 2, 3};
+    vector<int> latestVals = {3, 2, 1, 2};
+    vector<int> verWeights(3, 0);
+    vector<int> horWeights(4, 0);
+    Mega::CpuLCS_MinMaxSimd(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+    EXPECT_EQ(horWeights.back(), 2);
+
+    EXPECT_THROW(Mega::CpuLCS_MinMaxSimd(baseVals.data(), baseVals.size(),
+                                         latestVals.data(), latestVals.size(),
+                                         verWeights.data(), 2,
+                                         horWeights.data(), horWeights.size()),
+                 runtime_error);
+}
+
+TEST_F(Test_CpuLCSSimd, Test_FusionQuadrants) {
+    // 长度不是step的倍数，四个象限都会走CPU部分
+    auto devicePair = Mega::GetFirstGpuDevice();
+    mt19937 rand(8);
+    auto baseVals = RandomVals(rand, 8 * 5 + 3, 4);
+    auto latestVals = RandomVals(rand, 8 * 3 + 7, 4);
+
+    auto expectResult = Mega::MegaLCS_Fusion(devicePair.first, devicePair.second, baseVals, latestVals, 8, false,
+                                             MegaLCSCpuEngine::MinMax);
+    auto result = Mega::MegaLCS_Fusion(devicePair.first, devicePair.second, baseVals, latestVals, 8, false,
+                                       MegaLCSCpuEngine::MinMaxSimd);
+
+    EXPECT_EQ(get<0>(result), get<0>(expectResult));
+    EXPECT_EQ(get<1>(result), get<1>(expectResult));
+    EXPECT_EQ(get<2>(result), get<2>(expectResult));
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_CpuLCSWaveFront : public ::testing::Test {
+protected:
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    static pair<vector<int>, vector<int>> ExpectByMinMax(vector<int> baseVals, vector<int> latestVals,
+                                                         vector<int> verWeights, vector<int> horWeights) {
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        return make_pair(verWeights, horWeights);
+    }
+};
+
+TEST_F(Test_CpuLCSWaveFront, Test_SameAsMinMax) {
+    // 长度不是step的倍数、只有一行/一列tile、线程数多于可并行tile数
+    vector<tuple<int, int, int>> cases = {{1,   1,   4},
+                                          {37,  5,   4},
+                                          {5,   37,  4},
+                                          {64,  64,  8},
+                                          {100, 77,  8},
+                                          {300, 500, 16},
+                                          {513, 257, 256}};
+    for (size_t j = 0; j < cases.size(); j++) {
+        mt19937 rand(j);
+        auto baseVals = RandomVals(rand, get<0>(cases[j]), 4);
+        auto latestVals = RandomVals(rand, get<1>(cases[j]), 4);
+        int step = get<2>(cases[j]);
+        auto expectResult = ExpectByMinMax(baseVals, latestVals,
+                                           vector<int>(baseVals.size(), 0),
+                                           vector<int>(latestVals.size(), 0));
+
+        for (int threadCount: {1, 2, 3, 8}) {
+            vector<int> verWeights(baseVals.size(), 0);
+            vector<int> horWeights(latestVals.size(), 0);
+            Mega::CpuLCS_WaveFront(baseVals.data(), baseVals.size(),
+                                   latestVals.data(), latestVals.size(),
+                                   verWeights.data(), verWeights.size(),
+                                   horWeights.data(), horWeights.size(),
+                                   step, threadCount);
+
+            EXPECT_EQ(verWeights, expectResult.first) << "case " << j << " threads " << threadCount;
+            EXPECT_EQ(horWeights, expectResult.second) << "case " << j << " threads " << threadCount;
+        }
+    }
+}
+
+TEST_F(Test_CpuLCSWaveFront, Test_NonZeroFrame) {
+    mt19937 rand(42);
+    auto baseVals = RandomVals(rand, 123, 5);
+    auto latestVals = RandomVals(rand, 211, 5);
+    auto initVers = RandomVals(rand, baseVals.size(), 30);
+    auto initHors = RandomVals(rand, latestVals.size(), 30);
+    auto expectResult = ExpectByMinMax(baseVals, latestVals, initVers, initHors);
+
+    vector<int> verWeights = initVers;
+    vector<int> horWeights = initHors;
+    Mega::CpuLCS_WaveFront(baseVals.data(), baseVals.size(),
+                           latestVals.data(), latestVals.size(),
+                           verWeights.data(), verWeights.size(),
+                           horWeights.data(), horWeights.size(),
+                           16, 4);
+
+    EXPECT_EQ(verWeights, expectResult.first);
+    EXPECT_EQ(horWeights, expectResult.second);
+}
+
+TEST_F(Test_CpuLCSWaveFront, Test_FusionWithoutGpu) {
+    mt19937 rand(9);
+    auto baseVals = RandomVals(rand, 700, 4);
+    auto latestVals = RandomVals(rand, 900, 4);
+    auto expectResult = ExpectByMinMax(baseVals, latestVals,
+                                       vector<int>(baseVals.size(), 0),
+                                       vector<int>(latestVals.size(), 0));
+
+    auto result = Mega::MegaLCS_Fusion(nullptr, nullptr, baseVals, latestVals, 64);
+
+    EXPECT_TRUE(get<0>(result));
+    EXPECT_EQ(get<1>(result), expectResult.first);
+    EXPECT_EQ(get<2>(result), expectResult.second);
+}
+
+TEST_F(Test_CpuLCSWaveFront, Test_InvalidStep) {
+    vector<int> vals = {1, 2, 3};
+    vector<int> verWeights(3, 0);
+    vector<int> horWeights(3, 0);
+    EXPECT_THROW(Mega::CpuLCS_WaveFront(vals.data(), 3, vals.data(), 3,
+                                        verWeights.data(), 3, horWeights.data(), 3, 0),
+                 runtime_error);
+}
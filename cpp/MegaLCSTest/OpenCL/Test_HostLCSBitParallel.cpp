@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_HostLCSBitParallel : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+TEST_F(Test_HostLCSBitParallel, Test_SameAsDPMatrix) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    // 小字母表，MinMax和DP在这里会不一致
+    vector<tuple<int, int, int>> shapes = {{32, 1, 1}, {32, 3, 2}, {64, 2, 3}, {32, 5, 1}, {64, 1, 4}};
+    for (size_t j = 0; j < shapes.size(); j++) {
+        mt19937 rand(j);
+        int step = get<0>(shapes[j]);
+        auto baseVals = RandomVals(rand, step * get<1>(shapes[j]), 3);
+        auto latestVals = RandomVals(rand, step * get<2>(shapes[j]), 3);
+
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+
+        auto expectResult = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+        EXPECT_EQ(verWeights, expectResult.first) << "case " << j;
+        EXPECT_EQ(horWeights, expectResult.second) << "case " << j;
+    }
+}
+
+TEST_F(Test_HostLCSBitParallel, Test_SameAsCpuBitParallelWithFrame) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    mt19937 rand(11);
+    const int step = 32;
+    auto baseVals = RandomVals(rand, step * 3, 4);
+    auto latestVals = RandomVals(rand, step * 2, 4);
+
+    // 相邻差值∈{0,1}的边界，vers[0]和hors[0]相差1
+    vector<int> verWeights(baseVals.size());
+    vector<int> horWeights(latestVals.size());
+    verWeights[0] = 6;
+    horWeights[0] = 5;
+    for (size_t i = 1; i < verWeights.size(); i++) verWeights[i] = verWeights[i - 1] + (int) (rand() % 2);
+    for (size_t i = 1; i < horWeights.size(); i++) horWeights[i] = horWeights[i - 1] + (int) (rand() % 2);
+
+    auto expectVers = verWeights;
+    auto expectHors = horWeights;
+    Mega::CpuLCS_BitParallel(baseVals.data(), baseVals.size(),
+                             latestVals.data(), latestVals.size(),
+                             expectVers.data(), expectVers.size(),
+                             expectHors.data(), expectHors.size());
+
+    engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+
+    EXPECT_EQ(verWeights, expectVers);
+    EXPECT_EQ(horWeights, expectHors);
+}
+
+TEST_F(Test_HostLCSBitParallel, Test_FallbackToShared) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    mt19937 rand(12);
+
+    // step不是32的倍数
+    {
+        auto baseVals = RandomVals(rand, 8 * 3, 3);
+        auto latestVals = RandomVals(rand, 8 * 4, 3);
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, 8);
+
+        vector<int> expectVers(baseVals.size(), 0);
+        vector<int> expectHors(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+        EXPECT_EQ(verWeights, expectVers);
+        EXPECT_EQ(horWeights, expectHors);
+    }
+
+    // 边界不是合法的DP边界
+    {
+        auto baseVals = RandomVals(rand, 32, 3);
+        auto latestVals = RandomVals(rand, 32, 3);
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 3);
+        auto expectVers = verWeights;
+        auto expectHors = horWeights;
+
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, 32);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+        EXPECT_EQ(verWeights, expectVers);
+        EXPECT_EQ(horWeights, expectHors);
+    }
+}
+
+TEST_F(Test_HostLCSBitParallel, Test_FusionWithRemainders) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    // Fusion通过默认引擎调用HostLCS，GPU和CPU都用位并行时整体是精确DP
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    engine->SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    mt19937 rand(13);
+    for (int j = 0; j < 3; j++) {
+        auto baseVals = RandomVals(rand, 32 * 3 + 7 + j, 3);
+        auto latestVals = RandomVals(rand, 32 * 2 + 19 - j, 3);
+
+        auto result = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, 32, false,
+                                           MegaLCSCpuEngine::BitParallel);
+        auto expectResult = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+
+        EXPECT_EQ(get<1>(result), expectResult.first) << "case " << j;
+        EXPECT_EQ(get<2>(result), expectResult.second) << "case " << j;
+    }
+
+    engine->SetKernelVariant(MegaLCSKernelVariant::Shared);
+}
+
+// 匹配掩码按符号散列：大字母表、非2的幂的step、边缘不满的tile、只有高位不同的64位值
+TEST_F(Test_HostLCSBitParallel, Test_SymbolMasks) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    vector<tuple<int, int, int, int>> shapes = {{96, 96 * 2 + 5, 96 * 3, 4}, {256, 256 * 2, 256 + 77, 40},
+                                                {256, 300, 512, 1000}};
+    for (size_t j = 0; j < shapes.size(); j++) {
+        mt19937 rand(j + 20);
+        int step = get<0>(shapes[j]);
+        auto baseVals = RandomVals(rand, get<1>(shapes[j]), get<3>(shapes[j]));
+        auto latestVals = RandomVals(rand, get<2>(shapes[j]), get<3>(shapes[j]));
+        auto expectResult = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+        EXPECT_EQ(verWeights, expectResult.first) << "case " << j;
+        EXPECT_EQ(horWeights, expectResult.second) << "case " << j;
+
+        vector<int64_t> baseWide(baseVals.begin(), baseVals.end());
+        vector<int64_t> latestWide(latestVals.begin(), latestVals.end());
+        for (auto &val: baseWide) val <<= 40;
+        for (auto &val: latestWide) val <<= 40;
+        fill(verWeights.begin(), verWeights.end(), 0);
+        fill(horWeights.begin(), horWeights.end(), 0);
+        engine.HostLCS_WaveFront(baseWide, latestWide, verWeights, horWeights, true, step);
+        EXPECT_EQ(verWeights, expectResult.first) << "wide case " << j;
+        EXPECT_EQ(horWeights, expectResult.second) << "wide case " << j;
+    }
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <iostream>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+// 线程粗化版本和CpuLCS_MinMax逐元素比较，baseTrim/latestTrim是最后一个slice缺少的元素数
+static void Test_HostLCS_Coarsened(
+        int baseSliceCount,
+        int latestSliceCount,
+        int threadPerBlock,
+        int step,
+        int maxVal,
+        unsigned seed,
+        int baseTrim = 0,
+        int latestTrim = 0) {
+
+    mt19937 rand(seed);
+    vector<int> baseVals(baseSliceCount * step - baseTrim);
+    vector<int> latestVals(latestSliceCount * step - latestTrim);
+    for (auto &val: baseVals) val = rand() % maxVal;
+    for (auto &val: latestVals) val = rand() % maxVal;
+
+    vector<int> versOutExpect(baseVals.size(), 0);
+    vector<int> horsOutExpect(latestVals.size(), 0);
+    Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                        latestVals.data(), latestVals.size(),
+                        versOutExpect.data(), versOutExpect.size(),
+                        horsOutExpect.data(), horsOutExpect.size());
+
+    auto devices = Mega::GetAllDevices();
+    ASSERT_FALSE(devices.empty()) << "No OpenCL devices found.";
+
+    for (auto &device: devices) {
+        vector<int> versOut(baseVals.size(), 0);
+        vector<int> horsOut(latestVals.size(), 0);
+
+        Mega::HostLCS_WaveFront(
+                get<0>(device),
+                get<1>(device),
+                baseVals,
+                latestVals,
+                versOut,
+                horsOut,
+                threadPerBlock,
+                step);
+
+        ASSERT_EQ(versOut, versOutExpect) << get<2>(device) << " threads=" << threadPerBlock << " step=" << step
+                                          << " length=" << baseVals.size() << "x" << latestVals.size();
+        ASSERT_EQ(horsOut, horsOutExpect) << get<2>(device) << " threads=" << threadPerBlock << " step=" << step
+                                          << " length=" << baseVals.size() << "x" << latestVals.size();
+    }
+}
+
+// 矩形tile：base方向stepBase行，latest方向stepLatest列
+static void Test_HostLCS_Rect(
+        int baseSliceCount,
+        int latestSliceCount,
+        int threadPerBlock,
+        int stepBase,
+        int stepLatest,
+        int maxVal,
+        unsigned seed,
+        int baseTrim = 0,
+        int latestTrim = 0) {
+
+    mt19937 rand(seed);
+    vector<int> baseVals(baseSliceCount * stepBase - baseTrim);
+    vector<int> latestVals(latestSliceCount * stepLatest - latestTrim);
+    for (auto &val: baseVals) val = rand() % maxVal;
+    for (auto &val: latestVals) val = rand() % maxVal;
+
+    vector<int> versOutExpect(baseVals.size(), 0);
+    vector<int> horsOutExpect(latestVals.size(), 0);
+    Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                        latestVals.data(), latestVals.size(),
+                        versOutExpect.data(), versOutExpect.size(),
+                        horsOutExpect.data(), horsOutExpect.size());
+
+    auto devices = Mega::GetAllDevices();
+    ASSERT_FALSE(devices.empty()) << "No OpenCL devices found.";
+
+    for (auto &device: devices) {
+        vector<int> versOut(baseVals.size(), 0);
+        vector<int> horsOut(latestVals.size(), 0);
+
+        Mega::HostLCS_WaveFront(
+                get<0>(device),
+                get<1>(device),
+                baseVals,
+                latestVals,
+                versOut,
+                horsOut,
+                threadPerBlock,
+                stepBase,
+                stepLatest);
+
+        ASSERT_EQ(versOut, versOutExpect) << get<2>(device) << " tile=" << stepBase << "x" << stepLatest
+                                          << " length=" << baseVals.size() << "x" << latestVals.size();
+        ASSERT_EQ(horsOut, horsOutExpect) << get<2>(device) << " tile=" << stepBase << "x" << stepLatest
+                                          << " length=" << baseVals.size() << "x" << latestVals.size();
+    }
+}
+
+TEST(Test_HostLCSCoarsened, Test_OneColumnPerThread) {
+    // threadPerBlock == step 时退化为每个线程一列
+    Test_HostLCS_Coarsened(3, 2, 4, 4, 4, 1);
+    Test_HostLCS_Coarsened(1, 5, 8, 8, 4, 2);
+}
+
+TEST(Test_HostLCSCoarsened, Test_SeveralColumnsPerThread) {
+    Test_HostLCS_Coarsened(3, 4, 2, 8, 4, 3);
+    Test_HostLCS_Coarsened(5, 2, 4, 16, 16, 4);
+    Test_HostLCS_Coarsened(2, 3, 1, 8, 3, 5);
+    Test_HostLCS_Coarsened(4, 4, 8, 64, 100, 6);
+}
+
+TEST(Test_HostLCSCoarsened, Test_TileWiderThan256) {
+    // 64个线程覆盖512宽的tile
+    Test_HostLCS_Coarsened(2, 3, 64, 512, 32, 7);
+}
+
+TEST(Test_HostLCSCoarsened, Test_Invalid) {
+    auto devicePair = Mega::GetFirstGpuDevice();
+    vector<int> vals(64, 1);
+    vector<int> vers(64, 0);
+    vector<int> hors(64, 0);
+
+    // step不是threadPerBlock的倍数
+    EXPECT_THROW(Mega::HostLCS_WaveFront(devicePair.first, devicePair.second,
+                                         vals, vals, vers, hors, 3, 8), runtime_error);
+    // threadPerBlock大于step
+    EXPECT_THROW(Mega::HostLCS_WaveFront(devicePair.first, devicePair.second,
+                                         vals, vals, vers, hors, 16, 8), runtime_error);
+    // 每个线程的列数超过32
+    EXPECT_THROW(Mega::HostLCS_WaveFront(devicePair.first, devicePair.second,
+                                         vals, vals, vers, hors, 1, 64), runtime_error);
+}
+
+TEST(Test_HostLCSCoarsened, Test_RaggedLength) {
+    // 长度不是step的倍数，最后一行/列的tile不满，部分线程没有有效列
+    Test_HostLCS_Coarsened(3, 4, 2, 8, 4, 14, 3, 5);
+    Test_HostLCS_Coarsened(4, 3, 4, 16, 16, 15, 15, 1);
+    Test_HostLCS_Coarsened(2, 2, 8, 64, 100, 16, 60, 63);
+    // 只有一个不满的slice
+    Test_HostLCS_Coarsened(1, 1, 4, 32, 4, 17, 20, 7);
+}
+
+TEST(Test_HostLCSCoarsened, Test_RectangularTile) {
+    // 高tile：长的base方向slice少，对角带个数由较短的方向决定
+    Test_HostLCS_Rect(3, 5, 4, 32, 8, 4, 8);
+    Test_HostLCS_Rect(2, 7, 2, 64, 4, 16, 9);
+    // 宽tile：行数少于线程数
+    Test_HostLCS_Rect(6, 2, 8, 4, 32, 4, 10);
+    Test_HostLCS_Rect(5, 1, 16, 3, 64, 100, 11);
+    // 正方形时和step*step的结果相同
+    Test_HostLCS_Rect(3, 3, 4, 16, 16, 4, 12);
+}
+
+TEST(Test_HostLCSCoarsened, Test_RectangularTileWiderThan256) {
+    // 32个线程每个16列，覆盖512宽的tile，base方向128行
+    Test_HostLCS_Rect(4, 2, 32, 128, 512, 32, 13);
+}
+
+TEST(Test_HostLCSCoarsened, Test_RectangularRaggedLength) {
+    // 长的base方向用高tile，两个方向的长度都不是tile大小的倍数
+    Test_HostLCS_Rect(5, 3, 4, 64, 16, 4, 18, 37, 5);
+    Test_HostLCS_Rect(3, 6, 8, 4, 32, 16, 19, 3, 30);
+    // base比一个tile还短
+    Test_HostLCS_Rect(1, 4, 4, 128, 8, 4, 20, 100, 0);
+}
+
+TEST(Test_HostLCSCoarsened, Test_RectangularInvalid) {
+    auto devicePair = Mega::GetFirstGpuDevice();
+    vector<int> baseVals(96, 1);
+    vector<int> latestVals(64, 1);
+    vector<int> vers(96, 0);
+    vector<int> hors(64, 0);
+
+    // stepBase超出范围
+    EXPECT_THROW(Mega::HostLCS_WaveFront(devicePair.first, devicePair.second,
+                                         baseVals, latestVals, vers, hors, 4, 0, 8), runtime_error);
+    EXPECT_THROW(Mega::HostLCS_WaveFront(devicePair.first, devicePair.second,
+                                         baseVals, latestVals, vers, hors, 4, 4096, 8), runtime_error);
+    // latest方向仍按线程粗化的规则校验
+    EXPECT_THROW(Mega::HostLCS_WaveFront(devicePair.first, devicePair.second,
+                                         baseVals, latestVals, vers, hors, 3, 32, 8), runtime_error);
+}
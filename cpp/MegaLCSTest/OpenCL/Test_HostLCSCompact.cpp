@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_HostLCSCompact : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 相邻差值∈{0,1}的随机边界
+    static vector<int> RandomFrame(mt19937 &rand, int length, int first) {
+        vector<int> weights(length);
+        weights[0] = first;
+        for (int i = 1; i < length; i++) {
+            weights[i] = weights[i - 1] + (int) (rand() % 2);
+        }
+        return weights;
+    }
+
+    // 和CpuLCS_MinMax比较，verWeights/horWeights是输入边界
+    void ExpectSameAsMinMax(MegaLCSEngine &engine, int step,
+                            const vector<int> &baseVals, const vector<int> &latestVals,
+                            vector<int> verWeights, vector<int> horWeights) {
+        auto expectVers = verWeights;
+        auto expectHors = horWeights;
+        auto bases = baseVals;
+        auto latests = latestVals;
+        Mega::CpuLCS_MinMax(bases.data(), bases.size(),
+                            latests.data(), latests.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+
+        engine.HostLCS_WaveFront(bases, latests, verWeights, horWeights, true, step);
+        EXPECT_EQ(verWeights, expectVers) << "step " << step;
+        EXPECT_EQ(horWeights, expectHors) << "step " << step;
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+TEST_F(Test_HostLCSCompact, Test_SameAsMinMax) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::Compact);
+
+    vector<tuple<int, int, int>> shapes = {{1, 4, 3}, {16, 3, 2}, {64, 2, 3}};
+    for (size_t j = 0; j < shapes.size(); j++) {
+        mt19937 rand(j);
+        int step = get<0>(shapes[j]);
+        auto baseVals = RandomVals(rand, step * get<1>(shapes[j]), 4);
+        auto latestVals = RandomVals(rand, step * get<2>(shapes[j]), 4);
+
+        // 全0的边界和带有较大基准值的边界
+        ExpectSameAsMinMax(engine, step, baseVals, latestVals,
+                           vector<int>(baseVals.size(), 0), vector<int>(latestVals.size(), 0));
+
+        int corner = 100000 + rand() % 5;
+        ExpectSameAsMinMax(engine, step, baseVals, latestVals,
+                           RandomFrame(rand, baseVals.size(), corner),
+                           RandomFrame(rand, latestVals.size(), corner + (int) (rand() % 2)));
+    }
+}
+
+TEST_F(Test_HostLCSCompact, Test_LargeStep) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    // 默认的Shared引擎在step超过256时自动使用Compact
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+
+    mt19937 rand(5);
+    const int step = 512;
+    auto baseVals = RandomVals(rand, step, 6);
+    auto latestVals = RandomVals(rand, step * 2, 6);
+    ExpectSameAsMinMax(engine, step, baseVals, latestVals,
+                       vector<int>(baseVals.size(), 0), vector<int>(latestVals.size(), 0));
+
+    EXPECT_THROW(({
+        vector<int> vals(2048, 0);
+        vector<int> weights(2048, 0);
+        engine.HostLCS_WaveFront(vals, vals, weights, weights, true, 2048);
+    }), runtime_error);
+}
+
+TEST_F(Test_HostLCSCompact, Test_InvalidFrameFallsBack) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::Compact);
+
+    // 差值为3的边界超出了16位权重的前提，使用Shared内核
+    const int step = 8;
+    mt19937 rand(9);
+    auto baseVals = RandomVals(rand, step * 2, 3);
+    auto latestVals = RandomVals(rand, step * 2, 3);
+    vector<int> verWeights(baseVals.size());
+    for (size_t i = 0; i < verWeights.size(); i++) {
+        verWeights[i] = (int) i * 3;
+    }
+    ExpectSameAsMinMax(engine, step, baseVals, latestVals, verWeights, vector<int>(latestVals.size(), 0));
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_HostLCSElements : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    template<typename T>
+    static vector<T> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<T> vals(length);
+        for (auto &val: vals) {
+            val = (T) (rand() % maxVal);
+        }
+        return vals;
+    }
+
+    // int版本的CpuLCS_MinMax，GPU内核和它逐元素一致
+    static pair<vector<int>, vector<int>> ExpectMinMax(vector<int> baseVals, vector<int> latestVals) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        return make_pair(verWeights, horWeights);
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+TEST_F(Test_HostLCSElements, test_RemapDense) {
+    vector<int64_t> baseVals = {1LL << 40, -7, 5, 1LL << 40};
+    vector<int64_t> latestVals = {5, 9, -7};
+
+    vector<int> baseRanks;
+    vector<int> latestRanks;
+    int alphabetSize = Mega::RemapDense(baseVals, latestVals, baseRanks, latestRanks);
+
+    EXPECT_EQ(alphabetSize, 4);
+    EXPECT_EQ(baseRanks, (vector<int>{3, 0, 1, 3}));
+    EXPECT_EQ(latestRanks, (vector<int>{1, 2, 0}));
+
+    EXPECT_EQ(Mega::GetNarrowestElementType(1), MegaLCSElementType::UInt8);
+    EXPECT_EQ(Mega::GetNarrowestElementType(256), MegaLCSElementType::UInt8);
+    EXPECT_EQ(Mega::GetNarrowestElementType(257), MegaLCSElementType::UInt16);
+    EXPECT_EQ(Mega::GetNarrowestElementType(65536), MegaLCSElementType::UInt16);
+    EXPECT_EQ(Mega::GetNarrowestElementType(65537), MegaLCSElementType::Int32);
+}
+
+TEST_F(Test_HostLCSElements, test_CpuSameAsInt) {
+    mt19937 rand(1);
+    for (int j = 0; j < 50; j++) {
+        auto baseVals = RandomVals<int>(rand, 1 + rand() % 80, 1 + j % 5);
+        auto latestVals = RandomVals<int>(rand, 1 + rand() % 80, 1 + j % 5);
+        auto expectResult = ExpectMinMax(baseVals, latestVals);
+
+        vector<uint8_t> baseBytes(baseVals.begin(), baseVals.end());
+        vector<uint8_t> latestBytes(latestVals.begin(), latestVals.end());
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseBytes.data(), baseBytes.size(),
+                            latestBytes.data(), latestBytes.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        ASSERT_EQ(verWeights, expectResult.first) << "case " << j;
+        ASSERT_EQ(horWeights, expectResult.second) << "case " << j;
+
+        // 位并行按值建表，64位的值结果和DP一致
+        vector<int64_t> baseWide(baseVals.begin(), baseVals.end());
+        vector<int64_t> latestWide(latestVals.begin(), latestVals.end());
+        for (auto &val: baseWide) val = (val << 40) + 3;
+        for (auto &val: latestWide) val = (val << 40) + 3;
+        fill(verWeights.begin(), verWeights.end(), 0);
+        fill(horWeights.begin(), horWeights.end(), 0);
+        Mega::CpuLCS_BitParallel(baseWide.data(), baseWide.size(),
+                                 latestWide.data(), latestWide.size(),
+                                 verWeights.data(), verWeights.size(),
+                                 horWeights.data(), horWeights.size());
+        auto expectDP = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+        ASSERT_EQ(verWeights, expectDP.first) << "case " << j;
+        ASSERT_EQ(horWeights, expectDP.second) << "case " << j;
+    }
+}
+
+TEST_F(Test_HostLCSElements, Test_NarrowElements) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+
+    const int step = 16;
+    mt19937 rand(2);
+    auto baseVals = RandomVals<int>(rand, step * 3, 4);
+    auto latestVals = RandomVals<int>(rand, step * 2, 4);
+    auto expectResult = ExpectMinMax(baseVals, latestVals);
+
+    vector<uint8_t> baseBytes(baseVals.begin(), baseVals.end());
+    vector<uint8_t> latestBytes(latestVals.begin(), latestVals.end());
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+    engine.HostLCS_WaveFront(baseBytes, latestBytes, verWeights, horWeights, true, step);
+    EXPECT_EQ(verWeights, expectResult.first);
+    EXPECT_EQ(horWeights, expectResult.second);
+
+    vector<uint16_t> baseShorts(baseVals.begin(), baseVals.end());
+    vector<uint16_t> latestShorts(latestVals.begin(), latestVals.end());
+    fill(verWeights.begin(), verWeights.end(), 0);
+    fill(horWeights.begin(), horWeights.end(), 0);
+    engine.HostLCS_WaveFront(baseShorts, latestShorts, verWeights, horWeights, true, step);
+    EXPECT_EQ(verWeights, expectResult.first);
+    EXPECT_EQ(horWeights, expectResult.second);
+
+    // 只有高位不同的64位值，截断成int会全部相等
+    vector<int64_t> baseWide(baseVals.begin(), baseVals.end());
+    vector<int64_t> latestWide(latestVals.begin(), latestVals.end());
+    for (auto &val: baseWide) val <<= 40;
+    for (auto &val: latestWide) val <<= 40;
+    fill(verWeights.begin(), verWeights.end(), 0);
+    fill(horWeights.begin(), horWeights.end(), 0);
+    engine.HostLCS_WaveFront(baseWide, latestWide, verWeights, horWeights, true, step);
+    EXPECT_EQ(verWeights, expectResult.first);
+    EXPECT_EQ(horWeights, expectResult.second);
+}
+
+TEST_F(Test_HostLCSElements, Test_ElementNarrowing) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetElementNarrowing(true);
+    EXPECT_TRUE(engine.GetElementNarrowing());
+
+    // 值很大但只有几种，映射后用uint8_t上传
+    const int step = 32;
+    mt19937 rand(3);
+    auto baseVals = RandomVals<int>(rand, step * 2, 5);
+    auto latestVals = RandomVals<int>(rand, step * 3, 5);
+    auto expectResult = ExpectMinMax(baseVals, latestVals);
+    for (auto &val: baseVals) val = val * 100000007;
+    for (auto &val: latestVals) val = val * 100000007;
+
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+    engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+    EXPECT_EQ(verWeights, expectResult.first);
+    EXPECT_EQ(horWeights, expectResult.second);
+
+    // 线程粗化的内核同样适用
+    fill(verWeights.begin(), verWeights.end(), 0);
+    fill(horWeights.begin(), horWeights.end(), 0);
+    engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, 8, step);
+    EXPECT_EQ(verWeights, expectResult.first);
+    EXPECT_EQ(horWeights, expectResult.second);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_HostLCSPacked : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 相邻差值∈{0,1}的随机边界
+    static vector<int> RandomFrame(mt19937 &rand, int length, int first) {
+        vector<int> weights(length);
+        weights[0] = first;
+        for (int i = 1; i < length; i++) {
+            weights[i] = weights[i - 1] + (int) (rand() % 2);
+        }
+        return weights;
+    }
+
+    static void ExpectMinMax(vector<int> baseVals, vector<int> latestVals,
+                             vector<int> &verWeights, vector<int> &horWeights) {
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+TEST_F(Test_HostLCSPacked, test_PackUnpack) {
+    mt19937 rand(1);
+    for (int step: {1, 16, 31, 32, 33, 48, 256}) {
+        auto weights = RandomFrame(rand, step * 3, 7);
+
+        vector<uint32_t> records;
+        ASSERT_TRUE(Mega::PackWeights(weights, step, records)) << "step " << step;
+        EXPECT_EQ(records.size(), 3 * Mega::GetPackedWords(step));
+
+        vector<int> unpacked(weights.size());
+        Mega::UnpackWeights(records, step, unpacked);
+        EXPECT_EQ(unpacked, weights) << "step " << step;
+    }
+
+    // tile之间的差值不受限制
+    vector<uint32_t> records;
+    vector<int> weights = {0, 1, 1, 9, 9, 10};
+    EXPECT_TRUE(Mega::PackWeights(weights, 3, records));
+
+    // tile内差值为2或者为负时不能打包
+    EXPECT_FALSE(Mega::PackWeights(vector<int>{0, 2, 2}, 3, records));
+    EXPECT_FALSE(Mega::PackWeights(vector<int>{1, 0, 0}, 3, records));
+    EXPECT_FALSE(Mega::PackWeights(vector<int>{0, 1, 1, 1}, 3, records));
+}
+
+TEST_F(Test_HostLCSPacked, Test_SameAsMinMax) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetPackedWeights(true);
+    EXPECT_TRUE(engine.GetPackedWeights());
+
+    // 48跨越两个word，1和16小于一个word
+    vector<tuple<int, int, int>> shapes = {{1, 5, 3}, {16, 3, 2}, {32, 2, 3}, {48, 2, 2}, {64, 1, 2}};
+    for (size_t j = 0; j < shapes.size(); j++) {
+        mt19937 rand(j);
+        int step = get<0>(shapes[j]);
+        auto baseVals = RandomVals(rand, step * get<1>(shapes[j]), 4);
+        auto latestVals = RandomVals(rand, step * get<2>(shapes[j]), 4);
+
+        int corner = rand() % 5;
+        auto verWeights = RandomFrame(rand, baseVals.size(), corner);
+        auto horWeights = RandomFrame(rand, latestVals.size(), corner);
+        auto expectVers = verWeights;
+        auto expectHors = horWeights;
+
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+        ExpectMinMax(baseVals, latestVals, expectVers, expectHors);
+
+        EXPECT_EQ(verWeights, expectVers) << "case " << j;
+        EXPECT_EQ(horWeights, expectHors) << "case " << j;
+    }
+}
+
+TEST_F(Test_HostLCSPacked, Test_UnpackableFrame) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetPackedWeights(true);
+
+    // 差值为2的边界不能打包，自动使用原始格式
+    const int step = 8;
+    mt19937 rand(7);
+    auto baseVals = RandomVals(rand, step * 2, 3);
+    auto latestVals = RandomVals(rand, step * 2, 3);
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+    for (size_t i = 0; i < verWeights.size(); i++) {
+        verWeights[i] = (int) i * 2;
+    }
+    auto expectVers = verWeights;
+    auto expectHors = horWeights;
+
+    engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+    ExpectMinMax(baseVals, latestVals, expectVers, expectHors);
+
+    EXPECT_EQ(verWeights, expectVers);
+    EXPECT_EQ(horWeights, expectHors);
+}
+
+TEST_F(Test_HostLCSPacked, Test_InvalidFrame) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetPackedWeights(true);
+
+    // 两条边界各自都能打包，但是左上角不一致，tile输出的差值超出{0,1}，必须使用原始格式
+    const int step = 4;
+    vector<int> baseVals = {9, 9, 9, 7};
+    vector<int> latestVals = {9, 7, 0, 0};
+    vector<int> verWeights(baseVals.size(), 1000);
+    vector<int> horWeights(latestVals.size(), 0);
+    auto expectVers = verWeights;
+    auto expectHors = horWeights;
+
+    engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+    ExpectMinMax(baseVals, latestVals, expectVers, expectHors);
+
+    EXPECT_EQ(horWeights, (vector<int>{1000, 4, 4, 4}));
+    EXPECT_EQ(verWeights, expectVers);
+    EXPECT_EQ(horWeights, expectHors);
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_HostLCSRagged : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 相邻差值∈{0,1}的随机边界
+    static vector<int> RandomFrame(mt19937 &rand, int length, int first) {
+        vector<int> weights(length);
+        weights[0] = first;
+        for (int i = 1; i < length; i++) {
+            weights[i] = weights[i - 1] + (int) (rand() % 2);
+        }
+        return weights;
+    }
+
+    // 和CpuLCS_MinMax比较，verWeights/horWeights是输入边界
+    static void ExpectSameAsMinMax(MegaLCSEngine &engine, int step,
+                                   vector<int> baseVals, vector<int> latestVals,
+                                   vector<int> verWeights, vector<int> horWeights) {
+        auto expectVers = verWeights;
+        auto expectHors = horWeights;
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+        EXPECT_EQ(verWeights, expectVers) << "step " << step << " " << baseVals.size() << "x" << latestVals.size();
+        EXPECT_EQ(horWeights, expectHors) << "step " << step << " " << baseVals.size() << "x" << latestVals.size();
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+TEST_F(Test_HostLCSRagged, Test_SharedSameAsMinMax) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+
+    mt19937 rand(21);
+    for (int step: {1, 4, 8, 16}) {
+        // 只有base不满、只有latest不满、两边都不满，以及比step还短
+        vector<pair<int, int>> lengths = {
+                {step * 3 + 1, step * 2},
+                {step * 2, step * 4 - 1},
+                {step * 5 + step / 2 + 1, step * 3 + 1},
+                {step / 2 + 1, step * 2 + 3}
+        };
+
+        for (auto &length: lengths) {
+            auto baseVals = RandomVals(rand, length.first, 4);
+            auto latestVals = RandomVals(rand, length.second, 4);
+            ExpectSameAsMinMax(engine, step, baseVals, latestVals,
+                               vector<int>(baseVals.size(), 0), vector<int>(latestVals.size(), 0));
+            ExpectSameAsMinMax(engine, step, baseVals, latestVals,
+                               RandomFrame(rand, baseVals.size(), 7), RandomFrame(rand, latestVals.size(), 6));
+        }
+    }
+}
+
+TEST_F(Test_HostLCSRagged, Test_CompactAndPersistent) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+
+    mt19937 rand(22);
+
+    // Compact内核同样屏蔽边缘tile
+    engine.SetKernelVariant(MegaLCSKernelVariant::Compact);
+    {
+        auto baseVals = RandomVals(rand, 16 * 3 + 5, 4);
+        auto latestVals = RandomVals(rand, 16 * 2 + 11, 4);
+        ExpectSameAsMinMax(engine, 16, baseVals, latestVals,
+                           RandomFrame(rand, baseVals.size(), 100000), RandomFrame(rand, latestVals.size(), 100001));
+    }
+
+    // 常驻内核不处理边缘tile，回退到共享内存版本
+    engine.SetKernelVariant(MegaLCSKernelVariant::Persistent);
+    {
+        auto baseVals = RandomVals(rand, 8 * 5 + 3, 4);
+        auto latestVals = RandomVals(rand, 8 * 4 + 6, 4);
+        ExpectSameAsMinMax(engine, 8, baseVals, latestVals,
+                           vector<int>(baseVals.size(), 0), vector<int>(latestVals.size(), 0));
+    }
+}
+
+TEST_F(Test_HostLCSRagged, Test_LargeStepOnDefaultEngine) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    // step超过256时默认引擎使用Compact内核
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    mt19937 rand(23);
+    auto baseVals = RandomVals(rand, 512 + 77, 6);
+    auto latestVals = RandomVals(rand, 512 * 2 + 200, 6);
+    ExpectSameAsMinMax(*engine, 512, baseVals, latestVals,
+                       vector<int>(baseVals.size(), 0), vector<int>(latestVals.size(), 0));
+}
+
+TEST_F(Test_HostLCSRagged, Test_BitParallelIsExact) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    engine.SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    mt19937 rand(24);
+    vector<pair<int, int>> lengths = {{32 * 3 + 5, 32 * 2}, {32 * 2, 32 * 2 + 31}, {45, 33}, {17, 70}};
+    for (auto &length: lengths) {
+        auto baseVals = RandomVals(rand, length.first, 3);
+        auto latestVals = RandomVals(rand, length.second, 3);
+
+        // 0边界时是经典LCS
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, 32);
+        auto expectResult = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+        EXPECT_EQ(verWeights, expectResult.first) << length.first << "x" << length.second;
+        EXPECT_EQ(horWeights, expectResult.second) << length.first << "x" << length.second;
+
+        // 合法的非0边界和CPU的位并行版本相同
+        verWeights = RandomFrame(rand, baseVals.size(), 50);
+        horWeights = RandomFrame(rand, latestVals.size(), 50);
+        auto expectVers = verWeights;
+        auto expectHors = horWeights;
+        Mega::CpuLCS_BitParallel(baseVals.data(), baseVals.size(),
+                                 latestVals.data(), latestVals.size(),
+                                 expectVers.data(), expectVers.size(),
+                                 expectHors.data(), expectHors.size());
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, 32);
+        EXPECT_EQ(verWeights, expectVers) << length.first << "x" << length.second;
+        EXPECT_EQ(horWeights, expectHors) << length.first << "x" << length.second;
+    }
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_HostLCSTraceback : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 完整的DP矩阵按同样的规则回溯，作为参考结果
+    static vector<pair<int, int>> ExpectByFullMatrix(const vector<int> &baseVals, const vector<int> &latestVals) {
+        int m = baseVals.size();
+        int n = latestVals.size();
+        vector<vector<int>> weights(m, vector<int>(n));
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                int left = j > 0 ? weights[i][j - 1] : 0;
+                int top = i > 0 ? weights[i - 1][j] : 0;
+                int diag = i > 0 && j > 0 ? weights[i - 1][j - 1] : 0;
+                weights[i][j] = baseVals[i] == latestVals[j] ? diag + 1 : max(left, top);
+            }
+        }
+
+        vector<pair<int, int>> pairs;
+        int i = m - 1;
+        int j = n - 1;
+        while (i >= 0 && j >= 0) {
+            if (baseVals[i] == latestVals[j]) {
+                pairs.emplace_back(i, j);
+                i--;
+                j--;
+            } else if ((i > 0 ? weights[i - 1][j] : 0) >= (j > 0 ? weights[i][j - 1] : 0)) {
+                i--;
+            } else {
+                j--;
+            }
+        }
+        reverse(pairs.begin(), pairs.end());
+        return pairs;
+    }
+
+    // 匹配对是一个公共子序列，长度等于精确DP的LCS长度
+    static void ExpectLongest(const vector<int> &baseVals, const vector<int> &latestVals,
+                              const vector<pair<int, int>> &pairs) {
+        for (size_t p = 0; p < pairs.size(); p++) {
+            EXPECT_EQ(baseVals[pairs[p].first], latestVals[pairs[p].second]);
+            if (p > 0) {
+                EXPECT_LT(pairs[p - 1].first, pairs[p].first);
+                EXPECT_LT(pairs[p - 1].second, pairs[p].second);
+            }
+        }
+        EXPECT_EQ((int) pairs.size(), Mega::CpuLCS_DPMatrix(baseVals, latestVals).second.back());
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+TEST_F(Test_HostLCSTraceback, Test_SameAsFullMatrix) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    const int step = 8;
+    mt19937 rand(3);
+    auto baseVals = RandomVals(rand, step * 7, 4);
+    auto latestVals = RandomVals(rand, step * 11, 4);
+    auto expectPairs = ExpectByFullMatrix(baseVals, latestVals);
+
+    auto expectWeights = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+    auto &expectVers = expectWeights.first;
+    auto &expectHors = expectWeights.second;
+
+    // 预算从宽到紧，检查点间隔越来越大，结果必须一样；精确回溯的检查点还保存每个base slice的左上角
+    size_t frontier = (baseVals.size() + latestVals.size() + baseVals.size() / step) * sizeof(int);
+    for (size_t budget: {frontier * 100, frontier * 10, frontier * 8, frontier * 7}) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        auto pairs = Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                      baseVals, latestVals,
+                                                      verWeights, horWeights,
+                                                      step, budget);
+
+        EXPECT_EQ(verWeights, expectVers) << "budget " << budget;
+        EXPECT_EQ(horWeights, expectHors) << "budget " << budget;
+        EXPECT_EQ(pairs, expectPairs) << "budget " << budget;
+    }
+}
+
+TEST_F(Test_HostLCSTraceback, Test_RaggedEdges) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    // 长度不是step的倍数，最后一行/列的tile不满
+    const int step = 8;
+    mt19937 rand(4);
+    auto baseVals = RandomVals(rand, step * 5 + 3, 4);
+    auto latestVals = RandomVals(rand, step * 6 + 7, 4);
+    auto expectPairs = ExpectByFullMatrix(baseVals, latestVals);
+
+    size_t frontier = (baseVals.size() + latestVals.size()) * sizeof(int);
+    for (size_t budget: {frontier * 100, frontier * 8}) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        auto pairs = Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                      baseVals, latestVals,
+                                                      verWeights, horWeights,
+                                                      step, budget);
+
+        EXPECT_EQ(pairs, expectPairs) << "budget " << budget;
+    }
+}
+
+TEST_F(Test_HostLCSTraceback, Test_SingleSliceAndBudget) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    const int step = 4;
+    vector<int> baseVals = {1, 2, 3, 4};
+    vector<int> latestVals = {0, 2, 4, 9, 1, 2, 3, 4};
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+
+    auto pairs = Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                  baseVals, latestVals,
+                                                  verWeights, horWeights,
+                                                  step, 1 << 20);
+    vector<pair<int, int>> expectPairs = {{0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    EXPECT_EQ(pairs, expectPairs);
+
+    EXPECT_THROW(Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                  baseVals, latestVals,
+                                                  verWeights, horWeights,
+                                                  step, 16),
+                 runtime_error);
+}
+
+TEST_F(Test_HostLCSTraceback, Test_BitParallelKernel) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    // step是32的倍数，检查点来自设备上的位并行内核
+    const int step = 32;
+    mt19937 rand(5);
+    auto baseVals = RandomVals(rand, step * 4 + 9, 4);
+    auto latestVals = RandomVals(rand, step * 5 + 1, 4);
+    auto expectPairs = ExpectByFullMatrix(baseVals, latestVals);
+    auto expectWeights = Mega::CpuLCS_DPMatrix(baseVals, latestVals);
+
+    size_t frontier = (baseVals.size() + latestVals.size()) * sizeof(int);
+    for (size_t budget: {frontier * 100, frontier * 12}) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        auto pairs = Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                      baseVals, latestVals,
+                                                      verWeights, horWeights,
+                                                      step, budget);
+
+        EXPECT_EQ(verWeights, expectWeights.first) << "budget " << budget;
+        EXPECT_EQ(horWeights, expectWeights.second) << "budget " << budget;
+        EXPECT_EQ(pairs, expectPairs) << "budget " << budget;
+    }
+}
+
+TEST_F(Test_HostLCSTraceback, Test_PathIsLongest) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    // MinMax会多算1的例子：真实的LCS是2
+    vector<int> baseVals = {1, 1, 0, 0};
+    vector<int> latestVals = {0, 0, 1, 0, 1};
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+    auto pairs = Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                  baseVals, latestVals,
+                                                  verWeights, horWeights,
+                                                  2, 1 << 20);
+    EXPECT_EQ(horWeights.back(), 2);
+    ExpectLongest(baseVals, latestVals, pairs);
+
+    // 小字母表的随机输入，两种step（CPU和设备上的位并行）
+    mt19937 rand(6);
+    for (int round = 0; round < 40; round++) {
+        int step = round % 2 == 0 ? 4 : 32;
+        baseVals = RandomVals(rand, 1 + rand() % 100, 2 + round % 3);
+        latestVals = RandomVals(rand, 1 + rand() % 100, 2 + round % 3);
+        verWeights.assign(baseVals.size(), 0);
+        horWeights.assign(latestVals.size(), 0);
+        pairs = Mega::HostLCS_WaveFrontTraceback(platformId, deviceId,
+                                                 baseVals, latestVals,
+                                                 verWeights, horWeights,
+                                                 step, 1 << 20);
+        EXPECT_EQ((int) pairs.size(), horWeights.back()) << "round " << round;
+        ExpectLongest(baseVals, latestVals, pairs);
+    }
+}
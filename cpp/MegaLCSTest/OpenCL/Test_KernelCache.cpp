@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+class Test_KernelCache : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+
+        cacheDir = fs::temp_directory_path() / "MegaLCS-Test_KernelCache";
+        fs::remove_all(cacheDir);
+        Mega::SetKernelCacheDir(cacheDir.string());
+    }
+
+    void TearDown() override {
+        // 其他测试不使用磁盘缓存
+        Mega::SetKernelCacheDir("");
+        fs::remove_all(cacheDir);
+    }
+
+    vector<fs::path> CacheFiles() const {
+        vector<fs::path> files;
+        if (fs::exists(cacheDir)) {
+            for (const auto &entry: fs::directory_iterator(cacheDir)) {
+                files.push_back(entry.path());
+            }
+        }
+        return files;
+    }
+
+    // 每次都用新的引擎，保证走CreateProgram而不是引擎内的内存缓存
+    void RunAndCheck(int step) {
+        mt19937 rand(step);
+        vector<int> baseVals(step * 3);
+        vector<int> latestVals(step * 2);
+        for (auto &val: baseVals) val = rand() % 100;
+        for (auto &val: latestVals) val = rand() % 100;
+
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+
+        MegaLCSEngine engine(platformId, deviceId);
+        ASSERT_TRUE(engine.IsReady());
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+
+        vector<int> expectVers(baseVals.size(), 0);
+        vector<int> expectHors(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            expectVers.data(), expectVers.size(),
+                            expectHors.data(), expectHors.size());
+
+        EXPECT_EQ(verWeights, expectVers);
+        EXPECT_EQ(horWeights, expectHors);
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+    fs::path cacheDir;
+};
+
+TEST_F(Test_KernelCache, Test_BinaryIsWrittenAndReused) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    RunAndCheck(4);
+    auto files = CacheFiles();
+    ASSERT_EQ(files.size(), 1u);
+    auto firstWrite = fs::last_write_time(files[0]);
+
+    // 第二次命中缓存，不产生新文件
+    RunAndCheck(4);
+    files = CacheFiles();
+    ASSERT_EQ(files.size(), 1u);
+    EXPECT_EQ(fs::last_write_time(files[0]), firstWrite);
+
+    // 不同的step是不同的key
+    RunAndCheck(8);
+    EXPECT_EQ(CacheFiles().size(), 2u);
+}
+
+TEST_F(Test_KernelCache, Test_CorruptBinaryFallsBackToSource) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    RunAndCheck(4);
+    auto files = CacheFiles();
+    ASSERT_EQ(files.size(), 1u);
+
+    // 保留key行，破坏二进制内容
+    string key;
+    {
+        ifstream in(files[0], ios::binary);
+        getline(in, key);
+    }
+    {
+        ofstream out(files[0], ios::binary | ios::trunc);
+        out << key << "\n" << "not a program binary";
+    }
+
+    RunAndCheck(4);
+
+    // 回退编译后重新写入了有效的二进制
+    EXPECT_GT(fs::file_size(files[0]), key.size() + 1 + strlen("not a program binary"));
+}
+
+TEST_F(Test_KernelCache, Test_DisabledCacheWritesNothing) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    Mega::SetKernelCacheDir("");
+    RunAndCheck(4);
+    EXPECT_TRUE(CacheFiles().empty());
+}
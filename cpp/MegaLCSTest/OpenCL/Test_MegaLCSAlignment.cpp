@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSAlignment : public ::testing::Test {
+protected:
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 精确的LCS长度
+    static int ExactLength(vector<int> baseVals, vector<int> latestVals) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_BitParallel(baseVals.data(), baseVals.size(),
+                                 latestVals.data(), latestVals.size(),
+                                 verWeights.data(), verWeights.size(),
+                                 horWeights.data(), horWeights.size());
+        return horWeights.back();
+    }
+
+    // 匹配对必须严格递增且元素相同
+    static void ExpectValid(const vector<pair<int, int>> &pairs,
+                            const vector<int> &baseVals, const vector<int> &latestVals) {
+        for (size_t i = 0; i < pairs.size(); i++) {
+            ASSERT_GE(pairs[i].first, 0);
+            ASSERT_GE(pairs[i].second, 0);
+            ASSERT_LT(pairs[i].first, (int) baseVals.size());
+            ASSERT_LT(pairs[i].second, (int) latestVals.size());
+            EXPECT_EQ(baseVals[pairs[i].first], latestVals[pairs[i].second]) << "pair " << i;
+            if (i > 0) {
+                EXPECT_LT(pairs[i - 1].first, pairs[i].first) << "pair " << i;
+                EXPECT_LT(pairs[i - 1].second, pairs[i].second) << "pair " << i;
+            }
+        }
+    }
+};
+
+TEST_F(Test_MegaLCSAlignment, Test_SmallLeaf) {
+    vector<int> baseVals = {1, 2, 3, 4, 5};
+    vector<int> latestVals = {2, 4, 5, 6};
+    auto pairs = Mega::MegaLCS_Alignment(nullptr, nullptr, baseVals, latestVals, 2);
+
+    vector<pair<int, int>> expectPairs = {{1, 0}, {3, 1}, {4, 2}};
+    EXPECT_EQ(pairs, expectPairs);
+
+    EXPECT_TRUE(Mega::MegaLCS_Alignment(nullptr, nullptr, {}, latestVals, 2).empty());
+    EXPECT_TRUE(Mega::MegaLCS_Alignment(nullptr, nullptr, baseVals, {7}, 2).empty());
+}
+
+TEST_F(Test_MegaLCSAlignment, Test_RecursiveWithoutGpu) {
+    // 超过叶子大小，至少分割两层
+    mt19937 rand(11);
+    auto baseVals = RandomVals(rand, 2500, 4);
+    auto latestVals = RandomVals(rand, 1900, 4);
+
+    auto pairs = Mega::MegaLCS_Alignment(nullptr, nullptr, baseVals, latestVals, 256);
+
+    ExpectValid(pairs, baseVals, latestVals);
+    EXPECT_EQ((int) pairs.size(), ExactLength(baseVals, latestVals));
+}
+
+TEST_F(Test_MegaLCSAlignment, Test_RecursiveWithGpu) {
+    auto devicePair = Mega::GetFirstGpuDevice();
+    ASSERT_NE(devicePair.second, nullptr) << "No OpenCL GPU device found.";
+
+    mt19937 rand(12);
+    auto baseVals = RandomVals(rand, 1300, 4);
+    auto latestVals = RandomVals(rand, 1100, 4);
+    int exactLength = ExactLength(baseVals, latestVals);
+
+    // 默认引擎是MinMax内核，分割仍然用位并行内核精确计算，对齐是最长的，引擎的设置不变
+    auto engine = MegaLCSEngine::GetDefault(devicePair.first, devicePair.second);
+    ASSERT_EQ(engine->GetKernelVariant(), MegaLCSKernelVariant::Shared);
+    auto pairs = Mega::MegaLCS_Alignment(devicePair.first, devicePair.second, baseVals, latestVals, 64);
+    ExpectValid(pairs, baseVals, latestVals);
+    EXPECT_EQ((int) pairs.size(), exactLength);
+    EXPECT_EQ(engine->GetKernelVariant(), MegaLCSKernelVariant::Shared);
+
+    // step不是32的倍数时分割在CPU上精确计算
+    pairs = Mega::MegaLCS_Alignment(devicePair.first, devicePair.second, baseVals, latestVals, 48);
+    ExpectValid(pairs, baseVals, latestVals);
+    EXPECT_EQ((int) pairs.size(), exactLength);
+}
+
+TEST_F(Test_MegaLCSAlignment, Test_MegaLCSAlign) {
+    // 和MegaLCSLen使用相同的设备和step，长度是精确的LCS
+    mt19937 rand(13);
+    auto baseVals = RandomVals(rand, 900, 3);
+    auto latestVals = RandomVals(rand, 1000, 3);
+
+    auto pairs = Mega::MegaLCSAlign(baseVals, latestVals);
+    ExpectValid(pairs, baseVals, latestVals);
+    EXPECT_EQ((int) pairs.size(), ExactLength(baseVals, latestVals));
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSAnchored : public ::testing::Test {
+protected:
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    static int ExactLength(const vector<int> &baseVals, const vector<int> &latestVals) {
+        if (baseVals.empty() || latestVals.empty()) {
+            return 0;
+        }
+        return Mega::CpuLCS_DPMatrix(baseVals, latestVals).second.back();
+    }
+
+    // 模拟文件diff：大部分行唯一且相同，中间有几处删除、插入和修改
+    static pair<vector<int>, vector<int>> EditedFile(mt19937 &rand, int lines) {
+        vector<int> baseVals(lines);
+        for (int i = 0; i < lines; i++) {
+            baseVals[i] = i;
+        }
+
+        vector<int> latestVals;
+        for (int i = 0; i < lines; i++) {
+            int action = rand() % 50;
+            if (action == 0) {
+                continue;
+            }
+            if (action == 1) {
+                latestVals.push_back(1000000 + i);
+            }
+            // 重复的空行之类，不是唯一元素
+            latestVals.push_back(action == 2 ? -1 : baseVals[i]);
+        }
+        return make_pair(baseVals, latestVals);
+    }
+};
+
+TEST_F(Test_MegaLCSAnchored, Test_TrimOnlyIsExact) {
+    // 前缀、后缀长度覆盖向量宽度内外的各种位置
+    for (int j = 0; j < 30; j++) {
+        mt19937 rand(j);
+        auto common = RandomVals(rand, j * 3, 4);
+        auto baseVals = RandomVals(rand, 1 + rand() % 60, 4);
+        auto latestVals = RandomVals(rand, 1 + rand() % 60, 4);
+        baseVals.insert(baseVals.begin(), common.begin(), common.begin() + j);
+        latestVals.insert(latestVals.begin(), common.begin(), common.begin() + j);
+        baseVals.insert(baseVals.end(), common.begin() + j, common.end());
+        latestVals.insert(latestVals.end(), common.begin() + j, common.end());
+
+        auto result = Mega::MegaLCS_Anchored(nullptr, nullptr, baseVals, latestVals, 16, false);
+
+        EXPECT_EQ(result.first, ExactLength(baseVals, latestVals)) << "case " << j;
+        EXPECT_TRUE(result.second);
+    }
+}
+
+TEST_F(Test_MegaLCSAnchored, Test_IdenticalAndEmpty) {
+    vector<int> vals = {5, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377, 610, 987, 1597, 2584};
+    auto result = Mega::MegaLCS_Anchored(nullptr, nullptr, vals, vals, 4);
+    EXPECT_EQ(result.first, (int) vals.size());
+    EXPECT_TRUE(result.second);
+
+    vector<int> prefix(vals.begin(), vals.begin() + 7);
+    result = Mega::MegaLCS_Anchored(nullptr, nullptr, vals, prefix, 4);
+    EXPECT_EQ(result.first, 7);
+    EXPECT_TRUE(result.second);
+
+    result = Mega::MegaLCS_Anchored(nullptr, nullptr, vals, {}, 4);
+    EXPECT_EQ(result.first, 0);
+    EXPECT_TRUE(result.second);
+}
+
+TEST_F(Test_MegaLCSAnchored, Test_AnchorsOnEditedFile) {
+    for (int j = 0; j < 5; j++) {
+        mt19937 rand(100 + j);
+        auto file = EditedFile(rand, 1500);
+        int exactLength = ExactLength(file.first, file.second);
+
+        auto result = Mega::MegaLCS_Anchored(nullptr, nullptr, file.first, file.second, 64);
+        EXPECT_FALSE(result.second);
+        EXPECT_LE(result.first, exactLength);
+        // 唯一行组成的文件，锚点不会丢掉匹配
+        EXPECT_EQ(result.first, exactLength) << "case " << j;
+    }
+}
+
+TEST_F(Test_MegaLCSAnchored, Test_NoUniqueTokensStaysExact) {
+    // 小字母表里几乎没有唯一元素，找不到锚点时结果仍然是精确的
+    mt19937 rand(7);
+    auto baseVals = RandomVals(rand, 400, 2);
+    auto latestVals = RandomVals(rand, 300, 2);
+
+    auto result = Mega::MegaLCS_Anchored(nullptr, nullptr, baseVals, latestVals, 64);
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(result.first, ExactLength(baseVals, latestVals));
+}
+
+TEST_F(Test_MegaLCSAnchored, Test_WithGpu) {
+    auto devicePair = Mega::GetFirstGpuDevice();
+    ASSERT_NE(devicePair.second, nullptr) << "No OpenCL GPU device found.";
+
+    mt19937 rand(8);
+    auto file = EditedFile(rand, 3000);
+    auto result = Mega::MegaLCS_Anchored(devicePair.first, devicePair.second, file.first, file.second, 16);
+    auto cpuResult = Mega::MegaLCS_Anchored(nullptr, nullptr, file.first, file.second, 16);
+
+    EXPECT_EQ(result, cpuResult);
+}
+
+TEST_F(Test_MegaLCSAnchored, Test_ExactOnlyWithExactEngine) {
+    auto devicePair = Mega::GetFirstGpuDevice();
+    ASSERT_NE(devicePair.second, nullptr) << "No OpenCL GPU device found.";
+
+    // 设备上的MinMax内核在这里多算1（真实的LCS是2），不能标记为精确
+    vector<int> baseVals = {1, 1, 0, 0};
+    vector<int> latestVals = {0, 0, 1, 0, 1};
+    auto result = Mega::MegaLCS_Anchored(devicePair.first, devicePair.second, baseVals, latestVals, 1, false);
+    EXPECT_FALSE(result.second);
+
+    result = Mega::MegaLCS_Anchored(nullptr, nullptr, baseVals, latestVals, 1, false);
+    EXPECT_EQ(result, make_pair(2, true));
+
+    result = Mega::MegaLCS_Anchored(nullptr, nullptr, baseVals, latestVals, 1, false, MegaLCSCpuEngine::MinMax);
+    EXPECT_FALSE(result.second);
+
+    // 设备上的位并行内核是精确的
+    auto engine = MegaLCSEngine::GetDefault(devicePair.first, devicePair.second);
+    engine->SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+    mt19937 rand(9);
+    baseVals = RandomVals(rand, 300, 2);
+    latestVals = RandomVals(rand, 250, 2);
+    result = Mega::MegaLCS_Anchored(devicePair.first, devicePair.second, baseVals, latestVals, 32, false);
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(result.first, ExactLength(baseVals, latestVals));
+
+    // step不是32的倍数时内核回退到MinMax
+    result = Mega::MegaLCS_Anchored(devicePair.first, devicePair.second, baseVals, latestVals, 16, false);
+    EXPECT_FALSE(result.second);
+    engine->SetKernelVariant(MegaLCSKernelVariant::Shared);
+}
+
+// 没有设备时MinMax引擎的空隙按分到的线程数走CpuLCS_WaveFront，结果和整体计算的MinMax相同
+TEST_F(Test_MegaLCSAnchored, Test_CpuWaveFrontGaps) {
+    mt19937 rand(14);
+    auto baseVals = RandomVals(rand, 700, 4);
+    auto latestVals = RandomVals(rand, 600, 4);
+
+    // 没有公共前缀/后缀，整个矩阵就是一个空隙
+    baseVals.front() = 4;
+    latestVals.front() = 5;
+    baseVals.back() = 6;
+    latestVals.back() = 7;
+
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+    Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                        latestVals.data(), latestVals.size(),
+                        verWeights.data(), verWeights.size(),
+                        horWeights.data(), horWeights.size());
+
+    auto result = Mega::MegaLCS_Anchored(nullptr, nullptr, baseVals, latestVals, 64, false,
+                                         MegaLCSCpuEngine::MinMaxSimd);
+    EXPECT_EQ(result, make_pair(horWeights.back(), false));
+}
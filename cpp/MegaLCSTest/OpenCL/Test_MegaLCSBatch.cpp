@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSBatch : public ::testing::Test {
+protected:
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 长度覆盖空序列、短于step、step的倍数和边缘不满的tile
+    static vector<pair<vector<int>, vector<int>>> RandomPairs(mt19937 &rand, int count, int maxLength) {
+        vector<pair<vector<int>, vector<int>>> pairs;
+        for (int p = 0; p < count; p++) {
+            int baseLength = p % 7 == 0 ? 0 : rand() % (maxLength + 1);
+            int latestLength = p % 11 == 0 ? 0 : rand() % (maxLength + 1);
+            pairs.emplace_back(RandomVals(rand, baseLength, 4), RandomVals(rand, latestLength, 4));
+        }
+        return pairs;
+    }
+
+    // 逐对的CpuLCS_MinMax，和逐对调用MegaLCS_Fusion的结果相同
+    static void ExpectSameAsMinMax(const vector<pair<vector<int>, vector<int>>> &pairs,
+                                   const MegaLCSBatch &batch,
+                                   const MegaLCSBatchResult &result,
+                                   bool withWeights) {
+        ASSERT_EQ(result.lengths.size(), pairs.size());
+        for (int p = 0; p < (int) pairs.size(); p++) {
+            auto baseVals = pairs[p].first;
+            auto latestVals = pairs[p].second;
+            if (baseVals.empty() || latestVals.empty()) {
+                EXPECT_EQ(result.lengths[p], 0) << "pair " << p;
+                continue;
+            }
+
+            vector<int> verWeights(baseVals.size(), 0);
+            vector<int> horWeights(latestVals.size(), 0);
+            Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                                latestVals.data(), latestVals.size(),
+                                verWeights.data(), verWeights.size(),
+                                horWeights.data(), horWeights.size());
+
+            EXPECT_EQ(result.lengths[p], horWeights.back()) << "pair " << p;
+            if (withWeights) {
+                EXPECT_EQ(vector<int>(result.verWeights.begin() + batch.baseOffsets[p],
+                                      result.verWeights.begin() + batch.baseOffsets[p + 1]), verWeights)
+                                    << "pair " << p;
+                EXPECT_EQ(vector<int>(result.horWeights.begin() + batch.latestOffsets[p],
+                                      result.horWeights.begin() + batch.latestOffsets[p + 1]), horWeights)
+                                    << "pair " << p;
+            }
+        }
+    }
+};
+
+TEST_F(Test_MegaLCSBatch, Test_PackBatch) {
+    vector<pair<vector<int>, vector<int>>> pairs = {
+            {{1, 2, 3}, {4}},
+            {{},        {5, 6}},
+            {{7},       {}}
+    };
+
+    auto batch = Mega::PackBatch(pairs);
+    EXPECT_EQ(batch.baseVals, vector<int>({1, 2, 3, 7}));
+    EXPECT_EQ(batch.baseOffsets, vector<int>({0, 3, 3, 4}));
+    EXPECT_EQ(batch.latestVals, vector<int>({4, 5, 6}));
+    EXPECT_EQ(batch.latestOffsets, vector<int>({0, 1, 3, 3}));
+
+    auto empty = Mega::PackBatch({});
+    EXPECT_EQ(empty.baseOffsets, vector<int>({0}));
+    EXPECT_TRUE(Mega::MegaLCS_Batch(platformId, deviceId, empty, 16).lengths.empty());
+}
+
+TEST_F(Test_MegaLCSBatch, Test_SameAsMinMax) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    for (int step: {1, 16, 32}) {
+        mt19937 rand(step);
+        auto pairs = RandomPairs(rand, 200, 100);
+        auto batch = Mega::PackBatch(pairs);
+
+        auto result = Mega::MegaLCS_Batch(platformId, deviceId, batch, step);
+        EXPECT_FALSE(result.processByCpu);
+        EXPECT_TRUE(result.verWeights.empty());
+        ExpectSameAsMinMax(pairs, batch, result, false);
+    }
+}
+
+TEST_F(Test_MegaLCSBatch, Test_WithWeights) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    mt19937 rand(20);
+    auto pairs = RandomPairs(rand, 100, 80);
+    auto batch = Mega::PackBatch(pairs);
+
+    auto result = Mega::MegaLCS_Batch(platformId, deviceId, batch, 16, true);
+    ExpectSameAsMinMax(pairs, batch, result, true);
+}
+
+TEST_F(Test_MegaLCSBatch, Test_LargePairsRunAlone) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    // step=1时第0对有40*40个tile，超过单个block独占的上限
+    mt19937 rand(21);
+    vector<pair<vector<int>, vector<int>>> pairs = {
+            {RandomVals(rand, 40, 4), RandomVals(rand, 40, 4)},
+            {RandomVals(rand, 5, 4),  RandomVals(rand, 9, 4)},
+            {RandomVals(rand, 33, 4), RandomVals(rand, 33, 4)},
+    };
+    auto batch = Mega::PackBatch(pairs);
+
+    auto result = Mega::MegaLCS_Batch(platformId, deviceId, batch, 1, true);
+    ExpectSameAsMinMax(pairs, batch, result, true);
+}
+
+TEST_F(Test_MegaLCSBatch, Test_CpuFallback) {
+    mt19937 rand(22);
+    auto pairs = RandomPairs(rand, 300, 60);
+    auto batch = Mega::PackBatch(pairs);
+
+    auto result = Mega::MegaLCS_Batch(nullptr, nullptr, batch, 16, true);
+    EXPECT_TRUE(result.processByCpu);
+    ExpectSameAsMinMax(pairs, batch, result, true);
+}
+
+TEST_F(Test_MegaLCSBatch, Test_Invalid) {
+    MegaLCSBatch batch;
+    batch.baseVals = {1, 2};
+    batch.baseOffsets = {0, 2};
+    batch.latestVals = {1};
+    batch.latestOffsets = {0, 1};
+
+    EXPECT_THROW(Mega::MegaLCS_Batch(nullptr, nullptr, batch, 0), runtime_error);
+    EXPECT_THROW(Mega::MegaLCS_Batch(nullptr, nullptr, batch, 257), runtime_error);
+
+    auto wrongTotal = batch;
+    wrongTotal.baseOffsets = {0, 1};
+    EXPECT_THROW(Mega::MegaLCS_Batch(nullptr, nullptr, wrongTotal, 16), invalid_argument);
+
+    auto wrongCount = batch;
+    wrongCount.latestOffsets = {0, 0, 1};
+    EXPECT_THROW(Mega::MegaLCS_Batch(nullptr, nullptr, wrongCount, 16), invalid_argument);
+
+    auto decreasing = batch;
+    decreasing.baseOffsets = {0, 2, 1, 2};
+    decreasing.latestOffsets = {0, 1, 1, 1};
+    EXPECT_THROW(Mega::MegaLCS_Batch(nullptr, nullptr, decreasing, 16), invalid_argument);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSEngine : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    void TearDown() override {
+        // Cleanup code if needed
+    }
+
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+};
+
+// 生成长度为step倍数的随机数组
+static vector<int> RandomVals(mt19937 &rand, int sliceCount, int step, int maxVal) {
+    vector<int> vals(sliceCount * step);
+    for (auto &val: vals) {
+        val = rand() % maxVal;
+    }
+    return vals;
+}
+
+// 用CPU原型计算期望值，内核和CpuLCS_MinMax是逐元素等价的
+static pair<vector<int>, vector<int>> ExpectByCpu(vector<int> baseVals, vector<int> latestVals) {
+    vector<int> verWeights(baseVals.size(), 0);
+    vector<int> horWeights(latestVals.size(), 0);
+    Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                        latestVals.data(), latestVals.size(),
+                        verWeights.data(), verWeights.size(),
+                        horWeights.data(), horWeights.size());
+    return make_pair(verWeights, horWeights);
+}
+
+TEST_F(Test_MegaLCSEngine, Test_DefaultInstanceIsShared) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    auto engine1 = MegaLCSEngine::GetDefault(platformId, deviceId);
+    auto engine2 = MegaLCSEngine::GetDefault(platformId, deviceId);
+
+    EXPECT_TRUE(engine1->IsReady());
+    EXPECT_EQ(engine1.get(), engine2.get());
+    EXPECT_EQ(engine1->GetDeviceId(), deviceId);
+}
+
+TEST_F(Test_MegaLCSEngine, Test_ReuseAcrossCallsAndSteps) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+
+    // 同一个引擎交替使用不同的step，缓存的内核必须互不干扰
+    for (int j = 0; j < 6; j++) {
+        mt19937 rand(j);
+        int step = (j % 2 == 0) ? 4 : 8;
+
+        auto baseVals = RandomVals(rand, 3 + j, step, 16);
+        auto latestVals = RandomVals(rand, 2 + j, step, 16);
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+
+        auto expectResult = ExpectByCpu(baseVals, latestVals);
+        EXPECT_EQ(verWeights, expectResult.first);
+        EXPECT_EQ(horWeights, expectResult.second);
+    }
+}
+
+TEST_F(Test_MegaLCSEngine, Test_SubmitModesAgree) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine engine(platformId, deviceId);
+    ASSERT_TRUE(engine.IsReady());
+    EXPECT_EQ(engine.GetSubmitMode(), MegaLCSSubmitMode::Pipelined);
+
+    mt19937 rand(7);
+    const int step = 4;
+    auto baseVals = RandomVals(rand, 9, step, 16);
+    auto latestVals = RandomVals(rand, 13, step, 16);
+    auto expectResult = ExpectByCpu(baseVals, latestVals);
+
+    for (auto mode: {MegaLCSSubmitMode::FinishPerBand, MegaLCSSubmitMode::Pipelined}) {
+        engine.SetSubmitMode(mode);
+
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        engine.HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+
+        EXPECT_EQ(verWeights, expectResult.first);
+        EXPECT_EQ(horWeights, expectResult.second);
+    }
+}
+
+TEST_F(Test_MegaLCSEngine, Test_PersistentMatchesShared) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    MegaLCSEngine sharedEngine(platformId, deviceId);
+    MegaLCSEngine persistentEngine(platformId, deviceId);
+    ASSERT_TRUE(sharedEngine.IsReady());
+    ASSERT_TRUE(persistentEngine.IsReady());
+    persistentEngine.SetKernelVariant(MegaLCSKernelVariant::Persistent);
+
+    // 行数多于常驻block数、只有一行、只有一列等形状
+    vector<pair<int, int>> sliceCounts = {{1, 1}, {1, 7}, {9, 1}, {5, 5}, {40, 3}, {3, 17}};
+    for (size_t j = 0; j < sliceCounts.size(); j++) {
+        mt19937 rand(j);
+        int step = (j % 2 == 0) ? 4 : 8;
+
+        auto baseVals = RandomVals(rand, sliceCounts[j].first, step, 4);
+        auto latestVals = RandomVals(rand, sliceCounts[j].second, step, 4);
+
+        vector<int> sharedVers(baseVals.size(), 0);
+        vector<int> sharedHors(latestVals.size(), 0);
+        sharedEngine.HostLCS_WaveFront(baseVals, latestVals, sharedVers, sharedHors, true, step);
+
+        vector<int> persistentVers(baseVals.size(), 0);
+        vector<int> persistentHors(latestVals.size(), 0);
+        persistentEngine.HostLCS_WaveFront(baseVals, latestVals, persistentVers, persistentHors, true, step);
+
+        EXPECT_EQ(persistentVers, sharedVers) << "case " << j;
+        EXPECT_EQ(persistentHors, sharedHors) << "case " << j;
+    }
+}
+
+TEST_F(Test_MegaLCSEngine, Test_SharedAcrossThreads) {
+    ASSERT_NE(deviceId, nullptr) << "No OpenCL GPU device found.";
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    const int threadCount = 4;
+    vector<int> failures(threadCount, 0);
+    vector<thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            for (int j = 0; j < 3; j++) {
+                mt19937 rand(t * 100 + j);
+                const int step = 4;
+
+                auto baseVals = RandomVals(rand, 4, step, 6);
+                auto latestVals = RandomVals(rand, 5, step, 6);
+                vector<int> verWeights(baseVals.size(), 0);
+                vector<int> horWeights(latestVals.size(), 0);
+
+                engine->HostLCS_WaveFront(baseVals, latestVals, verWeights, horWeights, true, step);
+
+                auto expectResult = ExpectByCpu(baseVals, latestVals);
+                if (verWeights != expectResult.first || horWeights != expectResult.second) {
+                    failures[t]++;
+                }
+            }
+        });
+    }
+
+    for (auto &th: threads) {
+        th.join();
+    }
+
+    for (int t = 0; t < threadCount; t++) {
+        EXPECT_EQ(failures[t], 0) << "thread " << t;
+    }
+}
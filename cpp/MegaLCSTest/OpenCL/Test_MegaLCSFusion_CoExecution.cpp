@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSFusion_CoExecution : public ::testing::Test {
+protected:
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    static void ExpectSameAsMinMax(vector<int> baseVals, vector<int> latestVals,
+                                   const tuple<bool, vector<int>, vector<int>> &result) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        EXPECT_EQ(get<1>(result), verWeights);
+        EXPECT_EQ(get<2>(result), horWeights);
+    }
+};
+
+TEST_F(Test_MegaLCSFusion_CoExecution, Test_DefaultOff) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    EXPECT_FALSE(engine->GetCpuCoExecution());
+}
+
+// 同时计算和只用设备计算的结果逐元素一致，包括不是step倍数的长度
+TEST_F(Test_MegaLCSFusion_CoExecution, Test_SameAsDeviceOnly) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    mt19937 rand(24);
+    vector<pair<int, int>> sizes = {{256, 256}, {1000, 777}, {333, 2049}, {2048, 100}};
+
+    for (auto &size: sizes) {
+        auto baseVals = RandomVals(rand, size.first, 4);
+        auto latestVals = RandomVals(rand, size.second, 4);
+
+        engine->SetCpuCoExecution(true);
+        auto coExecution = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, 32);
+        engine->SetCpuCoExecution(false);
+        auto deviceOnly = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, 32);
+
+        EXPECT_FALSE(get<0>(coExecution));
+        EXPECT_EQ(get<1>(coExecution), get<1>(deviceOnly));
+        EXPECT_EQ(get<2>(coExecution), get<2>(deviceOnly));
+        ExpectSameAsMinMax(baseVals, latestVals, coExecution);
+    }
+
+    engine->SetCpuCoExecution(false);
+}
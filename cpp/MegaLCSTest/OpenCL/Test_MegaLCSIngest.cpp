@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSIngest : public ::testing::Test {
+protected:
+    static string WriteFile(const string &name, const string &content) {
+        auto path = filesystem::temp_directory_path() / ("MegaLCSIngest_" + name);
+        ofstream file(path, ios::binary);
+        file << content;
+        return path.string();
+    }
+
+    // 顺序的参考实现：按分隔符切分，第一次出现的token分配下一个ID
+    static vector<string> Split(const string &content, char delimiter) {
+        vector<string> tokens;
+        size_t position = 0;
+        while (position < content.size()) {
+            size_t end = content.find(delimiter, position);
+            if (end == string::npos) {
+                end = content.size();
+            }
+            tokens.push_back(content.substr(position, end - position));
+            position = end + 1;
+        }
+        return tokens;
+    }
+
+    // ID的分配顺序和线程调度有关，只比较"相同token ⇔ 相同ID"
+    static void ExpectSamePartition(const vector<string> &tokens, const vector<int> &ids,
+                                    unordered_map<string, int> &tokenIds) {
+        ASSERT_EQ(tokens.size(), ids.size());
+        for (size_t i = 0; i < tokens.size(); i++) {
+            auto it = tokenIds.find(tokens[i]);
+            if (it == tokenIds.end()) {
+                tokenIds.emplace(tokens[i], ids[i]);
+            } else {
+                ASSERT_EQ(it->second, ids[i]) << "token " << i;
+            }
+        }
+    }
+};
+
+TEST_F(Test_MegaLCSIngest, test_ex) {
+    auto basePath = WriteFile("ex.txt", "a\n");
+    EXPECT_THROW(Mega::MegaLCS_LoadFiles(basePath, basePath + ".missing"), runtime_error);
+}
+
+TEST_F(Test_MegaLCSIngest, test_SharedIds) {
+    auto basePath = WriteFile("base.txt", "a\nb\nc\na\n");
+    auto latestPath = WriteFile("latest.txt", "c\na\nd");
+
+    auto result = Mega::MegaLCS_LoadFiles(basePath, latestPath);
+
+    ASSERT_EQ(result.baseVals.size(), 4);
+    ASSERT_EQ(result.latestVals.size(), 3);
+    EXPECT_EQ(result.alphabetSize, 4);
+    EXPECT_EQ(result.baseVals[0], result.baseVals[3]);
+    EXPECT_EQ(result.baseVals[2], result.latestVals[0]);
+    EXPECT_EQ(result.baseVals[0], result.latestVals[1]);
+    EXPECT_NE(result.latestVals[2], result.baseVals[1]);
+
+    for (int val: result.baseVals) {
+        EXPECT_TRUE(0 <= val && val < result.alphabetSize);
+    }
+    for (int val: result.latestVals) {
+        EXPECT_TRUE(0 <= val && val < result.alphabetSize);
+    }
+}
+
+TEST_F(Test_MegaLCSIngest, test_EmptyFile) {
+    auto emptyPath = WriteFile("empty.txt", "");
+    auto latestPath = WriteFile("one.txt", "x");
+
+    auto result = Mega::MegaLCS_LoadFiles(emptyPath, latestPath);
+
+    EXPECT_TRUE(result.baseVals.empty());
+    EXPECT_EQ(result.latestVals, vector<int>{0});
+    EXPECT_EQ(result.alphabetSize, 1);
+}
+
+TEST_F(Test_MegaLCSIngest, test_Normalize) {
+    auto basePath = WriteFile("norm_base.txt", "Foo Bar\r\nbaz\n");
+    auto latestPath = WriteFile("norm_latest.txt", "foobar\n  BAZ\t\n");
+
+    auto exact = Mega::MegaLCS_LoadFiles(basePath, latestPath);
+    EXPECT_EQ(exact.alphabetSize, 4);
+
+    MegaLCSTokenizeOptions options;
+    options.ignoreWhitespace = true;
+    auto noSpace = Mega::MegaLCS_LoadFiles(basePath, latestPath, options);
+    EXPECT_EQ(noSpace.alphabetSize, 4);
+
+    options.ignoreCase = true;
+    auto normalized = Mega::MegaLCS_LoadFiles(basePath, latestPath, options);
+    EXPECT_EQ(normalized.alphabetSize, 2);
+    EXPECT_EQ(normalized.baseVals, normalized.latestVals);
+}
+
+TEST_F(Test_MegaLCSIngest, test_Delimiter) {
+    auto basePath = WriteFile("delim_base.txt", "a b,c,a b");
+    auto latestPath = WriteFile("delim_latest.txt", ",c,");
+
+    MegaLCSTokenizeOptions options;
+    options.delimiter = ',';
+    auto result = Mega::MegaLCS_LoadFiles(basePath, latestPath, options);
+
+    // 开头的分隔符产生一个空token
+    ASSERT_EQ(result.baseVals.size(), 3);
+    ASSERT_EQ(result.latestVals.size(), 2);
+    EXPECT_EQ(result.baseVals[0], result.baseVals[2]);
+    EXPECT_EQ(result.baseVals[1], result.latestVals[1]);
+    EXPECT_EQ(result.alphabetSize, 3);
+}
+
+TEST_F(Test_MegaLCSIngest, test_MultiThreadChunks) {
+    // 文件足够大，按4个线程切块，块边界落在行中间
+    mt19937 rand(1);
+    string baseContent;
+    string latestContent;
+    for (int i = 0; i < 60000; i++) {
+        baseContent += "line " + to_string(rand() % 5000) + (i % 7 == 0 ? "\n\n" : "\n");
+        latestContent += "line " + to_string(rand() % 5000) + "\n";
+    }
+    latestContent += "tail without delimiter";
+
+    auto basePath = WriteFile("mt_base.txt", baseContent);
+    auto latestPath = WriteFile("mt_latest.txt", latestContent);
+
+    MegaLCSTokenizeOptions options;
+    options.threadCount = 4;
+    auto result = Mega::MegaLCS_LoadFiles(basePath, latestPath, options);
+
+    unordered_map<string, int> tokenIds;
+    ExpectSamePartition(Split(baseContent, '\n'), result.baseVals, tokenIds);
+    ExpectSamePartition(Split(latestContent, '\n'), result.latestVals, tokenIds);
+    EXPECT_EQ(result.alphabetSize, (int) tokenIds.size());
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSMultiDevice : public ::testing::Test {
+protected:
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 第一个CPU OpenCL设备，用来切子设备
+    static pair<cl_platform_id, cl_device_id> GetFirstCpuDevice() {
+        for (const auto &device: Mega::GetAllDevices()) {
+            if (get<3>(device) == CL_DEVICE_TYPE_CPU) {
+                return make_pair(get<0>(device), get<1>(device));
+            }
+        }
+        return make_pair((cl_platform_id) nullptr, (cl_device_id) nullptr);
+    }
+
+    static void ExpectSameAsMinMax(vector<int> baseVals, vector<int> latestVals,
+                                   const pair<vector<int>, vector<int>> &result) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        EXPECT_EQ(result.first, verWeights);
+        EXPECT_EQ(result.second, horWeights);
+    }
+};
+
+TEST_F(Test_MegaLCSMultiDevice, Test_SubDevices) {
+    auto cpuDevice = GetFirstCpuDevice();
+    if (cpuDevice.first == nullptr) {
+        GTEST_SKIP() << "No CPU OpenCL device found";
+    }
+
+    auto subDevices = Mega::CreateSubDevices(cpuDevice.first, cpuDevice.second, 4);
+    if (subDevices.empty()) {
+        GTEST_SKIP() << "CPU device does not support partitioning";
+    }
+    ASSERT_EQ(subDevices.size(), 4u);
+
+    mt19937 rand(40);
+    auto baseVals = RandomVals(rand, 300, 4);
+    auto latestVals = RandomVals(rand, 270, 4);
+
+    // 测出来的吞吐，以及手工指定的不均匀分配
+    ExpectSameAsMinMax(baseVals, latestVals, Mega::MegaLCS_MultiDevice(subDevices, baseVals, latestVals, 16));
+    ExpectSameAsMinMax(baseVals, latestVals,
+                       Mega::MegaLCS_MultiDevice(subDevices, baseVals, latestVals, 16, {1, 2, 3, 4}));
+}
+
+TEST_F(Test_MegaLCSMultiDevice, Test_Pipeline) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    // 同一个设备出现多次时共用一个引擎，流水线和边界传递的逻辑和不同设备相同
+    vector<pair<cl_platform_id, cl_device_id>> devices = {{platformId, deviceId},
+                                                           {platformId, deviceId},
+                                                           {platformId, deviceId}};
+    for (auto lengths: vector<pair<int, int>>{{200, 170}, {20, 300}, {250, 30}}) {
+        mt19937 rand(lengths.first);
+        auto baseVals = RandomVals(rand, lengths.first, 4);
+        auto latestVals = RandomVals(rand, lengths.second, 4);
+
+        ExpectSameAsMinMax(baseVals, latestVals,
+                           Mega::MegaLCS_MultiDevice(devices, baseVals, latestVals, 16, {1, 3, 2}));
+    }
+
+    // 吞吐为0的设备不参与
+    mt19937 rand(41);
+    auto baseVals = RandomVals(rand, 100, 4);
+    auto latestVals = RandomVals(rand, 100, 4);
+    ExpectSameAsMinMax(baseVals, latestVals,
+                       Mega::MegaLCS_MultiDevice(devices, baseVals, latestVals, 16, {0, 1, 0}));
+}
+
+TEST_F(Test_MegaLCSMultiDevice, Test_BitParallelEngine) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    // 引擎设置成位并行内核时，第一个列块的边界是合法的DP边界，不固定内核就会和其他列块的MinMax混用
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    engine->SetKernelVariant(MegaLCSKernelVariant::BitParallel);
+
+    vector<pair<cl_platform_id, cl_device_id>> devices = {{platformId, deviceId},
+                                                           {platformId, deviceId}};
+    mt19937 rand(43);
+    auto baseVals = RandomVals(rand, 300, 4);
+    auto latestVals = RandomVals(rand, 280, 4);
+    ExpectSameAsMinMax(baseVals, latestVals,
+                       Mega::MegaLCS_MultiDevice(devices, baseVals, latestVals, 32, {1, 1}));
+    ExpectSameAsMinMax(baseVals, latestVals,
+                       Mega::MegaLCS_MultiDevice(devices, baseVals, latestVals, 32));
+    EXPECT_EQ(engine->GetKernelVariant(), MegaLCSKernelVariant::BitParallel);
+
+    engine->SetKernelVariant(MegaLCSKernelVariant::Shared);
+}
+
+TEST_F(Test_MegaLCSMultiDevice, Test_NoDevice) {
+    mt19937 rand(42);
+    auto baseVals = RandomVals(rand, 120, 4);
+    auto latestVals = RandomVals(rand, 90, 4);
+
+    ExpectSameAsMinMax(baseVals, latestVals, Mega::MegaLCS_MultiDevice({}, baseVals, latestVals, 16));
+
+    auto empty = Mega::MegaLCS_MultiDevice({}, {}, latestVals, 16);
+    EXPECT_TRUE(empty.first.empty());
+    EXPECT_EQ(empty.second, vector<int>(latestVals.size(), 0));
+}
+
+TEST_F(Test_MegaLCSMultiDevice, Test_Invalid) {
+    vector<int> vals = {1, 2, 3};
+
+    EXPECT_THROW(Mega::MegaLCS_MultiDevice({}, vals, vals, 0), runtime_error);
+    EXPECT_THROW(Mega::MegaLCS_MultiDevice({}, vals, vals, 16, {1.0}), invalid_argument);
+    EXPECT_THROW(Mega::MeasureDeviceThroughput({}, 300), runtime_error);
+}
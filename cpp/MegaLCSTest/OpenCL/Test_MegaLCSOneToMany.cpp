@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSOneToMany : public ::testing::Test {
+protected:
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 候选是base随机修改的版本，长度覆盖空序列、短于step和边缘不满的tile
+    static vector<vector<int>> RandomCandidates(mt19937 &rand, const vector<int> &baseVals, int count) {
+        vector<vector<int>> candidates;
+        for (int c = 0; c < count; c++) {
+            if (c % 9 == 0) {
+                candidates.emplace_back();
+                continue;
+            }
+            vector<int> candidate;
+            for (int val: baseVals) {
+                int action = rand() % 6;
+                if (action == 0) {
+                    continue;
+                }
+                if (action == 1) {
+                    candidate.push_back(rand() % 4);
+                }
+                candidate.push_back(val);
+            }
+            candidate.resize(rand() % (candidate.size() + 1));
+            candidates.push_back(candidate);
+        }
+        return candidates;
+    }
+
+    // 逐个的CpuLCS_MinMax，和逐个调用MegaLCS_Fusion的结果相同
+    static void ExpectSameAsMinMax(const vector<int> &baseVals,
+                                   const vector<vector<int>> &candidates,
+                                   const MegaLCSOneToManyResult &result,
+                                   bool withWeights) {
+        ASSERT_EQ(result.lengths.size(), candidates.size());
+        ASSERT_EQ(result.horWeights.size(), withWeights ? candidates.size() : 0);
+        for (int c = 0; c < (int) candidates.size(); c++) {
+            if (baseVals.empty() || candidates[c].empty()) {
+                EXPECT_EQ(result.lengths[c], 0) << "candidate " << c;
+                continue;
+            }
+
+            auto bases = baseVals;
+            auto latests = candidates[c];
+            vector<int> verWeights(bases.size(), 0);
+            vector<int> horWeights(latests.size(), 0);
+            Mega::CpuLCS_MinMax(bases.data(), bases.size(),
+                                latests.data(), latests.size(),
+                                verWeights.data(), verWeights.size(),
+                                horWeights.data(), horWeights.size());
+
+            EXPECT_EQ(result.lengths[c], horWeights.back()) << "candidate " << c;
+            if (withWeights) {
+                EXPECT_EQ(result.horWeights[c], horWeights) << "candidate " << c;
+            }
+        }
+    }
+};
+
+TEST_F(Test_MegaLCSOneToMany, Test_SameAsMinMax) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    for (int step: {8, 16, 32}) {
+        mt19937 rand(step);
+        auto baseVals = RandomVals(rand, 37 + step * 2, 4);
+        auto candidates = RandomCandidates(rand, baseVals, 120);
+
+        auto result = Mega::MegaLCS_OneToMany(platformId, deviceId, baseVals, candidates, step);
+        EXPECT_FALSE(result.processByCpu);
+        ExpectSameAsMinMax(baseVals, candidates, result, false);
+    }
+}
+
+TEST_F(Test_MegaLCSOneToMany, Test_WithWeights) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    mt19937 rand(30);
+    auto baseVals = RandomVals(rand, 90, 4);
+    auto candidates = RandomCandidates(rand, baseVals, 50);
+
+    auto result = Mega::MegaLCS_OneToMany(platformId, deviceId, baseVals, candidates, 16, true);
+    ExpectSameAsMinMax(baseVals, candidates, result, true);
+}
+
+TEST_F(Test_MegaLCSOneToMany, Test_FewLargeCandidates) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    // 候选个数占不满设备，step=2时前两个候选的tile数超过单个block独占的上限
+    mt19937 rand(31);
+    auto baseVals = RandomVals(rand, 80, 4);
+    vector<vector<int>> candidates = {
+            RandomVals(rand, 90, 4),
+            RandomVals(rand, 70, 4),
+            RandomVals(rand, 5, 4),
+            {}
+    };
+
+    auto result = Mega::MegaLCS_OneToMany(platformId, deviceId, baseVals, candidates, 2, true);
+    ExpectSameAsMinMax(baseVals, candidates, result, true);
+}
+
+TEST_F(Test_MegaLCSOneToMany, Test_CpuFallback) {
+    mt19937 rand(32);
+    auto baseVals = RandomVals(rand, 70, 4);
+    auto candidates = RandomCandidates(rand, baseVals, 40);
+
+    auto result = Mega::MegaLCS_OneToMany(nullptr, nullptr, baseVals, candidates, 16, true);
+    EXPECT_TRUE(result.processByCpu);
+    ExpectSameAsMinMax(baseVals, candidates, result, true);
+
+    auto emptyBase = Mega::MegaLCS_OneToMany(nullptr, nullptr, {}, candidates, 16);
+    ExpectSameAsMinMax({}, candidates, emptyBase, false);
+}
+
+TEST_F(Test_MegaLCSOneToMany, Test_Invalid) {
+    vector<int> baseVals = {1, 2, 3};
+    vector<vector<int>> candidates = {{1, 2}};
+
+    EXPECT_THROW(Mega::MegaLCS_OneToMany(nullptr, nullptr, baseVals, candidates, 0), runtime_error);
+    EXPECT_THROW(Mega::MegaLCS_OneToMany(nullptr, nullptr, baseVals, candidates, 257), runtime_error);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include "Mega.h"
+
+using namespace std;
+
+class Test_MegaLCSStreaming : public ::testing::Test {
+protected:
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    // 原始的int32数组
+    static string WriteFile(const string &name, const vector<int> &vals) {
+        auto path = filesystem::temp_directory_path() / ("MegaLCSStreaming_" + name);
+        ofstream file(path, ios::binary);
+        file.write(reinterpret_cast<const char *>(vals.data()), vals.size() * sizeof(int));
+        return path.string();
+    }
+
+    static int MinMaxLength(vector<int> baseVals, vector<int> latestVals) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        return horWeights.back();
+    }
+
+    // step=16、预算24*48字节时每块48行、每个条带48列
+    static const int Step = 16;
+    static const size_t SmallBudget = 24 * 48;
+};
+
+TEST_F(Test_MegaLCSStreaming, Test_SameAsMinMax) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    // 长度覆盖多个条带、多个块和边缘不满的块
+    for (auto lengths: vector<pair<int, int>>{{200, 170}, {48, 48}, {5, 300}, {250, 7}}) {
+        mt19937 rand(lengths.first);
+        auto baseVals = RandomVals(rand, lengths.first, 4);
+        auto latestVals = RandomVals(rand, lengths.second, 4);
+        auto basePath = WriteFile("base", baseVals);
+        auto latestPath = WriteFile("latest", latestVals);
+
+        EXPECT_EQ(Mega::MegaLCS_Streaming(platformId, deviceId, basePath, latestPath, Step, SmallBudget),
+                  MinMaxLength(baseVals, latestVals));
+
+        // 预算足够大时只有一个条带、一块
+        EXPECT_EQ(Mega::MegaLCS_Streaming(platformId, deviceId, basePath, latestPath, Step, (size_t) 1 << 20),
+                  MinMaxLength(baseVals, latestVals));
+    }
+}
+
+TEST_F(Test_MegaLCSStreaming, Test_BoundaryInTempFile) {
+    // base的竖直边界（400*4字节）超过预算，放在临时的内存映射文件里
+    mt19937 rand(22);
+    auto baseVals = RandomVals(rand, 400, 4);
+    auto latestVals = RandomVals(rand, 130, 4);
+    auto basePath = WriteFile("base", baseVals);
+    auto latestPath = WriteFile("latest", latestVals);
+
+    int expected = MinMaxLength(baseVals, latestVals);
+    EXPECT_EQ(Mega::MegaLCS_Streaming(nullptr, nullptr, basePath, latestPath, Step, SmallBudget), expected);
+    if (platformId != nullptr && deviceId != nullptr) {
+        EXPECT_EQ(Mega::MegaLCS_Streaming(platformId, deviceId, basePath, latestPath, Step, SmallBudget), expected);
+    }
+}
+
+TEST_F(Test_MegaLCSStreaming, Test_CpuFallback) {
+    mt19937 rand(23);
+    auto baseVals = RandomVals(rand, 150, 4);
+    auto latestVals = RandomVals(rand, 190, 4);
+    auto basePath = WriteFile("base", baseVals);
+    auto latestPath = WriteFile("latest", latestVals);
+
+    EXPECT_EQ(Mega::MegaLCS_Streaming(nullptr, nullptr, basePath, latestPath, Step, SmallBudget),
+              MinMaxLength(baseVals, latestVals));
+
+    auto emptyPath = WriteFile("empty", {});
+    EXPECT_EQ(Mega::MegaLCS_Streaming(nullptr, nullptr, emptyPath, latestPath, Step, SmallBudget), 0);
+}
+
+TEST_F(Test_MegaLCSStreaming, Test_Invalid) {
+    auto path = WriteFile("invalid", {1, 2, 3});
+
+    EXPECT_THROW(Mega::MegaLCS_Streaming(nullptr, nullptr, path, path, 0, SmallBudget), runtime_error);
+    // 放不下一个step*step的tile
+    EXPECT_THROW(Mega::MegaLCS_Streaming(nullptr, nullptr, path, path, Step, 24 * Step - 1), runtime_error);
+    EXPECT_THROW(Mega::MegaLCS_Streaming(nullptr, nullptr, path + ".missing", path, Step, SmallBudget),
+                 runtime_error);
+
+    auto oddPath = (filesystem::temp_directory_path() / "MegaLCSStreaming_odd").string();
+    ofstream(oddPath, ios::binary) << "abcde";
+    EXPECT_THROW(Mega::MegaLCS_Streaming(nullptr, nullptr, oddPath, path, Step, SmallBudget), invalid_argument);
+}
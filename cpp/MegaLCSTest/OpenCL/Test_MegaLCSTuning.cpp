@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include "Mega.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+class Test_MegaLCSTuning : public ::testing::Test {
+protected:
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+    fs::path tuningDir;
+
+    void SetUp() override {
+        auto devicePair = Mega::GetFirstGpuDevice();
+        platformId = devicePair.first;
+        deviceId = devicePair.second;
+
+        tuningDir = fs::temp_directory_path() / "MegaLCS-Test_MegaLCSTuning";
+        fs::remove_all(tuningDir);
+        Mega::SetTuningDir(tuningDir.string());
+    }
+
+    void TearDown() override {
+        // 其他测试不使用调优结果，默认引擎恢复默认设置
+        Mega::SetTuningDir("");
+        fs::remove_all(tuningDir);
+
+        if (platformId != nullptr && deviceId != nullptr) {
+            auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+            engine->SetSubmitMode(MegaLCSSubmitMode::Pipelined);
+            engine->SetKernelVariant(MegaLCSKernelVariant::Shared);
+        }
+    }
+
+    vector<fs::path> TuningFiles() const {
+        vector<fs::path> files;
+        if (fs::exists(tuningDir)) {
+            for (const auto &entry: fs::directory_iterator(tuningDir)) {
+                files.push_back(entry.path());
+            }
+        }
+        return files;
+    }
+
+    static vector<int> RandomVals(mt19937 &rand, int length, int maxVal) {
+        vector<int> vals(length);
+        for (auto &val: vals) {
+            val = rand() % maxVal;
+        }
+        return vals;
+    }
+
+    static vector<int> ExpectHors(vector<int> baseVals, vector<int> latestVals) {
+        vector<int> verWeights(baseVals.size(), 0);
+        vector<int> horWeights(latestVals.size(), 0);
+        Mega::CpuLCS_MinMax(baseVals.data(), baseVals.size(),
+                            latestVals.data(), latestVals.size(),
+                            verWeights.data(), verWeights.size(),
+                            horWeights.data(), horWeights.size());
+        return horWeights;
+    }
+};
+
+TEST_F(Test_MegaLCSTuning, Test_TuneIsPersistedAndLoaded) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    auto tuning = Mega::MegaLCS_Tune(platformId, deviceId, 1024);
+    EXPECT_TRUE(tuning.step == 32 || tuning.step == 64 || tuning.step == 128 || tuning.step == 256);
+    EXPECT_GT(tuning.cellsPerSecond, 0);
+    ASSERT_EQ(TuningFiles().size(), 1u);
+
+    // 调优结果立即应用到默认引擎
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    EXPECT_EQ(engine->GetSubmitMode(), tuning.submitMode);
+    EXPECT_EQ(engine->GetKernelVariant(), tuning.kernelVariant);
+
+    // 重新设置目录清空进程内的结果，这次从磁盘读取
+    Mega::SetTuningDir(tuningDir.string());
+    MegaLCSTuning loaded;
+    ASSERT_TRUE(Mega::LoadTuning(platformId, deviceId, loaded));
+    EXPECT_EQ(loaded.step, tuning.step);
+    EXPECT_EQ(loaded.threadPerBlock, tuning.threadPerBlock);
+    EXPECT_EQ(loaded.submitMode, tuning.submitMode);
+    EXPECT_EQ(loaded.kernelVariant, tuning.kernelVariant);
+    EXPECT_GT(loaded.cellsPerSecond, 0);
+
+    // MegaLCSLen使用调优的step，Fusion按调优的参数计算，结果都不变
+    mt19937 rand(25);
+    auto baseVals = RandomVals(rand, 1500, 8);
+    auto latestVals = RandomVals(rand, 1100, 8);
+    EXPECT_EQ(Mega::MegaLCSLen(baseVals, latestVals), ExpectHors(baseVals, latestVals).back());
+
+    baseVals = RandomVals(rand, tuning.step * 6, 8);
+    latestVals = RandomVals(rand, tuning.step * 5, 8);
+    auto result = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, tuning.step);
+    EXPECT_FALSE(get<0>(result));
+    EXPECT_EQ(get<2>(result), ExpectHors(baseVals, latestVals));
+}
+
+// 直接指定线程粗化内核，Fusion在step相同、长度是step的倍数时使用它
+TEST_F(Test_MegaLCSTuning, Test_SaveTuning) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    MegaLCSTuning tuning;
+    tuning.step = 64;
+    tuning.threadPerBlock = 16;
+    tuning.submitMode = MegaLCSSubmitMode::FinishPerBand;
+    tuning.kernelVariant = MegaLCSKernelVariant::Compact;
+    Mega::SaveTuning(platformId, deviceId, tuning);
+    ASSERT_EQ(TuningFiles().size(), 1u);
+
+    Mega::SetTuningDir(tuningDir.string());
+    MegaLCSTuning loaded;
+    ASSERT_TRUE(Mega::LoadTuning(platformId, deviceId, loaded));
+    EXPECT_EQ(loaded.step, 64);
+    EXPECT_EQ(loaded.threadPerBlock, 16);
+    EXPECT_EQ(loaded.submitMode, MegaLCSSubmitMode::FinishPerBand);
+    EXPECT_EQ(loaded.kernelVariant, MegaLCSKernelVariant::Compact);
+
+    mt19937 rand(64);
+    vector<pair<int, int>> sizes = {{64 * 9, 64 * 7}, {64 * 9 + 5, 64 * 7}};
+    for (auto &size: sizes) {
+        auto baseVals = RandomVals(rand, size.first, 8);
+        auto latestVals = RandomVals(rand, size.second, 8);
+        auto result = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, 64);
+        EXPECT_FALSE(get<0>(result));
+        EXPECT_EQ(get<2>(result), ExpectHors(baseVals, latestVals));
+    }
+
+    // 打开CPU同时计算时仍然优先使用调优的线程粗化内核
+    auto engine = MegaLCSEngine::GetDefault(platformId, deviceId);
+    engine->SetCpuCoExecution(true);
+    auto baseVals = RandomVals(rand, 64 * 8, 8);
+    auto latestVals = RandomVals(rand, 64 * 6, 8);
+    auto result = Mega::MegaLCS_Fusion(platformId, deviceId, baseVals, latestVals, 64);
+    engine->SetCpuCoExecution(false);
+    EXPECT_FALSE(get<0>(result));
+    EXPECT_EQ(get<2>(result), ExpectHors(baseVals, latestVals));
+
+    tuning.threadPerBlock = 48;
+    EXPECT_THROW(Mega::SaveTuning(platformId, deviceId, tuning), runtime_error);
+    tuning.threadPerBlock = 0;
+    tuning.kernelVariant = MegaLCSKernelVariant::BitParallel;
+    EXPECT_THROW(Mega::SaveTuning(platformId, deviceId, tuning), runtime_error);
+}
+
+TEST_F(Test_MegaLCSTuning, Test_MismatchedOrCorruptFileIsIgnored) {
+    if (platformId == nullptr || deviceId == nullptr) {
+        GTEST_SKIP() << "No GPU device found";
+    }
+
+    Mega::SaveTuning(platformId, deviceId, MegaLCSTuning());
+    auto files = TuningFiles();
+    ASSERT_EQ(files.size(), 1u);
+
+    string key;
+    {
+        ifstream in(files[0]);
+        getline(in, key);
+    }
+
+    // 驱动版本不同
+    {
+        ofstream out(files[0], ios::trunc);
+        out << key << ".1\nstep=64\n";
+    }
+    Mega::SetTuningDir(tuningDir.string());
+    MegaLCSTuning tuning;
+    EXPECT_FALSE(Mega::LoadTuning(platformId, deviceId, tuning));
+
+    // step超出范围
+    {
+        ofstream out(files[0], ios::trunc);
+        out << key << "\nstep=999\n";
+    }
+    Mega::SetTuningDir(tuningDir.string());
+    EXPECT_FALSE(Mega::LoadTuning(platformId, deviceId, tuning));
+
+    // 没有写出的字段使用默认值
+    {
+        ofstream out(files[0], ios::trunc);
+        out << key << "\nstep=64\nsubmitMode=FinishPerBand\n";
+    }
+    Mega::SetTuningDir(tuningDir.string());
+    ASSERT_TRUE(Mega::LoadTuning(platformId, deviceId, tuning));
+    EXPECT_EQ(tuning.step, 64);
+    EXPECT_EQ(tuning.threadPerBlock, 0);
+    EXPECT_EQ(tuning.submitMode, MegaLCSSubmitMode::FinishPerBand);
+    EXPECT_EQ(tuning.kernelVariant, MegaLCSKernelVariant::Shared);
+}
+
+TEST_F(Test_MegaLCSTuning, Test_NoTuning) {
+    MegaLCSTuning tuning;
+    EXPECT_FALSE(Mega::LoadTuning(nullptr, nullptr, tuning));
+
+    if (platformId != nullptr && deviceId != nullptr) {
+        EXPECT_FALSE(Mega::LoadTuning(platformId, deviceId, tuning));
+    }
+
+    // 没有调优结果时MegaLCSLen仍然使用默认的step
+    mt19937 rand(26);
+    auto baseVals = RandomVals(rand, 700, 8);
+    auto latestVals = RandomVals(rand, 900, 8);
+    EXPECT_EQ(Mega::MegaLCSLen(baseVals, latestVals), ExpectHors(baseVals, latestVals).back());
+}
+
+TEST_F(Test_MegaLCSTuning, Test_Invalid) {
+    EXPECT_THROW(Mega::MegaLCS_Tune(platformId, deviceId, 1000), runtime_error);
+    EXPECT_THROW(Mega::MegaLCS_Tune(platformId, deviceId, 0), runtime_error);
+    EXPECT_THROW(Mega::MegaLCS_Tune(nullptr, nullptr, 1024), runtime_error);
+}
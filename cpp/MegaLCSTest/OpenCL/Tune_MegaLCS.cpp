@@ -0,0 +1,43 @@
+// MegaLCSTune.cpp
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include "Mega.h"
+
+using namespace std;
+
+/*
+MegaLCS Autotuner
+=================
+
+对每个OpenCL设备运行Mega::MegaLCS_Tune，结果写入调优目录（MEGALCS_TUNING_DIR，默认<temp>/MegaLCS/tuning）
+之后同一台机器上的MegaLCSLen、MegaLCS_Fusion和默认引擎自动使用，设备名或驱动版本变化时需要重新运行
+用法：MegaLCSTune [size]，size是方形合成数据的边长，必须是1024的倍数，默认4096
+*/
+int main(int argc, char *argv[]) {
+    int size = argc > 1 ? atoi(argv[1]) : 4096;
+
+    cout << "MegaLCS Autotuner" << endl;
+    cout << "=================" << endl;
+    cout << "Tuning dir: " << Mega::GetTuningDir() << endl;
+
+    for (const auto &device: Mega::GetAllDevices()) {
+        cout << "\nDevice: " << get<2>(device) << endl;
+
+        try {
+            auto tuning = Mega::MegaLCS_Tune(get<0>(device), get<1>(device), size);
+            cout << "  step: " << tuning.step << endl;
+            cout << "  threadPerBlock: " << tuning.threadPerBlock << endl;
+            cout << "  submitMode: "
+                 << (tuning.submitMode == MegaLCSSubmitMode::Pipelined ? "Pipelined" : "FinishPerBand") << endl;
+            cout << "  kernelVariant: "
+                 << (tuning.kernelVariant == MegaLCSKernelVariant::Persistent ? "Persistent" :
+                     tuning.kernelVariant == MegaLCSKernelVariant::Compact ? "Compact" : "Shared") << endl;
+            cout << "  Throughput: " << tuning.cellsPerSecond / 1e9 << " Gcells/s" << endl;
+        } catch (const exception &e) {
+            cout << "  Failed: " << e.what() << endl;
+        }
+    }
+
+    return 0;
+}